@@ -38,6 +38,9 @@ using namespace ns3;
 NS_LOG_COMPONENT_DEFINE ("manet-routing-compare");
 
 void DepletionDetected (void);
+void ParentChanged (Ipv4Address previous, Ipv4Address parent);
+void UplinkOutage (Time outage);
+void ControlTx (uint32_t packets);
 class RoutingExperiment
 {
 public:
@@ -80,6 +83,8 @@ double m_CLIENTstopTime = m_totalTime-2;// Stop time of client application insta
 std::string m_rate ("10000Mbps");	//
 std::string m_phyMode ("DsssRate11Mbps");//
 double  m_txp = 7.5;			//
+bool m_powerControl = false;		// Lower the transmit power to the SNR margin of the links, from m_txp (compare the network life time and the PDR)
+bool m_sinkLoadBalancing = false;	// Spread the nodes across the sinks by their advertised load (with several sinks)
 
 //--------Energy parameters----------------------------------
 
@@ -87,6 +92,11 @@ double m_initEnergy = 200000;		// Initial energy of node batery, 200000=>unlimit
 double m_remainingEnergy = 0;		// The ramining energy in all nodes
 bool m_depletionDetected=false;		// When the first battery deplition is detected this variable is set to true 
 Time m_lifeTime = Seconds(9999999);	// Big value (unlimited)
+uint32_t m_parentChanges = 0;		// Number of parent changes in the network (route churn)
+uint32_t m_parentLosses = 0;		// Number of parents lost in the network
+Time m_uplinkOutage = Seconds (0);	// Total time the nodes stayed without a route to the sink after losing their parent
+uint32_t m_controlTxEvents = 0;		// Number of send events of control packets (compare with and without ControlTxBatching)
+uint32_t m_controlTxPackets = 0;	// Number of control packets sent from these events
 
 void
 DepletionDetected ()			// a function to detect the time of the first battery deplition
@@ -98,6 +108,29 @@ DepletionDetected ()			// a function to detect the time of the first battery dep
     }
 }
 
+void
+ParentChanged (Ipv4Address previous, Ipv4Address parent)	// a function to count the parent changes (the first parent of a node is not counted)
+{
+  if (previous != Ipv4Address ())
+    {
+      m_parentChanges++;
+    }
+}
+
+void
+UplinkOutage (Time outage)			// a function to sum the time without a route to the sink after each parent loss
+{
+  m_parentLosses++;
+  m_uplinkOutage += outage;
+}
+
+void
+ControlTx (uint32_t packets)			// a function to count the send events of control packets and the packets they send
+{
+  m_controlTxEvents++;
+  m_controlTxPackets += packets;
+}
+
 RoutingExperiment::RoutingExperiment ()
 {
 }
@@ -242,6 +275,9 @@ RoutingExperiment::Run ()
 
   //Configure nodes (their type, their functioning mode etc) and install the internet stack
   Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::Routingmode", UintegerValue (m_mode));
+  Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::EnablePowerControl", BooleanValue (m_powerControl));
+  Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::SinkLoadBalancing", BooleanValue (m_sinkLoadBalancing));
+  Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::MaxTxPower", DoubleValue (m_txp));
   Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::SinkGateWayAddress", Ipv4AddressValue ("10.1.0.1"));                 // The Ip address is temporary, it will be assigned later
   Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::SinkOutPutDevice", PointerValue (NeDevSinkOutContainer.Get(0)));
   Config::SetDefault  ("ns3::dmsrp::RoutingProtocol::ServerAddress", Ipv4AddressValue ("10.1.0.1"));                      // The Ip address is temporary, it will be assigned later
@@ -356,6 +392,12 @@ RoutingExperiment::Run ()
 
   // When a source battery depletion is detected the function DepletionDetected is called (can be used to calculate the network lifetime)
   Config::ConnectWithoutContext ("/NodeList/*/$ns3::dmsrp::RoutingProtocol/DepTime", MakeCallback(&DepletionDetected));
+  // Count the parent changes of the nodes (route churn)
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::dmsrp::RoutingProtocol/ParentChange", MakeCallback(&ParentChanged));
+  // Measure the uplink outages after the parent losses (compare with and without EnableBackupParent)
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::dmsrp::RoutingProtocol/UplinkOutage", MakeCallback(&UplinkOutage));
+  // Count the send events of the control packets (compare with and without ControlTxBatching)
+  Config::ConnectWithoutContext ("/NodeList/*/$ns3::dmsrp::RoutingProtocol/ControlTx", MakeCallback(&ControlTx));
 
   // Define the simulation time and run it
   Simulator::Stop (Seconds (m_totalTime));
@@ -371,6 +413,25 @@ RoutingExperiment::Run ()
 
   NS_LOG_UNCOND("Total remainig energy is: "<<m_remainingEnergy);
   NS_LOG_UNCOND("Network life time is: "<<m_lifeTime);
+  NS_LOG_UNCOND("Parent changes: "<<m_parentChanges);
+  NS_LOG_UNCOND("Parent losses: "<<m_parentLosses);
+  if (m_parentLosses > 0)
+    {
+      NS_LOG_UNCOND("Mean uplink outage per parent loss: "<<m_uplinkOutage.GetSeconds () / m_parentLosses<<" s");
+    }
+  NS_LOG_UNCOND("Control packets sent: "<<m_controlTxPackets<<" from "<<m_controlTxEvents<<" send events");
+
+  // Calculate the packet delivery ratio of all the flows
+  uint64_t txPackets = 0;
+  uint64_t rxPackets = 0;
+  flowmon->CheckForLostPackets ();
+  std::map<FlowId, FlowMonitor::FlowStats> stats = flowmon->GetFlowStats ();
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i)
+    {
+      txPackets += i->second.txPackets;
+      rxPackets += i->second.rxPackets;
+    }
+  NS_LOG_UNCOND("Packet delivery ratio: "<<(txPackets > 0 ? (double) rxPackets / txPackets : 0));
   //Output of the trace file of the flowmonitor 
   flowmon->SerializeToXmlFile ((m_fileFlowMonName + ".xml").c_str(), false, false);
 
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-advertise-filter.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpAdvertiseFilter");
+
+namespace dmsrp {
+
+AdvertiseFilter::AdvertiseFilter ()
+  : m_refresh (Seconds (0))
+{
+}
+
+bool
+AdvertiseFilter::IsNeeded (AdvertiseHeader const & advertiseHeader)
+{
+  Ipv4Address origin = advertiseHeader.GetOrigin ();
+  std::map<Ipv4Address, Forwarded>::iterator i = m_forwarded.find (origin);
+  if (i != m_forwarded.end ())
+    {
+      bool suppressed = false;
+      if (advertiseHeader.GetOriginSeqno () <= i->second.m_seqNo)
+        {
+          // already forwarded, it came through another path
+          suppressed = true;
+        }
+      else if (advertiseHeader.GetHopCount () == i->second.m_hops
+               && advertiseHeader.GetReport ().HasSameLinks (i->second.m_report)
+               && Simulator::Now () - i->second.m_time < m_refresh)
+        {
+          suppressed = true;
+        }
+      if (suppressed)
+        {
+          NS_LOG_LOGIC ("Advertise of " << origin << " seqno " << advertiseHeader.GetOriginSeqno ()
+                        << " already known by the server");
+          if (!m_suppress.IsNull ())
+            {
+              m_suppress (origin, advertiseHeader.GetOriginSeqno ());
+            }
+          return false;
+        }
+    }
+  Forwarded forwarded;
+  forwarded.m_seqNo = advertiseHeader.GetOriginSeqno ();
+  forwarded.m_hops = advertiseHeader.GetHopCount ();
+  forwarded.m_report = advertiseHeader.GetReport ();
+  forwarded.m_time = Simulator::Now ();
+  m_forwarded[origin] = forwarded;
+  return true;
+}
+
+void
+AdvertiseFilter::Forget (Ipv4Address origin)
+{
+  m_forwarded.erase (origin);
+}
+
+void
+AdvertiseFilter::Clear ()
+{
+  m_forwarded.clear ();
+}
+
+void
+AdvertiseFilter::Purge (Time timeout)
+{
+  for (std::map<Ipv4Address, Forwarded>::iterator i = m_forwarded.begin (); i != m_forwarded.end (); )
+    {
+      if (Simulator::Now () - i->second.m_time > timeout)
+        {
+          m_forwarded.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPADVERTISEFILTER_H
+#define DMSRPADVERTISEFILTER_H
+
+#include "dmsrp-packet.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/callback.h"
+#include <map>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Advertises a sink already forwarded to the server
+ *
+ * A sink hears the advertise of an origin over each path of its tree, but
+ * forwards only the first copy of a sequence number. A newer advertise is
+ * forwarded when its hop count or its topology report changed; an unchanged
+ * one is held back until the refresh period has run out since the last one
+ * forwarded, so the server keeps the route without a message per period.
+ */
+class AdvertiseFilter
+{
+public:
+  /// Callback called with the origin and the sequence number of a suppressed advertise
+  typedef Callback<void, Ipv4Address, uint32_t> SuppressCallback;
+
+  /// constructor
+  AdvertiseFilter ();
+
+  /**
+   * \param refresh the period after which an unchanged advertise is forwarded again (0: always)
+   */
+  void SetRefresh (Time refresh)
+  {
+    m_refresh = refresh;
+  }
+  /**
+   * \param cb the callback called for each suppressed advertise
+   */
+  void SetSuppressCallback (SuppressCallback cb)
+  {
+    m_suppress = cb;
+  }
+  /**
+   * Record the advertise if it must be forwarded
+   * \param advertiseHeader the advertise heard by the sink
+   * \returns true if the advertise must be forwarded to the server
+   */
+  bool IsNeeded (AdvertiseHeader const & advertiseHeader);
+  /**
+   * Forget the last advertise of an origin, so that the next one is forwarded
+   * \param origin the origin
+   */
+  void Forget (Ipv4Address origin);
+  /// Forget all the origins
+  void Clear ();
+  /**
+   * Forget the origins whose last advertise was forwarded too long ago
+   * \param timeout the age after which an origin is forgotten
+   */
+  void Purge (Time timeout);
+  /**
+   * \returns the number of origins known
+   */
+  uint32_t GetSize () const
+  {
+    return m_forwarded.size ();
+  }
+
+private:
+  /// Last advertise of an origin forwarded to the server
+  struct Forwarded
+  {
+    uint32_t m_seqNo;                   ///< sequence number
+    uint8_t m_hops;                     ///< hop count
+    TopologyReport m_report;            ///< topology report
+    Time m_time;                        ///< forwarding time
+  };
+  /// origin -> last advertise forwarded
+  std::map<Ipv4Address, Forwarded> m_forwarded;
+  Time m_refresh;                       ///< period after which an unchanged advertise is forwarded again
+  SuppressCallback m_suppress;          ///< suppressed advertise callback
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPADVERTISEFILTER_H */
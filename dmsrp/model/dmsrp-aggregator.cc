@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-aggregator.h"
+#include "dmsrp-packet.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpAggregator");
+
+namespace dmsrp {
+
+Aggregator::Aggregator ()
+  : m_window (MilliSeconds (20)),
+    m_maxSize (1024),
+    m_maxPacketSize (256),
+    m_protocol (0)
+{
+}
+
+Aggregator::~Aggregator ()
+{
+  Clear ();
+}
+
+bool
+Aggregator::Enqueue (Ptr<Ipv4Route> route, Ptr<Packet> packet, Ipv4Header const & header,
+                     Ipv4RoutingProtocol::UnicastForwardCallback ucb)
+{
+  NS_LOG_FUNCTION (this << route->GetGateway () << header.GetDestination () << packet->GetUid ());
+  uint32_t overhead = TypeHeader ().GetSerializedSize () + ContainerHeader ().GetSerializedSize ();
+  uint32_t size = packet->GetSize () + header.GetSerializedSize ();
+  if (size > m_maxPacketSize || overhead + size > m_maxSize)
+    {
+      return false;
+    }
+  Key key (route->GetGateway (), header.GetDestination ());
+  std::map<Key, Batch>::iterator i = m_batches.find (key);
+  if (i != m_batches.end ()
+      && (i->second.m_bytes + size > m_maxSize || i->second.m_items.size () == ContainerHeader::MAX_COUNT))
+    {
+      // the container is full
+      Send (key);
+      i = m_batches.end ();
+    }
+  if (i == m_batches.end ())
+    {
+      i = m_batches.insert (std::make_pair (key, Batch ())).first;
+      i->second.m_bytes = overhead;
+      i->second.m_sendEvent = Simulator::Schedule (m_window, &Aggregator::Send, this, key);
+    }
+  Item item;
+  item.m_packet = packet;
+  item.m_header = header;
+  i->second.m_route = route;
+  i->second.m_ucb = ucb;
+  i->second.m_items.push_back (item);
+  i->second.m_bytes += size;
+  return true;
+}
+
+void
+Aggregator::Send (Key key)
+{
+  std::map<Key, Batch>::iterator i = m_batches.find (key);
+  if (i == m_batches.end ())
+    {
+      return;
+    }
+  Batch batch = i->second;
+  m_batches.erase (i);
+  batch.m_sendEvent.Cancel ();
+  NS_LOG_LOGIC ("Send " << batch.m_items.size () << " packets to " << key.second << " through " << key.first);
+  if (batch.m_items.size () == 1)
+    {
+      batch.m_ucb (batch.m_route, batch.m_items.front ().m_packet, batch.m_items.front ().m_header);
+    }
+  else
+    {
+      Ptr<Packet> container = Pack (batch.m_items);
+      uint8_t ttl = batch.m_items.front ().m_header.GetTtl ();
+      for (std::vector<Item>::const_iterator j = batch.m_items.begin (); j != batch.m_items.end (); ++j)
+        {
+          ttl = std::min (ttl, j->m_header.GetTtl ());
+        }
+      Ipv4Header header;
+      header.SetSource (batch.m_route->GetSource ());
+      header.SetDestination (key.second);
+      header.SetProtocol (m_protocol);
+      header.SetTtl (ttl);
+      header.SetPayloadSize (container->GetSize ());
+      batch.m_ucb (batch.m_route, container, header);
+    }
+  if (!m_sendCallback.IsNull ())
+    {
+      m_sendCallback (batch.m_items.size ());
+    }
+}
+
+void
+Aggregator::Flush ()
+{
+  while (!m_batches.empty ())
+    {
+      Send (m_batches.begin ()->first);
+    }
+}
+
+void
+Aggregator::Clear ()
+{
+  for (std::map<Key, Batch>::iterator i = m_batches.begin (); i != m_batches.end (); ++i)
+    {
+      i->second.m_sendEvent.Cancel ();
+    }
+  m_batches.clear ();
+}
+
+uint32_t
+Aggregator::GetSize () const
+{
+  uint32_t size = 0;
+  for (std::map<Key, Batch>::const_iterator i = m_batches.begin (); i != m_batches.end (); ++i)
+    {
+      size += i->second.m_items.size ();
+    }
+  return size;
+}
+
+Ptr<Packet>
+Aggregator::Pack (std::vector<Item> const & items)
+{
+  Ptr<Packet> container = Create<Packet> ();
+  for (std::vector<Item>::const_iterator i = items.begin (); i != items.end (); ++i)
+    {
+      Ptr<Packet> entry = i->m_packet->Copy ();
+      Ipv4Header header = i->m_header;
+      header.SetPayloadSize (entry->GetSize ());
+      entry->AddHeader (header);
+      container->AddAtEnd (entry);
+    }
+  container->AddHeader (ContainerHeader (items.size ()));
+  container->AddHeader (TypeHeader (DMSRPTYPE_CONTAINER));
+  return container;
+}
+
+bool
+Aggregator::Unpack (Ptr<const Packet> container, uint8_t ttl, std::vector<Item> & items)
+{
+  Ptr<Packet> packet = container->Copy ();
+  TypeHeader tHeader (DMSRPTYPE_CONTAINER);
+  ContainerHeader containerHeader;
+  if (packet->GetSize () < tHeader.GetSerializedSize () + containerHeader.GetSerializedSize ())
+    {
+      return false;
+    }
+  packet->RemoveHeader (tHeader);
+  if (!tHeader.IsValid () || tHeader.Get () != DMSRPTYPE_CONTAINER)
+    {
+      return false;
+    }
+  packet->RemoveHeader (containerHeader);
+  for (uint8_t n = 0; n < containerHeader.GetCount (); ++n)
+    {
+      Item item;
+      if (packet->GetSize () < item.m_header.GetSerializedSize ())
+        {
+          return false;
+        }
+      packet->RemoveHeader (item.m_header);
+      uint32_t size = item.m_header.GetPayloadSize ();
+      if (size > packet->GetSize ())
+        {
+          return false;
+        }
+      item.m_header.SetTtl (std::min (item.m_header.GetTtl (), ttl));
+      item.m_packet = packet->CreateFragment (0, size);
+      packet->RemoveAtStart (size);
+      items.push_back (item);
+    }
+  return packet->GetSize () == 0;
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPAGGREGATOR_H
+#define DMSRPAGGREGATOR_H
+
+#include "ns3/simulator.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/packet.h"
+#include "ns3/callback.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Batches of small uplink packets sent as one container
+ *
+ * The packets going to the same next hop and destination are held for a window,
+ * then sent in one container: the DMSRP type, a CONTAINER header, and each packet
+ * with its own IP header. A batch also leaves as soon as the next packet would not
+ * fit in the container. A batch of one packet is sent as is. The receiver of a
+ * container takes the packets out and routes them one by one. A container gets
+ * the lowest TTL of its packets, so that a packet batched again at every hop
+ * still dies in a loop.
+ */
+class Aggregator
+{
+public:
+  /// A packet of a container
+  struct Item
+  {
+    Ptr<Packet> m_packet;      ///< packet, without its IP header
+    Ipv4Header m_header;       ///< IP header
+  };
+
+  /// constructor
+  Aggregator ();
+  /// destructor
+  ~Aggregator ();
+
+  /**
+   * Hold a packet until its batch leaves
+   * \param route the route to the next hop
+   * \param packet the packet
+   * \param header the IP header of the packet
+   * \param ucb the forward callback
+   * \returns false if the packet is too large to be held: send it at once
+   */
+  bool Enqueue (Ptr<Ipv4Route> route, Ptr<Packet> packet, Ipv4Header const & header,
+                Ipv4RoutingProtocol::UnicastForwardCallback ucb);
+  /// Send every batch now
+  void Flush ();
+  /// Drop every batch without sending it
+  void Clear ();
+  /**
+   * \returns the number of packets held
+   */
+  uint32_t GetSize () const;
+  /// \param window how long the first packet of a batch waits for the others
+  void SetWindow (Time window)
+  {
+    m_window = window;
+  }
+  /// \param maxSize the maximum size of a container, its DMSRP headers included
+  void SetMaxSize (uint32_t maxSize)
+  {
+    m_maxSize = maxSize;
+  }
+  /// \param maxPacketSize the largest packet, IP header included, that is held
+  void SetMaxPacketSize (uint32_t maxPacketSize)
+  {
+    m_maxPacketSize = maxPacketSize;
+  }
+  /// \param protocol the IP protocol number of the containers
+  void SetProtocol (uint8_t protocol)
+  {
+    m_protocol = protocol;
+  }
+  /**
+   * Callback called for each batch sent, with its number of packets
+   * \param cb the callback
+   */
+  void SetSendCallback (Callback<void, uint32_t> cb)
+  {
+    m_sendCallback = cb;
+  }
+
+  /**
+   * Build a container
+   * \param items the packets
+   * \returns the payload of the container, DMSRP type included
+   */
+  static Ptr<Packet> Pack (std::vector<Item> const & items);
+  /**
+   * Take the packets out of a container. The hops of the container count for
+   * its packets: none of them keeps a TTL above the one of the container.
+   * \param container the payload of the container, DMSRP type included
+   * \param ttl the TTL the container was received with
+   * \param items the packets
+   * \returns false if the container is malformed
+   */
+  static bool Unpack (Ptr<const Packet> container, uint8_t ttl, std::vector<Item> & items);
+
+private:
+  /// Next hop and destination of a batch
+  typedef std::pair<Ipv4Address, Ipv4Address> Key;
+  /// Packets held for the same next hop and destination
+  struct Batch
+  {
+    Ptr<Ipv4Route> m_route;                                   ///< route to the next hop
+    Ipv4RoutingProtocol::UnicastForwardCallback m_ucb;        ///< forward callback
+    std::vector<Item> m_items;                                ///< packets
+    uint32_t m_bytes;                                         ///< size of the container
+    EventId m_sendEvent;                                      ///< end of the window
+  };
+
+  /**
+   * Send a batch and forget it
+   * \param key the next hop and destination of the batch
+   */
+  void Send (Key key);
+
+  std::map<Key, Batch> m_batches;       ///< batches being filled
+  Time m_window;                        ///< holding time of the first packet of a batch
+  uint32_t m_maxSize;                   ///< maximum size of a container
+  uint32_t m_maxPacketSize;             ///< largest packet held
+  uint8_t m_protocol;                   ///< IP protocol number of the containers
+  Callback<void, uint32_t> m_sendCallback;  ///< send callback
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPAGGREGATOR_H */
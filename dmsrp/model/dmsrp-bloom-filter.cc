@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-bloom-filter.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpBloomFilter");
+
+namespace dmsrp {
+
+/*
+ The CountingBloomFilter
+ */
+
+CountingBloomFilter::CountingBloomFilter (uint32_t cells, uint32_t hashes)
+  : m_cells (cells > 0 ? cells : 1, 0),
+    m_hashes (hashes > 0 ? hashes : 1),
+    m_count (0)
+{
+}
+
+uint32_t
+CountingBloomFilter::Cell (Ipv4Address a, uint32_t i) const
+{
+  // double hashing: h1 + i * h2, with two integer mixes of the address
+  uint32_t h1 = a.Get () * 2654435761u;
+  h1 ^= h1 >> 16;
+  uint32_t h2 = (a.Get () ^ 0x5bd1e995) * 0x27d4eb2d;
+  h2 ^= h2 >> 15;
+  h2 |= 1;
+  return (h1 + i * h2) % m_cells.size ();
+}
+
+void
+CountingBloomFilter::Add (Ipv4Address a)
+{
+  for (uint32_t i = 0; i < m_hashes; ++i)
+    {
+      uint8_t & c = m_cells[Cell (a, i)];
+      if (c < 255)
+        {
+          c++;
+        }
+    }
+  m_count++;
+}
+
+void
+CountingBloomFilter::Remove (Ipv4Address a)
+{
+  if (!Contains (a))
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < m_hashes; ++i)
+    {
+      uint8_t & c = m_cells[Cell (a, i)];
+      if (c < 255)
+        {
+          c--;
+        }
+    }
+  if (m_count > 0)
+    {
+      m_count--;
+    }
+}
+
+bool
+CountingBloomFilter::Contains (Ipv4Address a) const
+{
+  for (uint32_t i = 0; i < m_hashes; ++i)
+    {
+      if (m_cells[Cell (a, i)] == 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+CountingBloomFilter::Clear ()
+{
+  std::fill (m_cells.begin (), m_cells.end (), 0);
+  m_count = 0;
+}
+
+void
+CountingBloomFilter::GetBits (std::vector<uint8_t> & bits) const
+{
+  bits.assign ((m_cells.size () + 7) / 8, 0);
+  for (uint32_t c = 0; c < m_cells.size (); ++c)
+    {
+      if (m_cells[c] != 0)
+        {
+          bits[c / 8] |= 1 << (7 - c % 8);
+        }
+    }
+}
+
+void
+CountingBloomFilter::SetBits (std::vector<uint8_t> const & bits)
+{
+  Clear ();
+  for (uint32_t c = 0; c < m_cells.size () && c / 8 < bits.size (); ++c)
+    {
+      if (bits[c / 8] & (1 << (7 - c % 8)))
+        {
+          m_cells[c] = 1;
+          // the number of addresses is unknown, only the emptiness matters
+          m_count = 1;
+        }
+    }
+}
+
+/*
+ The DescendantFilters
+ */
+
+DescendantFilters::DescendantFilters (Time generation)
+  : m_generation (generation),
+    m_nextGeneration (Simulator::Now () + generation),
+    m_cells (256),
+    m_hashes (3)
+{
+}
+
+void
+DescendantFilters::Update (Ipv4Address child, Ipv4InterfaceAddress iface, Ipv4Address dst)
+{
+  NS_LOG_FUNCTION (this << child << dst);
+  Purge ();
+  std::map<Ipv4Address, Child>::iterator i = m_children.find (child);
+  if (i == m_children.end ())
+    {
+      Child c;
+      c.m_iface = iface;
+      c.m_current = CountingBloomFilter (m_cells, m_hashes);
+      c.m_previous = CountingBloomFilter (m_cells, m_hashes);
+      i = m_children.insert (std::make_pair (child, c)).first;
+    }
+  i->second.m_iface = iface;
+  if (!i->second.m_current.Contains (dst))
+    {
+      i->second.m_current.Add (dst);
+    }
+  // the destination moved: the old child no longer holds it
+  for (std::map<Ipv4Address, Child>::iterator j = m_children.begin (); j != m_children.end (); ++j)
+    {
+      if (j != i)
+        {
+          j->second.m_current.Remove (dst);
+        }
+    }
+}
+
+uint32_t
+DescendantFilters::Lookup (Ipv4Address dst, Ipv4Address & child, Ipv4InterfaceAddress & iface, Ipv4Address exclude)
+{
+  NS_LOG_FUNCTION (this << dst);
+  Purge ();
+  uint32_t matches = 0;
+  bool current = false;
+  for (std::map<Ipv4Address, Child>::const_iterator i = m_children.begin (); i != m_children.end (); ++i)
+    {
+      if (i->first == exclude)
+        {
+          continue;
+        }
+      bool inCurrent = i->second.m_current.Contains (dst);
+      if (!inCurrent && !i->second.m_previous.Contains (dst))
+        {
+          continue;
+        }
+      if (matches == 0 || (inCurrent && !current))
+        {
+          child = i->first;
+          iface = i->second.m_iface;
+          current = inCurrent;
+        }
+      matches++;
+    }
+  return matches;
+}
+
+void
+DescendantFilters::DeleteChild (Ipv4Address child)
+{
+  NS_LOG_FUNCTION (this << child);
+  m_children.erase (child);
+}
+
+void
+DescendantFilters::DeleteAllChildrenFromInterface (Ipv4InterfaceAddress iface)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<Ipv4Address, Child>::iterator i = m_children.begin (); i != m_children.end (); )
+    {
+      if (i->second.m_iface == iface)
+        {
+          m_children.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+DescendantFilters::Purge ()
+{
+  if (Simulator::Now () < m_nextGeneration)
+    {
+      return;
+    }
+  // more than two generations without a call: every filter is outdated
+  bool outdated = Simulator::Now () >= m_nextGeneration + m_generation;
+  for (std::map<Ipv4Address, Child>::iterator i = m_children.begin (); i != m_children.end (); )
+    {
+      if (outdated || i->second.m_current.IsEmpty ())
+        {
+          m_children.erase (i++);
+          continue;
+        }
+      i->second.m_previous = i->second.m_current;
+      i->second.m_current.Clear ();
+      ++i;
+    }
+  while (m_nextGeneration <= Simulator::Now ())
+    {
+      m_nextGeneration += m_generation;
+    }
+}
+
+void
+DescendantFilters::Clear ()
+{
+  m_children.clear ();
+  m_nextGeneration = Simulator::Now () + m_generation;
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPBLOOMFILTER_H
+#define DMSRPBLOOMFILTER_H
+
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-interface-address.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Counting Bloom filter of IPv4 addresses
+ *
+ * Each address sets k cells among m, chosen by double hashing. A cell counts the
+ * addresses that set it, so an address can be removed; a saturated cell is never
+ * decremented again. Membership answers may be false positives; removing an address
+ * that was only a false positive may in turn cause false negatives.
+ */
+class CountingBloomFilter
+{
+public:
+  /**
+   * constructor
+   * \param cells the number of cells (m)
+   * \param hashes the number of cells set by an address (k)
+   */
+  CountingBloomFilter (uint32_t cells = 256, uint32_t hashes = 3);
+
+  /// \param a the address to add
+  void Add (Ipv4Address a);
+  /**
+   * Remove an address; nothing is done if it is not in the filter
+   * \param a the address to remove
+   */
+  void Remove (Ipv4Address a);
+  /**
+   * \param a the address
+   * \returns true if the address may be in the filter
+   */
+  bool Contains (Ipv4Address a) const;
+  /**
+   * \returns true if no address was added since the last Clear
+   */
+  bool IsEmpty () const
+  {
+    return m_count == 0;
+  }
+  /// Remove every address
+  void Clear ();
+  /**
+   * \returns the number of cells
+   */
+  uint32_t GetCellCount () const
+  {
+    return m_cells.size ();
+  }
+  /**
+   * \returns the number of cells set by an address
+   */
+  uint32_t GetHashCount () const
+  {
+    return m_hashes;
+  }
+  /**
+   * Export the filter as a plain Bloom filter
+   * \param bits one bit per cell, set if the cell is not 0, the first cell in the high bit
+   */
+  void GetBits (std::vector<uint8_t> & bits) const;
+  /**
+   * Load a plain Bloom filter; the counters of the set cells are 1
+   * \param bits one bit per cell, the first cell in the high bit
+   */
+  void SetBits (std::vector<uint8_t> const & bits);
+
+private:
+  /**
+   * \param a the address
+   * \param i the hash index, below the number of hashes
+   * \returns the i-th cell of the address
+   */
+  uint32_t Cell (Ipv4Address a, uint32_t i) const;
+
+  std::vector<uint8_t> m_cells;     ///< counters
+  uint32_t m_hashes;                ///< cells set by an address
+  uint32_t m_count;                 ///< addresses in the filter
+};
+
+/**
+ * \ingroup dmsrp
+ * \brief Descendants of a relay summarized per child (Bloom downlink mode)
+ *
+ * For each child, the addresses learned from the advertises it forwarded go into
+ * a counting Bloom filter of fixed size, whatever the size of the subtree. The
+ * filters of a child come in two generations: the addresses are added to the
+ * current one, and every generation time the current one becomes the previous one
+ * and a new one starts. An address is thus forgotten between one and two generation
+ * times after its last advertise. When a destination moves to another child, it is
+ * removed from the current filter of the old one.
+ */
+class DescendantFilters
+{
+public:
+  /**
+   * constructor
+   * \param generation the generation time
+   */
+  DescendantFilters (Time generation = Seconds (6));
+
+  /**
+   * Record that a destination is reached through a child
+   * \param child the child address
+   * \param iface the interface the child is reached through
+   * \param dst the destination (the child itself included)
+   */
+  void Update (Ipv4Address child, Ipv4InterfaceAddress iface, Ipv4Address dst);
+  /**
+   * Look for the child a destination is reached through. The children that have it
+   * in their current filter come first.
+   * \param dst the destination
+   * \param child the child found
+   * \param iface the interface the child is reached through
+   * \param exclude a child not to select (the node the packet came from)
+   * \returns the number of children whose filters hold the destination (0: miss)
+   */
+  uint32_t Lookup (Ipv4Address dst, Ipv4Address & child, Ipv4InterfaceAddress & iface,
+                   Ipv4Address exclude = Ipv4Address ());
+  /// \param child the child to forget
+  void DeleteChild (Ipv4Address child);
+  /**
+   * Forget the children reached through an interface
+   * \param iface the interface
+   */
+  void DeleteAllChildrenFromInterface (Ipv4InterfaceAddress iface);
+  /// Start the new generations that are due, forget the children without any address
+  void Purge ();
+  /// Forget everything
+  void Clear ();
+  /**
+   * \returns the number of children
+   */
+  uint32_t GetChildCount ()
+  {
+    Purge ();
+    return m_children.size ();
+  }
+  /**
+   * Set the size of the filters, used for the children added from now on
+   * \param cells the number of cells
+   * \param hashes the number of cells set by an address
+   */
+  void SetFilterSize (uint32_t cells, uint32_t hashes)
+  {
+    m_cells = cells;
+    m_hashes = hashes;
+  }
+  /// \param t the generation time
+  void SetGenerationTime (Time t)
+  {
+    m_generation = t;
+  }
+
+private:
+  /// Filters of one child
+  struct Child
+  {
+    Ipv4InterfaceAddress m_iface;     ///< interface the child is reached through
+    CountingBloomFilter m_current;    ///< addresses advertised in this generation
+    CountingBloomFilter m_previous;   ///< addresses advertised in the previous one
+  };
+  /// Filters: child -> filters
+  std::map<Ipv4Address, Child> m_children;
+  Time m_generation;                  ///< generation time
+  Time m_nextGeneration;              ///< start of the next generation
+  uint32_t m_cells;                   ///< cells of a filter
+  uint32_t m_hashes;                  ///< cells set by an address
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPBLOOMFILTER_H */
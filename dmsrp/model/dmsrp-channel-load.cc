@@ -0,0 +1,74 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-channel-load.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpChannelLoad");
+
+namespace dmsrp {
+
+ChannelLoad::ChannelLoad ()
+  : m_sampleStart (Seconds (0)),
+    m_busy (Seconds (0)),
+    m_load (0),
+    m_alpha (0.3),
+    m_sampled (false)
+{
+  m_stateCallback = MakeCallback (&ChannelLoad::NotifyState, this);
+}
+
+void
+ChannelLoad::NotifyState (Time start, Time duration, WifiPhyState state)
+{
+  if (state != CCA_BUSY && state != TX && state != RX)
+    {
+      return;
+    }
+  // only the part of the period inside the current sample counts
+  Time begin = std::max (start, m_sampleStart);
+  Time end = start + duration;
+  if (end > begin)
+    {
+      m_busy += end - begin;
+    }
+}
+
+double
+ChannelLoad::Sample ()
+{
+  Time now = Simulator::Now ();
+  Time elapsed = now - m_sampleStart;
+  if (elapsed.IsStrictlyPositive ())
+    {
+      double busy = std::min (m_busy.GetSeconds () / elapsed.GetSeconds (), 1.0);
+      m_load = m_sampled ? m_alpha * busy + (1 - m_alpha) * m_load : busy;
+      m_sampled = true;
+      NS_LOG_LOGIC ("Busy " << busy << " load " << m_load);
+    }
+  m_sampleStart = now;
+  m_busy = Seconds (0);
+  return m_load;
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
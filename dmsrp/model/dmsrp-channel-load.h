@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPCHANNELLOAD_H
+#define DMSRPCHANNELLOAD_H
+
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/wifi-phy-state.h"
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Fraction of the time the channel is busy around a node
+ *
+ * Fed with the state changes of the WifiPhy, it adds up the time the PHY
+ * spends sensing the channel busy, receiving or transmitting. Each sample
+ * takes the busy fraction of the time elapsed since the previous one, and
+ * smooths it into the load with an exponentially weighted moving average.
+ */
+class ChannelLoad
+{
+public:
+  /// constructor
+  ChannelLoad ();
+
+  /**
+   * Take the busy fraction since the previous sample into the load
+   * \returns the load
+   */
+  double Sample ();
+  /**
+   * \returns the smoothed busy fraction, between 0 and 1
+   */
+  double GetLoad () const
+  {
+    return m_load;
+  }
+  /**
+   * \param alpha the weight of a new sample in the load
+   */
+  void SetSmoothing (double alpha)
+  {
+    m_alpha = alpha;
+  }
+  /**
+   * Record a period the PHY spent in a state
+   * \param start the start of the period
+   * \param duration its duration
+   * \param state the state
+   */
+  void NotifyState (Time start, Time duration, WifiPhyState state);
+  /// \returns the callback to connect to the State trace of the WifiPhy state helper
+  Callback<void, Time, Time, WifiPhyState> GetStateCallback () const
+  {
+    return m_stateCallback;
+  }
+
+private:
+  Time m_sampleStart;    ///< start of the current sample
+  Time m_busy;           ///< busy time in the current sample
+  double m_load;         ///< smoothed busy fraction
+  double m_alpha;        ///< weight of a new sample
+  bool m_sampled;        ///< a sample was taken already
+  Callback<void, Time, Time, WifiPhyState> m_stateCallback;  ///< state callback
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPCHANNELLOAD_H */
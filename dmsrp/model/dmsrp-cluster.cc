@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-cluster.h"
+#include "ns3/log.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpCluster");
+
+namespace dmsrp {
+
+ClusterTable::ClusterTable ()
+{
+}
+
+bool
+ClusterTable::Update (Ipv4Address head, uint32_t seqNo, CountingBloomFilter const & members,
+                      RoutingTableEntryDown const & toHead, Time lifetime)
+{
+  NS_LOG_FUNCTION (this << head << seqNo);
+  Purge ();
+  std::map<Ipv4Address, Cluster>::iterator i = m_clusters.find (head);
+  if (i != m_clusters.end ()
+      && (i->second.m_seqNo > seqNo || (i->second.m_seqNo == seqNo && i->second.m_hops <= toHead.GetHop ())))
+    {
+      return false;
+    }
+  Cluster c;
+  c.m_seqNo = seqNo;
+  c.m_members = members;
+  c.m_device = toHead.GetOutputDevice ();
+  c.m_iface = toHead.GetInterface ();
+  c.m_nextHop = toHead.GetNextHop ();
+  c.m_hops = toHead.GetHop ();
+  c.m_expire = Simulator::Now () + lifetime;
+  m_clusters[head] = c;
+  return true;
+}
+
+bool
+ClusterTable::Lookup (Ipv4Address dst, RoutingTableEntryDown & rt)
+{
+  NS_LOG_FUNCTION (this << dst);
+  Purge ();
+  std::map<Ipv4Address, Cluster>::const_iterator best = m_clusters.end ();
+  for (std::map<Ipv4Address, Cluster>::const_iterator i = m_clusters.begin (); i != m_clusters.end (); ++i)
+    {
+      if ((i->first == dst || i->second.m_members.Contains (dst))
+          && (best == m_clusters.end () || i->second.m_hops < best->second.m_hops))
+        {
+          best = i;
+        }
+    }
+  if (best == m_clusters.end ())
+    {
+      return false;
+    }
+  NS_LOG_LOGIC (dst << " in the cluster of " << best->first);
+  rt = RoutingTableEntryDown (/*device=*/ best->second.m_device, /*dst=*/ dst, /*seqNo=*/ best->second.m_seqNo,
+                              /*iface=*/ best->second.m_iface, /*hops=*/ best->second.m_hops,
+                              /*nextHop=*/ best->second.m_nextHop, /*timeLife=*/ best->second.m_expire - Simulator::Now ());
+  return true;
+}
+
+void
+ClusterTable::Purge ()
+{
+  for (std::map<Ipv4Address, Cluster>::iterator i = m_clusters.begin (); i != m_clusters.end (); )
+    {
+      if (i->second.m_expire < Simulator::Now ())
+        {
+          m_clusters.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPCLUSTER_H
+#define DMSRPCLUSTER_H
+
+#include "dmsrp-bloom-filter.h"
+#include "dmsrp-rtable.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include <map>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief The clusters below a node, learnt from the cluster advertises
+ *
+ * A cluster head keeps the down routes of its cluster and sends up a Bloom filter
+ * of its members instead of their advertises. Above it, one entry per cluster gives
+ * the filter and the way to the head (the child the summary came from, or the sink
+ * at the server). A destination without a down route of its own is looked up in
+ * the filters; among several matching clusters the closest head is chosen.
+ */
+class ClusterTable
+{
+public:
+  /// constructor
+  ClusterTable ();
+
+  /**
+   * Add or refresh a cluster
+   * \param head the cluster head
+   * \param seqNo the sequence number of the summary
+   * \param members the filter of the members
+   * \param toHead the way to the head: device, interface, next hop and hops
+   * \param lifetime how long the cluster is kept without refresh
+   * \returns false if a newer summary, or as new with fewer hops, is known
+   */
+  bool Update (Ipv4Address head, uint32_t seqNo, CountingBloomFilter const & members,
+               RoutingTableEntryDown const & toHead, Time lifetime);
+  /**
+   * Find the cluster of a destination
+   * \param dst the destination
+   * \param rt a route to dst through the way to the head of its cluster
+   * \returns false if no cluster may hold the destination
+   */
+  bool Lookup (Ipv4Address dst, RoutingTableEntryDown & rt);
+  /**
+   * \returns the number of clusters
+   */
+  uint32_t GetClusterCount ()
+  {
+    Purge ();
+    return m_clusters.size ();
+  }
+  /// Delete the clusters whose summary is outdated
+  void Purge ();
+  /// Delete every cluster
+  void Clear ()
+  {
+    m_clusters.clear ();
+  }
+
+private:
+  /// What a cluster head summarized
+  struct Cluster
+  {
+    uint32_t m_seqNo;                 ///< sequence number of the summary
+    CountingBloomFilter m_members;    ///< members of the cluster
+    Ptr<NetDevice> m_device;          ///< device the head is reached through
+    Ipv4InterfaceAddress m_iface;     ///< interface the head is reached through
+    Ipv4Address m_nextHop;            ///< next hop to the head
+    uint16_t m_hops;                  ///< hops to the head
+    Time m_expire;                    ///< end of validity of the summary
+  };
+  /// Clusters: head -> summary
+  std::map<Ipv4Address, Cluster> m_clusters;
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPCLUSTER_H */
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-energy-monitor.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpEnergyMonitor");
+
+namespace dmsrp {
+
+EnergyMonitor::EnergyMonitor ()
+  : m_interval (Seconds (1)),
+    m_alpha (0.2),
+    m_initial (0),
+    m_remaining (0),
+    m_drainRate (0),
+    m_lastSample (Seconds (0)),
+    m_sampled (false),
+    m_rated (false)
+{
+}
+
+void
+EnergyMonitor::SetEnergySource (Ptr<EnergySource> source)
+{
+  m_source = source;
+  m_sampled = false;
+  m_rated = false;
+  m_drainRate = 0;
+  m_initial = source == 0 ? 0 : source->GetInitialEnergy ();
+  m_remaining = m_initial;
+}
+
+void
+EnergyMonitor::Start ()
+{
+  m_sampleEvent.Cancel ();
+  Tick ();
+}
+
+void
+EnergyMonitor::Stop ()
+{
+  m_sampleEvent.Cancel ();
+}
+
+void
+EnergyMonitor::Tick ()
+{
+  Sample ();
+  m_sampleEvent = Simulator::Schedule (m_interval, &EnergyMonitor::Tick, this);
+}
+
+void
+EnergyMonitor::Sample ()
+{
+  if (m_source == 0)
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  double remaining = m_source->GetRemainingEnergy ();
+  if (m_sampled && now > m_lastSample)
+    {
+      double rate = std::max (0.0, (m_remaining - remaining) / (now - m_lastSample).GetSeconds ());
+      m_drainRate = m_rated ? m_alpha * rate + (1 - m_alpha) * m_drainRate : rate;
+      m_rated = true;
+      NS_LOG_LOGIC ("Remaining " << remaining << " J, drain " << m_drainRate << " W");
+    }
+  m_remaining = remaining;
+  m_lastSample = now;
+  m_sampled = true;
+}
+
+Time
+EnergyMonitor::GetLifetime () const
+{
+  Time max = Simulator::GetMaximumSimulationTime () - Simulator::Now ();
+  if (m_drainRate <= 0 || m_remaining / m_drainRate >= max.GetSeconds ())
+    {
+      return max;
+    }
+  return Seconds (m_remaining / m_drainRate);
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
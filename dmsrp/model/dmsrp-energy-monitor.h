@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPENERGYMONITOR_H
+#define DMSRPENERGYMONITOR_H
+
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/energy-source.h"
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Remaining energy of a node, sampled on a timer
+ *
+ * Reading the energy source updates the state of its energy models, so the
+ * control messages use the remaining energy of the last sample instead. Each
+ * sample takes the energy drained since the previous one and smooths the drain
+ * rate with an exponentially weighted moving average; the remaining energy over
+ * the drain rate predicts the time left before the battery is depleted.
+ */
+class EnergyMonitor
+{
+public:
+  /// constructor
+  EnergyMonitor ();
+
+  /**
+   * \param source the energy source of the node
+   */
+  void SetEnergySource (Ptr<EnergySource> source);
+  /**
+   * \param interval the time between two samples
+   */
+  void SetInterval (Time interval)
+  {
+    m_interval = interval;
+  }
+  /**
+   * \param alpha the weight of a new sample in the drain rate
+   */
+  void SetSmoothing (double alpha)
+  {
+    m_alpha = alpha;
+  }
+  /// Take a sample now, then one every interval
+  void Start ();
+  /// Stop sampling
+  void Stop ();
+  /// Read the energy source, and take the energy drained since the previous sample into the drain rate
+  void Sample ();
+  /**
+   * \returns the remaining energy at the last sample, in joules (0 without energy source)
+   */
+  double GetRemainingEnergy () const
+  {
+    return m_remaining;
+  }
+  /**
+   * \returns the initial energy of the source, in joules (0 without energy source)
+   */
+  double GetInitialEnergy () const
+  {
+    return m_initial;
+  }
+  /**
+   * \returns the smoothed drain rate, in watts
+   */
+  double GetDrainRate () const
+  {
+    return m_drainRate;
+  }
+  /**
+   * \returns the predicted time before depletion, the maximum simulation time while nothing is drained
+   */
+  Time GetLifetime () const;
+
+private:
+  /// Sample, and schedule the next sample
+  void Tick ();
+
+  Ptr<EnergySource> m_source;  ///< energy source
+  Time m_interval;             ///< time between two samples
+  double m_alpha;              ///< weight of a new sample
+  double m_initial;            ///< initial energy
+  double m_remaining;          ///< remaining energy at the last sample
+  double m_drainRate;          ///< smoothed drain rate
+  Time m_lastSample;           ///< time of the last sample
+  bool m_sampled;              ///< a sample was taken already
+  bool m_rated;                ///< a drain rate was measured already
+  EventId m_sampleEvent;       ///< next sample
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPENERGYMONITOR_H */
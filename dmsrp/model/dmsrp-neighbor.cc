@@ -0,0 +1,499 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>, written after AODV by Pavel Boyko <boyko@iitp.ru>
+ */
+
+#include "dmsrp-neighbor.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpNeighbors");
+
+namespace dmsrp {
+
+/// ETX of a link without reception
+static const double MAX_ETX = 255;
+
+/**
+ * \param nb the neighbor
+ * \returns the fraction of the last Hellos of the neighbor received
+ */
+static double
+GetReverseReception (Neighbors::Neighbor const & nb)
+{
+  if (nb.m_helloWindow.empty ())
+    {
+      return 0;
+    }
+  return (double) std::count (nb.m_helloWindow.begin (), nb.m_helloWindow.end (), true) / nb.m_helloWindow.size ();
+}
+
+Neighbors::Neighbors ()
+  : m_maxTxFailures (3),
+    m_linkWindow (16)
+{
+  m_txErrorCallback = MakeCallback (&Neighbors::ProcessTxError, this);
+  m_txOkCallback = MakeCallback (&Neighbors::ProcessTxOk, this);
+}
+
+bool
+Neighbors::IsNeighbor (Ipv4Address addr)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin ();
+       i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+Time
+Neighbors::GetExpireTime (Ipv4Address addr)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i
+       != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          return (i->m_expireTime - Simulator::Now ());
+        }
+    }
+  return Seconds (0);
+}
+
+void
+Neighbors::Update (Ipv4Address addr, Time expire)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          i->m_expireTime
+            = std::max (expire + Simulator::Now (), i->m_expireTime);
+          if (i->m_hardwareAddress == Mac48Address ())
+            {
+              i->m_hardwareAddress = LookupMacAddress (i->m_neighborAddress);
+            }
+          return;
+        }
+    }
+
+  NS_LOG_LOGIC ("Open link to " << addr);
+  Neighbor neighbor (addr, LookupMacAddress (addr), expire + Simulator::Now ());
+  m_nb.push_back (neighbor);
+  Purge ();
+}
+
+void
+Neighbors::SetCluster (Ipv4Address addr, float score, bool head)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          i->m_hasCluster = true;
+          i->m_clusterScore = score;
+          i->m_clusterHead = head;
+          return;
+        }
+    }
+}
+
+bool
+Neighbors::GetBestClusterScore (float & score, Ipv4Address & addr)
+{
+  Purge ();
+  bool found = false;
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (!i->m_hasCluster)
+        {
+          continue;
+        }
+      if (!found || i->m_clusterScore > score
+          || (i->m_clusterScore == score && addr < i->m_neighborAddress))
+        {
+          found = true;
+          score = i->m_clusterScore;
+          addr = i->m_neighborAddress;
+        }
+    }
+  return found;
+}
+
+void
+Neighbors::NotifyHello (Ipv4Address addr, uint16_t counter, Time expire)
+{
+  // the first Hello of a new neighbor counts in its window
+  Update (addr, expire);
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress != addr)
+        {
+          continue;
+        }
+      if (!i->m_helloWindow.empty ())
+        {
+          uint16_t gap = counter - i->m_helloCounter;
+          if (gap == 0 || gap > 0x8000)
+            {
+              // same Hello again (piggybacked), or an older one
+              return;
+            }
+          for (uint16_t missed = std::min<uint16_t> (gap - 1, m_linkWindow); missed > 0; --missed)
+            {
+              i->m_helloWindow.push_back (false);
+            }
+        }
+      i->m_helloWindow.push_back (true);
+      i->m_helloCounter = counter;
+      while (i->m_helloWindow.size () > m_linkWindow)
+        {
+          i->m_helloWindow.pop_front ();
+        }
+      return;
+    }
+}
+
+void
+Neighbors::SetForwardReception (Ipv4Address addr, uint8_t reception)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          i->m_hasForwardReception = true;
+          i->m_forwardReception = reception;
+          return;
+        }
+    }
+}
+
+double
+Neighbors::GetEtx (Ipv4Address addr)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress != addr)
+        {
+          continue;
+        }
+      double reverse = GetReverseReception (*i);
+      // until the neighbor reports the other direction, assume the link is symmetric
+      double forward = i->m_hasForwardReception ? i->m_forwardReception / 255.0 : reverse;
+      if (reverse * forward <= 0)
+        {
+          return MAX_ETX;
+        }
+      return std::min (1 / (reverse * forward), MAX_ETX);
+    }
+  return MAX_ETX;
+}
+
+void
+Neighbors::GetReceptions (std::vector<std::pair<Ipv4Address, uint8_t> > & receptions)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (!i->m_helloWindow.empty ())
+        {
+          receptions.push_back (std::make_pair (i->m_neighborAddress, (uint8_t) std::floor (GetReverseReception (*i) * 255 + 0.5)));
+        }
+    }
+}
+
+void
+Neighbors::GetNeighbors (std::set<Ipv4Address> & neighbors)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      neighbors.insert (i->m_neighborAddress);
+    }
+}
+
+Mac48Address
+Neighbors::GetHardwareAddress (Ipv4Address addr)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          if (i->m_hardwareAddress == Mac48Address ())
+            {
+              i->m_hardwareAddress = LookupMacAddress (i->m_neighborAddress);
+            }
+          return i->m_hardwareAddress;
+        }
+    }
+  return LookupMacAddress (addr);
+}
+
+void
+Neighbors::SetChannelLoad (Ipv4Address addr, uint8_t load)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          i->m_channelLoad = load;
+          return;
+        }
+    }
+}
+
+double
+Neighbors::GetChannelLoad (Ipv4Address addr)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          return i->m_channelLoad / 255.0;
+        }
+    }
+  return 0;
+}
+
+void
+Neighbors::SetMobility (Ipv4Address addr, Vector position, Vector velocity)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          i->m_hasMobility = true;
+          i->m_position = position;
+          i->m_velocity = velocity;
+          i->m_mobilityTime = Simulator::Now ();
+          return;
+        }
+    }
+}
+
+bool
+Neighbors::GetVelocity (Ipv4Address addr, Vector & velocity)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr && i->m_hasMobility)
+        {
+          velocity = i->m_velocity;
+          return true;
+        }
+    }
+  return false;
+}
+
+Time
+Neighbors::GetLinkLifetime (Ipv4Address addr, Vector position, Vector velocity, double range)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress != addr)
+        {
+          continue;
+        }
+      if (!i->m_hasMobility)
+        {
+          break;
+        }
+      // the neighbor kept moving since it advertised its position
+      double elapsed = (Simulator::Now () - i->m_mobilityTime).GetSeconds ();
+      Vector now (i->m_position.x + i->m_velocity.x * elapsed, i->m_position.y + i->m_velocity.y * elapsed, i->m_position.z);
+      return PredictLinkLifetime (position, velocity, now, i->m_velocity, range);
+    }
+  return Simulator::GetMaximumSimulationTime ();
+}
+
+Time
+Neighbors::PredictLinkLifetime (Vector p1, Vector v1, Vector p2, Vector v2, double range)
+{
+  // relative motion: the nodes meet the range circle at (-(ab + cd) + sqrt ((a^2 + c^2) r^2 - (ad - bc)^2)) / (a^2 + c^2)
+  double a = v1.x - v2.x;
+  double b = p1.x - p2.x;
+  double c = v1.y - v2.y;
+  double d = p1.y - p2.y;
+  if (b * b + d * d > range * range)
+    {
+      return Seconds (0);
+    }
+  double speed2 = a * a + c * c;
+  if (speed2 == 0)
+    {
+      return Simulator::GetMaximumSimulationTime ();
+    }
+  double discriminant = speed2 * range * range - (a * d - b * c) * (a * d - b * c);
+  if (discriminant < 0)
+    {
+      return Seconds (0);
+    }
+  return Seconds (std::max (0.0, (-(a * b + c * d) + std::sqrt (discriminant)) / speed2));
+}
+
+void
+Neighbors::SetTxPower (Ipv4Address addr, double txPower, double snr)
+{
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr)
+        {
+          i->m_hasTxPower = true;
+          i->m_txPower = txPower;
+          i->m_snr = snr;
+          return;
+        }
+    }
+}
+
+bool
+Neighbors::GetRequiredTxPower (Ipv4Address addr, double snr, double & txPower)
+{
+  Purge ();
+  for (std::vector<Neighbor>::const_iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_neighborAddress == addr && i->m_hasTxPower)
+        {
+          // the path loss plus the noise at the neighbor is its power minus the SNR of its Hello here
+          txPower = i->m_txPower - i->m_snr + snr;
+          return true;
+        }
+    }
+  return false;
+}
+
+/**
+ * \brief CloseNeighbor structure
+ */
+struct CloseNeighbor
+{
+  /**
+   * Check if the entry is expired
+   *
+   * \param nb Neighbors::Neighbor entry
+   * \return true if expired, false otherwise
+   */
+  bool operator() (const Neighbors::Neighbor & nb) const
+  {
+    return (nb.m_expireTime < Simulator::Now ());
+  }
+};
+
+void
+Neighbors::Purge ()
+{
+  if (m_nb.empty ())
+    {
+      return;
+    }
+  CloseNeighbor pred;
+  m_nb.erase (std::remove_if (m_nb.begin (), m_nb.end (), pred), m_nb.end ());
+}
+
+void
+Neighbors::AddArpCache (Ptr<ArpCache> a)
+{
+  m_arp.push_back (a);
+}
+
+void
+Neighbors::DelArpCache (Ptr<ArpCache> a)
+{
+  m_arp.erase (std::remove (m_arp.begin (), m_arp.end (), a), m_arp.end ());
+}
+
+Mac48Address
+Neighbors::LookupMacAddress (Ipv4Address addr)
+{
+  Mac48Address hwaddr;
+  for (std::vector<Ptr<ArpCache> >::const_iterator i = m_arp.begin ();
+       i != m_arp.end (); ++i)
+    {
+      ArpCache::Entry * entry = (*i)->Lookup (addr);
+      if (entry != 0 && (entry->IsAlive () || entry->IsPermanent ()) && !entry->IsExpired ())
+        {
+          hwaddr = Mac48Address::ConvertFrom (entry->GetMacAddress ());
+          break;
+        }
+    }
+  return hwaddr;
+}
+
+void
+Neighbors::ProcessTxError (WifiMacHeader const & hdr)
+{
+  Mac48Address addr = hdr.GetAddr1 ();
+  std::vector<Ipv4Address> lost;
+
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); )
+    {
+      if (i->m_hardwareAddress == Mac48Address ())
+        {
+          i->m_hardwareAddress = LookupMacAddress (i->m_neighborAddress);
+        }
+      if (i->m_hardwareAddress == addr && ++i->m_txFailures >= m_maxTxFailures)
+        {
+          NS_LOG_LOGIC ("Close link to " << i->m_neighborAddress << " after "
+                                         << i->m_txFailures << " TX failures");
+          lost.push_back (i->m_neighborAddress);
+          i = m_nb.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+
+  if (m_handleLinkFailure.IsNull ())
+    {
+      return;
+    }
+  for (std::vector<Ipv4Address>::const_iterator j = lost.begin (); j != lost.end (); ++j)
+    {
+      m_handleLinkFailure (*j);
+    }
+}
+
+void
+Neighbors::ProcessTxOk (WifiMacHeader const & hdr)
+{
+  Mac48Address addr = hdr.GetAddr1 ();
+  for (std::vector<Neighbor>::iterator i = m_nb.begin (); i != m_nb.end (); ++i)
+    {
+      if (i->m_hardwareAddress == addr)
+        {
+          i->m_txFailures = 0;
+        }
+    }
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
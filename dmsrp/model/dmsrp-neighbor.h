@@ -0,0 +1,375 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>, written after AODV by Pavel Boyko <boyko@iitp.ru>
+ */
+#ifndef DMSRPNEIGHBOR_H
+#define DMSRPNEIGHBOR_H
+
+#include "ns3/simulator.h"
+#include "ns3/timer.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/callback.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/arp-cache.h"
+#include "ns3/vector.h"
+#include <vector>
+#include <deque>
+#include <set>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief maintain list of active neighbors and detect broken links from layer 2 feedback
+ *
+ * A neighbor is declared lost after MaxTxFailures consecutive unicast frames
+ * to it were dropped by the MAC (retry limit reached). A successful unicast
+ * transmission resets the counter.
+ *
+ * The quality of a link is estimated from the Hellos: each node counts the Hellos
+ * it broadcasts, so that a neighbor sees the ones it missed, and the fraction of
+ * the last LinkWindow Hellos received gives the reception ratio of the link from
+ * the neighbor. The neighbor reports in its Hellos the ratio of the other
+ * direction; the ETX of the link is the inverse of the product of both.
+ *
+ * When the neighbors advertise their position and velocity, the time before a
+ * link breaks is predicted from the motion of both ends and a range model.
+ *
+ * When the neighbors advertise their transmit power, the path loss of a link is
+ * the difference between that power and the SNR of their last Hello, and gives
+ * the transmit power this node needs to reach them with a target SNR.
+ */
+class Neighbors
+{
+public:
+  /// constructor
+  Neighbors ();
+  /// Neighbor description
+  struct Neighbor
+  {
+    /// Neighbor IPv4 address
+    Ipv4Address m_neighborAddress;
+    /// Neighbor MAC address
+    Mac48Address m_hardwareAddress;
+    /// Neighbor expire time
+    Time m_expireTime;
+    /// Number of consecutive unicast frames to this neighbor dropped by the MAC
+    uint16_t m_txFailures;
+    /// Whether the neighbor sent its cluster election data
+    bool m_hasCluster;
+    /// Cluster score of the neighbor
+    float m_clusterScore;
+    /// Whether the neighbor is a cluster head
+    bool m_clusterHead;
+    /// Counter of the last Hello of the neighbor received
+    uint16_t m_helloCounter;
+    /// Last Hellos of the neighbor: true if received
+    std::deque<bool> m_helloWindow;
+    /// Whether the neighbor reported the reception of the Hellos of this node
+    bool m_hasForwardReception;
+    /// Fraction of the Hellos of this node the neighbor received, in 255ths
+    uint8_t m_forwardReception;
+    /// Fraction of the time the neighbor senses the channel busy, in 255ths
+    uint8_t m_channelLoad;
+    /// Whether the neighbor advertised its position and velocity
+    bool m_hasMobility;
+    /// Position of the neighbor at m_mobilityTime
+    Vector m_position;
+    /// Velocity of the neighbor
+    Vector m_velocity;
+    /// When the position was advertised
+    Time m_mobilityTime;
+    /// Whether the neighbor advertised its transmit power
+    bool m_hasTxPower;
+    /// Transmit power of the last Hello of the neighbor, in dBm
+    double m_txPower;
+    /// SNR of the last Hello of the neighbor, in dB
+    double m_snr;
+
+    /**
+     * \brief Neighbor structure constructor
+     *
+     * \param ip Ipv4Address entry
+     * \param mac Mac48Address entry
+     * \param t Time expire time
+     */
+    Neighbor (Ipv4Address ip, Mac48Address mac, Time t)
+      : m_neighborAddress (ip),
+        m_hardwareAddress (mac),
+        m_expireTime (t),
+        m_txFailures (0),
+        m_hasCluster (false),
+        m_clusterScore (0),
+        m_clusterHead (false),
+        m_helloCounter (0),
+        m_hasForwardReception (false),
+        m_forwardReception (0),
+        m_channelLoad (0),
+        m_hasMobility (false),
+        m_hasTxPower (false),
+        m_txPower (0),
+        m_snr (0)
+    {
+    }
+  };
+  /**
+   * Return expire time for neighbor node with address addr, if exists, else return 0.
+   * \param addr the IP address of the neighbor node
+   * \returns the expire time for the neighbor node
+   */
+  Time GetExpireTime (Ipv4Address addr);
+  /**
+   * Check that node with address addr is neighbor
+   * \param addr the IP address to check
+   * \returns true if the node with IP address is a neighbor
+   */
+  bool IsNeighbor (Ipv4Address addr);
+  /**
+   * Update expire time for entry with address addr, if it exists, else add new entry
+   * \param addr the IP address to check
+   * \param expire the expire time for the address
+   */
+  void Update (Ipv4Address addr, Time expire);
+  /// Remove all expired entries
+  void Purge ();
+  /**
+   * \returns the number of neighbors (the degree of this node)
+   */
+  uint32_t GetNeighborCount ()
+  {
+    Purge ();
+    return m_nb.size ();
+  }
+  /**
+   * \param neighbors the IP addresses of the neighbors
+   */
+  void GetNeighbors (std::set<Ipv4Address> & neighbors);
+  /**
+   * Record the cluster election data a neighbor sent
+   * \param addr the IP address of the neighbor
+   * \param score its cluster score
+   * \param head whether it is a cluster head
+   */
+  void SetCluster (Ipv4Address addr, float score, bool head);
+  /**
+   * Find the neighbor with the best cluster score
+   * \param score the best score
+   * \param addr the IP address of the neighbor, the highest one among equal scores
+   * \returns false if no neighbor sent its cluster election data
+   */
+  bool GetBestClusterScore (float & score, Ipv4Address & addr);
+  /**
+   * Record the reception of a Hello of a neighbor, and the ones missed before it;
+   * the neighbor is added if it is not known yet
+   * \param addr the IP address of the neighbor
+   * \param counter the counter of the Hello
+   * \param expire the expire time for the address
+   */
+  void NotifyHello (Ipv4Address addr, uint16_t counter, Time expire);
+  /**
+   * Record the fraction of the Hellos of this node a neighbor received
+   * \param addr the IP address of the neighbor
+   * \param reception the fraction, in 255ths
+   */
+  void SetForwardReception (Ipv4Address addr, uint8_t reception);
+  /**
+   * \param addr the IP address of the neighbor
+   * \returns the ETX of the link, 255 if no Hello of the neighbor was counted
+   */
+  double GetEtx (Ipv4Address addr);
+  /**
+   * Get the fraction of the Hellos of each neighbor received, to report them
+   * \param receptions the neighbors and their fraction, in 255ths
+   */
+  void GetReceptions (std::vector<std::pair<Ipv4Address, uint8_t> > & receptions);
+  /**
+   * \param addr the IP address of the neighbor
+   * \returns its MAC address, the default address while it is not resolved
+   */
+  Mac48Address GetHardwareAddress (Ipv4Address addr);
+  /**
+   * Record the channel load a neighbor reported
+   * \param addr the IP address of the neighbor
+   * \param load the fraction of the time it senses the channel busy, in 255ths
+   */
+  void SetChannelLoad (Ipv4Address addr, uint8_t load);
+  /**
+   * \param addr the IP address of the neighbor
+   * \returns the fraction of the time it senses the channel busy, 0 if it did not report it
+   */
+  double GetChannelLoad (Ipv4Address addr);
+  /**
+   * Record the position and velocity a neighbor advertised
+   * \param addr the IP address of the neighbor
+   * \param position its position
+   * \param velocity its velocity
+   */
+  void SetMobility (Ipv4Address addr, Vector position, Vector velocity);
+  /**
+   * \param addr the IP address of the neighbor
+   * \param velocity the velocity it advertised
+   * \returns false if it did not advertise its motion
+   */
+  bool GetVelocity (Ipv4Address addr, Vector & velocity);
+  /**
+   * Predict the time before the link to a neighbor breaks
+   * \param addr the IP address of the neighbor
+   * \param position the position of this node
+   * \param velocity the velocity of this node
+   * \param range the transmission range
+   * \returns the time, the maximum simulation time if the neighbor did not advertise its motion
+   */
+  Time GetLinkLifetime (Ipv4Address addr, Vector position, Vector velocity, double range);
+  /**
+   * Time two nodes moving in a straight line stay within range of each other
+   * (only the horizontal plane is considered)
+   * \param p1 the position of the first node
+   * \param v1 its velocity
+   * \param p2 the position of the second node
+   * \param v2 its velocity
+   * \param range the transmission range
+   * \returns the time, the maximum simulation time if they do not move apart, zero if out of range
+   */
+  static Time PredictLinkLifetime (Vector p1, Vector v1, Vector p2, Vector v2, double range);
+  /**
+   * Record the transmit power a neighbor advertised, and the SNR its Hello was received with
+   * \param addr the IP address of the neighbor
+   * \param txPower its transmit power, in dBm
+   * \param snr the SNR, in dB
+   */
+  void SetTxPower (Ipv4Address addr, double txPower, double snr);
+  /**
+   * Estimate the transmit power needed to reach a neighbor, assuming a symmetric link
+   * \param addr the IP address of the neighbor
+   * \param snr the SNR it should receive with, in dB
+   * \param txPower the transmit power, in dBm
+   * \returns false if the neighbor did not advertise its transmit power
+   */
+  bool GetRequiredTxPower (Ipv4Address addr, double snr, double & txPower);
+  /**
+   * \param window the number of last Hellos the reception ratio is computed on
+   */
+  void SetLinkWindow (uint16_t window)
+  {
+    m_linkWindow = window;
+  }
+  /// Remove all entries
+  void Clear ()
+  {
+    m_nb.clear ();
+  }
+
+  /**
+   * Add ARP cache to be used to allow layer 2 notifications processing
+   * \param a pointer to the ARP cache to add
+   */
+  void AddArpCache (Ptr<ArpCache> a);
+  /**
+   * Don't use given ARP cache any more (interface is down)
+   * \param a pointer to the ARP cache to delete
+   */
+  void DelArpCache (Ptr<ArpCache> a);
+  /**
+   * Get callback to ProcessTxError
+   * \returns the callback function
+   */
+  Callback<void, WifiMacHeader const &> GetTxErrorCallback () const
+  {
+    return m_txErrorCallback;
+  }
+  /**
+   * Get callback to ProcessTxOk
+   * \returns the callback function
+   */
+  Callback<void, WifiMacHeader const &> GetTxOkCallback () const
+  {
+    return m_txOkCallback;
+  }
+
+  /**
+   * Set link failure callback
+   * \param cb the callback function
+   */
+  void SetCallback (Callback<void, Ipv4Address> cb)
+  {
+    m_handleLinkFailure = cb;
+  }
+  /**
+   * Get link failure callback
+   * \returns the link failure callback
+   */
+  Callback<void, Ipv4Address> GetCallback () const
+  {
+    return m_handleLinkFailure;
+  }
+  /**
+   * Set the number of consecutive TX failures after which a neighbor is declared lost
+   * \param n the number of failures
+   */
+  void SetMaxTxFailures (uint16_t n)
+  {
+    m_maxTxFailures = n;
+  }
+  /**
+   * Get the number of consecutive TX failures after which a neighbor is declared lost
+   * \returns the number of failures
+   */
+  uint16_t GetMaxTxFailures () const
+  {
+    return m_maxTxFailures;
+  }
+
+private:
+  /// link failure callback
+  Callback<void, Ipv4Address> m_handleLinkFailure;
+  /// TX error callback
+  Callback<void, WifiMacHeader const &> m_txErrorCallback;
+  /// TX ok callback
+  Callback<void, WifiMacHeader const &> m_txOkCallback;
+  /// Number of consecutive TX failures before a link is declared broken
+  uint16_t m_maxTxFailures;
+  /// Number of last Hellos the reception ratio is computed on
+  uint16_t m_linkWindow;
+  /// vector of entries
+  std::vector<Neighbor> m_nb;
+  /// list of ARP cached to be used for layer 2 notifications processing
+  std::vector<Ptr<ArpCache> > m_arp;
+
+  /**
+   * Find MAC address by IP using list of ARP caches
+   *
+   * \param addr the IP address to lookup
+   * \returns the MAC address for the IP address
+   */
+  Mac48Address LookupMacAddress (Ipv4Address addr);
+  /**
+   * Count a dropped unicast frame against the neighbor it was sent to
+   * \param hdr the wifi MAC header of the dropped frame
+   */
+  void ProcessTxError (WifiMacHeader const &hdr);
+  /**
+   * Reset the failure counter of the neighbor a unicast frame was delivered to
+   * \param hdr the wifi MAC header of the acknowledged frame
+   */
+  void ProcessTxOk (WifiMacHeader const &hdr);
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPNEIGHBOR_H */
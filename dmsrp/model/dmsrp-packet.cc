@@ -19,6 +19,7 @@
 #include "dmsrp-packet.h"
 #include "ns3/address-utils.h"
 #include "ns3/packet.h"
+#include <algorithm>
 
 namespace ns3 {
 namespace dmsrp {
@@ -71,6 +72,15 @@ TypeHeader::Deserialize (Buffer::Iterator start)
     case DMSRPTYPE_HELLO://DMS
     case DMSRPTYPE_ADVERTISE://DMS  
     case DMSRPTYPE_SRVADVERTISE://DMS 
+    case DMSRPTYPE_RERR:
+    case DMSRPTYPE_PIGGYBACK:
+    case DMSRPTYPE_PARENTASSIGN:
+    case DMSRPTYPE_SOURCEROUTE:
+    case DMSRPTYPE_SCOPEDFLOOD:
+    case DMSRPTYPE_SRVPROBE:
+    case DMSRPTYPE_SRVPROBE_REPLY:
+    case DMSRPTYPE_CLUSTERADVERTISE:
+    case DMSRPTYPE_CONTAINER:
       {
         m_type = (MessageType) type;
         break;
@@ -103,6 +113,51 @@ TypeHeader::Print (std::ostream &os) const
         os << "SRVADVERTISE";
         break;
       }
+    case DMSRPTYPE_RERR:
+      {
+        os << "RERR";
+        break;
+      }
+    case DMSRPTYPE_PIGGYBACK:
+      {
+        os << "PIGGYBACK";
+        break;
+      }
+    case DMSRPTYPE_PARENTASSIGN:
+      {
+        os << "PARENTASSIGN";
+        break;
+      }
+    case DMSRPTYPE_SOURCEROUTE:
+      {
+        os << "SOURCEROUTE";
+        break;
+      }
+    case DMSRPTYPE_SCOPEDFLOOD:
+      {
+        os << "SCOPEDFLOOD";
+        break;
+      }
+    case DMSRPTYPE_SRVPROBE:
+      {
+        os << "SRVPROBE";
+        break;
+      }
+    case DMSRPTYPE_SRVPROBE_REPLY:
+      {
+        os << "SRVPROBE_REPLY";
+        break;
+      }
+    case DMSRPTYPE_CLUSTERADVERTISE:
+      {
+        os << "CLUSTERADVERTISE";
+        break;
+      }
+    case DMSRPTYPE_CONTAINER:
+      {
+        os << "CONTAINER";
+        break;
+      }
     default:
       os << "UNKNOWN_TYPE";
     }
@@ -125,13 +180,23 @@ operator<< (std::ostream & os, TypeHeader const & h)
 //-----------------------------------------------------------------------------
 // HELLO
 //-----------------------------------------------------------------------------
-HelloHeader::HelloHeader (uint8_t hopCount, uint16_t reserved,float minEnergy,float minSnr, Ipv4Address origin, uint32_t HSeqNo)
+HelloHeader::HelloHeader (uint8_t hopCount, uint8_t flags,float minEnergy,float minSnr, Ipv4Address origin, uint32_t HSeqNo)
   : m_hopCount (hopCount),
-    m_reserved (reserved),
+    m_flags (flags),
     m_minEnergy (minEnergy),
     m_minSnr (minSnr),
     m_origin (origin),
-    m_HseqNo (HSeqNo)
+    m_HseqNo (HSeqNo),
+    m_clusterHead (false),
+    m_clusterScore (0),
+    m_helloCounter (0),
+    m_pathEtx (0),
+    m_pathAirtime (0),
+    m_channelLoad (0),
+    m_txPower (0),
+    m_pathLifetime (0),
+    m_subtreeSize (0),
+    m_uplinkLoad (0)
 {
 }
 
@@ -157,7 +222,11 @@ HelloHeader::GetInstanceTypeId () const
 uint32_t
 HelloHeader::GetSerializedSize () const
 {
-  return 19;
+  return 19 + 17 * m_sinkRecords.size () + ((m_flags & CLUSTER) ? 8 : 0)
+         + ((m_flags & LINK_QUALITY) ? 8 + 5 * m_linkRecords.size () : 0)
+         + ((m_flags & AIRTIME) ? 4 : 0) + ((m_flags & CHANNEL_LOAD) ? 4 : 0)
+         + ((m_flags & MOBILITY) ? 16 : 0) + ((m_flags & TX_POWER) ? 4 : 0)
+         + ((m_flags & PATH_LIFETIME) ? 4 : 0) + ((m_flags & SINK_LOAD) ? 4 : 0);
 }
 
 void
@@ -165,7 +234,8 @@ HelloHeader::Serialize (Buffer::Iterator i) const
 {
 uu_32 tmp32;
   i.WriteU8 (m_hopCount);
-  i.WriteU16 (m_reserved);
+  i.WriteU8 (m_sinkRecords.size ());
+  i.WriteU8 (m_flags);
   //i.WriteU32 (m_minEnergy);
   tmp32.f=m_minEnergy;
   i.WriteHtonU32 ((uint32_t)tmp32.i);
@@ -173,6 +243,75 @@ uu_32 tmp32;
   i.WriteHtonU32 ((uint32_t)tmp32.i);
     WriteTo (i, m_origin);
   i.WriteHtonU32 (m_HseqNo);
+  for (std::vector<SinkRecord>::const_iterator j = m_sinkRecords.begin (); j != m_sinkRecords.end (); ++j)
+    {
+      WriteTo (i, j->sink);
+      i.WriteHtonU32 (j->seqNo);
+      i.WriteU8 (j->hopCount);
+      tmp32.f = j->minEnergy;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      tmp32.f = j->minSnr;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+  if (m_flags & CLUSTER)
+    {
+      i.WriteU8 (m_clusterHead ? (1 << 7) : 0);
+      i.WriteU8 (0);
+      i.WriteU16 (0);
+      tmp32.f = m_clusterScore;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+  if (m_flags & LINK_QUALITY)
+    {
+      i.WriteHtonU16 (m_helloCounter);
+      i.WriteU8 (m_linkRecords.size ());
+      i.WriteU8 (0);
+      tmp32.f = m_pathEtx;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      for (std::vector<std::pair<Ipv4Address, uint8_t> >::const_iterator j = m_linkRecords.begin (); j != m_linkRecords.end (); ++j)
+        {
+          WriteTo (i, j->first);
+          i.WriteU8 (j->second);
+        }
+    }
+  if (m_flags & AIRTIME)
+    {
+      tmp32.f = m_pathAirtime;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+  if (m_flags & CHANNEL_LOAD)
+    {
+      i.WriteU8 (m_channelLoad);
+      i.WriteU8 (0);
+      i.WriteU16 (0);
+    }
+  if (m_flags & MOBILITY)
+    {
+      tmp32.f = m_position.x;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      tmp32.f = m_position.y;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      tmp32.f = m_velocity.x;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      tmp32.f = m_velocity.y;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+  if (m_flags & TX_POWER)
+    {
+      tmp32.f = m_txPower;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+  if (m_flags & PATH_LIFETIME)
+    {
+      tmp32.f = m_pathLifetime;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+  if (m_flags & SINK_LOAD)
+    {
+      i.WriteHtonU16 (m_subtreeSize);
+      i.WriteU8 (m_uplinkLoad);
+      i.WriteU8 (0);
+    }
 }
 
 uint32_t
@@ -182,7 +321,8 @@ HelloHeader::Deserialize (Buffer::Iterator start)
 uu_32 tmp32;
   Buffer::Iterator i = start;
   m_hopCount = i.ReadU8 ();
-  m_reserved = i.ReadU16 ();
+  uint8_t sinkCount = i.ReadU8 ();
+  m_flags = i.ReadU8 ();
 //  m_minEnergy = i.ReadU32 ();
   tmp32.i=i.ReadNtohU32 ();
   m_minEnergy = (float) tmp32.f;
@@ -190,6 +330,92 @@ uu_32 tmp32;
   m_minSnr = (float) tmp32.f;
   ReadFrom (i, m_origin);
   m_HseqNo = i.ReadNtohU32 ();
+  m_sinkRecords.clear ();
+  for (uint8_t k = 0; k < sinkCount; ++k)
+    {
+      SinkRecord record;
+      ReadFrom (i, record.sink);
+      record.seqNo = i.ReadNtohU32 ();
+      record.hopCount = i.ReadU8 ();
+      tmp32.i = i.ReadNtohU32 ();
+      record.minEnergy = (float) tmp32.f;
+      tmp32.i = i.ReadNtohU32 ();
+      record.minSnr = (float) tmp32.f;
+      m_sinkRecords.push_back (record);
+    }
+  m_clusterHead = false;
+  m_clusterScore = 0;
+  if (m_flags & CLUSTER)
+    {
+      m_clusterHead = (i.ReadU8 () & (1 << 7));
+      i.ReadU8 ();
+      i.ReadU16 ();
+      tmp32.i = i.ReadNtohU32 ();
+      m_clusterScore = (float) tmp32.f;
+    }
+  m_helloCounter = 0;
+  m_pathEtx = 0;
+  m_linkRecords.clear ();
+  if (m_flags & LINK_QUALITY)
+    {
+      m_helloCounter = i.ReadNtohU16 ();
+      uint8_t linkCount = i.ReadU8 ();
+      i.ReadU8 ();
+      tmp32.i = i.ReadNtohU32 ();
+      m_pathEtx = (float) tmp32.f;
+      for (uint8_t k = 0; k < linkCount; ++k)
+        {
+          Ipv4Address neighbor;
+          ReadFrom (i, neighbor);
+          m_linkRecords.push_back (std::make_pair (neighbor, i.ReadU8 ()));
+        }
+    }
+  m_pathAirtime = 0;
+  if (m_flags & AIRTIME)
+    {
+      tmp32.i = i.ReadNtohU32 ();
+      m_pathAirtime = (float) tmp32.f;
+    }
+  m_channelLoad = 0;
+  if (m_flags & CHANNEL_LOAD)
+    {
+      m_channelLoad = i.ReadU8 ();
+      i.ReadU8 ();
+      i.ReadU16 ();
+    }
+  m_position = Vector ();
+  m_velocity = Vector ();
+  if (m_flags & MOBILITY)
+    {
+      tmp32.i = i.ReadNtohU32 ();
+      m_position.x = tmp32.f;
+      tmp32.i = i.ReadNtohU32 ();
+      m_position.y = tmp32.f;
+      tmp32.i = i.ReadNtohU32 ();
+      m_velocity.x = tmp32.f;
+      tmp32.i = i.ReadNtohU32 ();
+      m_velocity.y = tmp32.f;
+    }
+  m_txPower = 0;
+  if (m_flags & TX_POWER)
+    {
+      tmp32.i = i.ReadNtohU32 ();
+      m_txPower = (float) tmp32.f;
+    }
+  m_pathLifetime = 0;
+  if (m_flags & PATH_LIFETIME)
+    {
+      tmp32.i = i.ReadNtohU32 ();
+      m_pathLifetime = (float) tmp32.f;
+    }
+  m_subtreeSize = 0;
+  m_uplinkLoad = 0;
+  if (m_flags & SINK_LOAD)
+    {
+      m_subtreeSize = i.ReadNtohU16 ();
+      m_uplinkLoad = i.ReadU8 ();
+      i.ReadU8 ();
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -202,6 +428,129 @@ HelloHeader::Print (std::ostream &os) const
   os << " destination: ipv4 " << "DMS Out"
      << " sequence number " << m_HseqNo << " source: ipv4 "
      << m_origin;
+  for (std::vector<SinkRecord>::const_iterator j = m_sinkRecords.begin (); j != m_sinkRecords.end (); ++j)
+    {
+      os << " sink: ipv4 " << j->sink << " sequence number " << j->seqNo << " hops " << (uint16_t) j->hopCount;
+    }
+}
+
+bool
+HelloHeader::AddSinkRecord (HelloHeader const & route)
+{
+  if (route.GetOrigin () == m_origin || m_sinkRecords.size () == 255)
+    {
+      return false;
+    }
+  for (std::vector<SinkRecord>::const_iterator j = m_sinkRecords.begin (); j != m_sinkRecords.end (); ++j)
+    {
+      if (j->sink == route.GetOrigin ())
+        {
+          return false;
+        }
+    }
+  SinkRecord record;
+  record.sink = route.GetOrigin ();
+  record.seqNo = route.GetOriginSeqno ();
+  record.hopCount = route.GetHopCount ();
+  record.minEnergy = route.GetMinEnergy ();
+  record.minSnr = route.GetMinSnr ();
+  m_sinkRecords.push_back (record);
+  return true;
+}
+
+void
+HelloHeader::SetCluster (float score, bool head)
+{
+  m_flags |= CLUSTER;
+  m_clusterScore = score;
+  m_clusterHead = head;
+}
+
+void
+HelloHeader::SetLinkQuality (uint16_t counter, float pathEtx)
+{
+  m_flags |= LINK_QUALITY;
+  m_helloCounter = counter;
+  m_pathEtx = pathEtx;
+}
+
+void
+HelloHeader::SetPathAirtime (float pathAirtime)
+{
+  m_flags |= AIRTIME;
+  m_pathAirtime = pathAirtime;
+}
+
+void
+HelloHeader::SetChannelLoad (uint8_t load)
+{
+  m_flags |= CHANNEL_LOAD;
+  m_channelLoad = load;
+}
+
+void
+HelloHeader::SetMobility (Vector position, Vector velocity)
+{
+  m_flags |= MOBILITY;
+  // kept as sent, so that a received header compares equal to the one sent
+  m_position = Vector ((float) position.x, (float) position.y, 0);
+  m_velocity = Vector ((float) velocity.x, (float) velocity.y, 0);
+}
+
+void
+HelloHeader::SetTxPower (float txPower)
+{
+  m_flags |= TX_POWER;
+  m_txPower = txPower;
+}
+
+void
+HelloHeader::SetPathLifetime (float pathLifetime)
+{
+  m_flags |= PATH_LIFETIME;
+  m_pathLifetime = pathLifetime;
+}
+
+void
+HelloHeader::SetSinkLoad (uint16_t subtreeSize, uint8_t uplinkLoad)
+{
+  m_flags |= SINK_LOAD;
+  m_subtreeSize = subtreeSize;
+  m_uplinkLoad = uplinkLoad;
+}
+
+bool
+HelloHeader::AddLinkRecord (Ipv4Address neighbor, uint8_t reception)
+{
+  if (m_linkRecords.size () == 255)
+    {
+      return false;
+    }
+  m_linkRecords.push_back (std::make_pair (neighbor, reception));
+  return true;
+}
+
+bool
+HelloHeader::GetLinkRecord (Ipv4Address neighbor, uint8_t & reception) const
+{
+  for (std::vector<std::pair<Ipv4Address, uint8_t> >::const_iterator j = m_linkRecords.begin (); j != m_linkRecords.end (); ++j)
+    {
+      if (j->first == neighbor)
+        {
+          reception = j->second;
+          return true;
+        }
+    }
+  return false;
+}
+
+HelloHeader
+HelloHeader::GetSinkRecord (uint8_t i) const
+{
+  NS_ASSERT (i < m_sinkRecords.size ());
+  SinkRecord const & record = m_sinkRecords[i];
+  return HelloHeader (/*hops=*/ record.hopCount, /*flags=*/ m_flags & ~(CLUSTER | LINK_QUALITY | AIRTIME | CHANNEL_LOAD | MOBILITY | TX_POWER | PATH_LIFETIME | SINK_LOAD), /*Min Energy*/ record.minEnergy,
+                      /*Min snr*/ record.minSnr, /*orig=sink*/ record.sink, /*seqno=*/ record.seqNo);
 }
 
 std::ostream &
@@ -214,10 +563,153 @@ operator<< (std::ostream & os, HelloHeader const & h)
 bool
 HelloHeader::operator== (HelloHeader const & o) const
 {
-  return (m_hopCount == o.m_hopCount && m_reserved == o.m_reserved && m_minEnergy == o.m_minEnergy && m_minSnr == o.m_minSnr
-          && m_origin == o.m_origin && m_HseqNo == o.m_HseqNo);
+  if (m_sinkRecords.size () != o.m_sinkRecords.size ())
+    {
+      return false;
+    }
+  for (size_t j = 0; j < m_sinkRecords.size (); ++j)
+    {
+      if (m_sinkRecords[j].sink != o.m_sinkRecords[j].sink || m_sinkRecords[j].seqNo != o.m_sinkRecords[j].seqNo
+          || m_sinkRecords[j].hopCount != o.m_sinkRecords[j].hopCount || m_sinkRecords[j].minEnergy != o.m_sinkRecords[j].minEnergy
+          || m_sinkRecords[j].minSnr != o.m_sinkRecords[j].minSnr)
+        {
+          return false;
+        }
+    }
+  return (m_hopCount == o.m_hopCount && m_flags == o.m_flags && m_minEnergy == o.m_minEnergy && m_minSnr == o.m_minSnr
+          && m_origin == o.m_origin && m_HseqNo == o.m_HseqNo
+          && m_clusterHead == o.m_clusterHead && m_clusterScore == o.m_clusterScore
+          && m_helloCounter == o.m_helloCounter && m_pathEtx == o.m_pathEtx && m_linkRecords == o.m_linkRecords
+          && m_pathAirtime == o.m_pathAirtime && m_channelLoad == o.m_channelLoad
+          && m_position.x == o.m_position.x && m_position.y == o.m_position.y
+          && m_velocity.x == o.m_velocity.x && m_velocity.y == o.m_velocity.y
+          && m_txPower == o.m_txPower && m_pathLifetime == o.m_pathLifetime
+          && m_subtreeSize == o.m_subtreeSize && m_uplinkLoad == o.m_uplinkLoad);
+}
+
+
+
+//-----------------------------------------------------------------------------
+// TOPOLOGY REPORT
+//-----------------------------------------------------------------------------
+TopologyReport::TopologyReport ()
+  : m_energy (0)
+{
+}
+
+bool
+TopologyReport::AddLink (Ipv4Address parent, float snr)
+{
+  if (m_links.size () == 255)
+    {
+      return false;
+    }
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->parent == parent)
+        {
+          return false;
+        }
+    }
+  Link link;
+  link.parent = parent;
+  link.snr = snr;
+  m_links.push_back (link);
+  return true;
+}
+
+Ipv4Address
+TopologyReport::GetParent (uint8_t i) const
+{
+  NS_ASSERT (i < m_links.size ());
+  return m_links[i].parent;
+}
+
+float
+TopologyReport::GetSnr (uint8_t i) const
+{
+  NS_ASSERT (i < m_links.size ());
+  return m_links[i].snr;
+}
+
+void
+TopologyReport::Clear ()
+{
+  m_energy = 0;
+  m_links.clear ();
+}
+
+uint32_t
+TopologyReport::GetSerializedSize () const
+{
+  return m_links.empty () ? 0 : 4 + 8 * m_links.size ();
+}
+
+void
+TopologyReport::Serialize (Buffer::Iterator & i) const
+{
+  if (m_links.empty ())
+    {
+      return;
+    }
+  uu_32 tmp32;
+  tmp32.f = m_energy;
+  i.WriteHtonU32 ((uint32_t)tmp32.i);
+  for (std::vector<Link>::const_iterator j = m_links.begin (); j != m_links.end (); ++j)
+    {
+      WriteTo (i, j->parent);
+      tmp32.f = j->snr;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+    }
+}
+
+void
+TopologyReport::Deserialize (Buffer::Iterator & i, uint8_t linkCount)
+{
+  Clear ();
+  if (linkCount == 0)
+    {
+      return;
+    }
+  uu_32 tmp32;
+  tmp32.i = i.ReadNtohU32 ();
+  m_energy = (float) tmp32.f;
+  for (uint8_t k = 0; k < linkCount; ++k)
+    {
+      Link link;
+      ReadFrom (i, link.parent);
+      tmp32.i = i.ReadNtohU32 ();
+      link.snr = (float) tmp32.f;
+      m_links.push_back (link);
+    }
+}
+
+bool
+TopologyReport::operator== (TopologyReport const & o) const
+{
+  if (!m_links.empty () && m_energy != o.m_energy)
+    {
+      return false;
+    }
+  return HasSameLinks (o);
 }
 
+bool
+TopologyReport::HasSameLinks (TopologyReport const & o) const
+{
+  if (m_links.size () != o.m_links.size ())
+    {
+      return false;
+    }
+  for (uint32_t k = 0; k < m_links.size (); ++k)
+    {
+      if (m_links[k].parent != o.m_links[k].parent || m_links[k].snr != o.m_links[k].snr)
+        {
+          return false;
+        }
+    }
+  return true;
+}
 
 
 //-----------------------------------------------------------------------------
@@ -225,7 +717,6 @@ HelloHeader::operator== (HelloHeader const & o) const
 //-----------------------------------------------------------------------------
 AdvertiseHeader::AdvertiseHeader ( uint8_t hopCount, uint16_t reserved,Ipv4Address origin, uint32_t ASeqNo)
   :  m_hopCount (hopCount),
-     m_reserved (reserved),
      m_origin (origin),
      m_AseqNo (ASeqNo)
 {
@@ -253,16 +744,22 @@ AdvertiseHeader::GetInstanceTypeId () const
 uint32_t
 AdvertiseHeader::GetSerializedSize () const
 {
-  return 11;
+  return 11 + m_report.GetSerializedSize () + 4 * m_path.size ();
 }
 
 void
 AdvertiseHeader::Serialize (Buffer::Iterator i) const
 {
   i.WriteU8 (m_hopCount);
-  i.WriteU16 (m_reserved);
+  i.WriteU8 (m_report.GetLinkCount ());
+  i.WriteU8 ((uint8_t) m_path.size ());
     WriteTo (i, m_origin);
   i.WriteHtonU32 (m_AseqNo);
+  m_report.Serialize (i);
+  for (std::vector<Ipv4Address>::const_iterator j = m_path.begin (); j != m_path.end (); ++j)
+    {
+      WriteTo (i, *j);
+    }
 }
 
 uint32_t
@@ -270,9 +767,18 @@ AdvertiseHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
   m_hopCount = i.ReadU8 ();
-  m_reserved = i.ReadU16 ();
+  uint8_t linkCount = i.ReadU8 ();
+  uint8_t pathLength = i.ReadU8 ();
   ReadFrom (i, m_origin);
   m_AseqNo = i.ReadNtohU32 ();
+  m_report.Deserialize (i, linkCount);
+  m_path.clear ();
+  for (uint8_t k = 0; k < pathLength; ++k)
+    {
+      Ipv4Address relay;
+      ReadFrom (i, relay);
+      m_path.push_back (relay);
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -297,8 +803,19 @@ operator<< (std::ostream & os, AdvertiseHeader const & h)
 bool
 AdvertiseHeader::operator== (AdvertiseHeader const & o) const
 {
-  return ( m_hopCount == o.m_hopCount && m_reserved == o.m_reserved
-          && m_origin == o.m_origin && m_AseqNo == o.m_AseqNo);
+  return ( m_hopCount == o.m_hopCount && m_path == o.m_path
+          && m_origin == o.m_origin && m_AseqNo == o.m_AseqNo && m_report == o.m_report);
+}
+
+bool
+AdvertiseHeader::AddRelay (Ipv4Address relay)
+{
+  if (m_path.size () == 255)
+    {
+      return false;
+    }
+  m_path.push_back (relay);
+  return true;
 }
 
 
@@ -307,9 +824,9 @@ AdvertiseHeader::operator== (AdvertiseHeader const & o) const
 //-----------------------------------------------------------------------------
 // SRVADVERTISE
 //-----------------------------------------------------------------------------
-SrvAdvertiseHeader::SrvAdvertiseHeader ( uint8_t hopCount, uint16_t reserved, Ipv4Address origin,Ipv4Address sink, uint32_t ASeqNo)
+SrvAdvertiseHeader::SrvAdvertiseHeader ( uint8_t hopCount, uint8_t routeTimeout, Ipv4Address origin,Ipv4Address sink, uint32_t ASeqNo)
   : m_hopCount (hopCount),
-    m_reserved (reserved),
+    m_routeTimeout (routeTimeout),
     m_origin (origin),
     m_sink (sink),
     m_AseqNo (ASeqNo)
@@ -338,17 +855,19 @@ SrvAdvertiseHeader::GetInstanceTypeId () const
 uint32_t
 SrvAdvertiseHeader::GetSerializedSize () const
 {
-  return 15;
+  return 15 + m_report.GetSerializedSize ();
 }
 
 void
 SrvAdvertiseHeader::Serialize (Buffer::Iterator i) const
 {
   i.WriteU8 (m_hopCount);
-  i.WriteU16 (m_reserved);
+  i.WriteU8 (m_report.GetLinkCount ());
+  i.WriteU8 (m_routeTimeout);
     WriteTo (i, m_origin);
     WriteTo (i, m_sink);
   i.WriteHtonU32 (m_AseqNo);
+  m_report.Serialize (i);
 }
 
 uint32_t
@@ -356,10 +875,12 @@ SrvAdvertiseHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
   m_hopCount = i.ReadU8 ();
-  m_reserved = i.ReadU16 ();
+  uint8_t linkCount = i.ReadU8 ();
+  m_routeTimeout = i.ReadU8 ();
   ReadFrom (i, m_origin);
   ReadFrom (i, m_sink);
   m_AseqNo = i.ReadNtohU32 ();
+  m_report.Deserialize (i, linkCount);
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -373,6 +894,12 @@ SrvAdvertiseHeader::Print (std::ostream &os) const
      << " sequence number " << m_AseqNo << " source: ipv4 " << m_origin  << " sink: ipv4 " << m_sink;
 }
 
+void
+SrvAdvertiseHeader::SetRouteTimeout (Time timeout)
+{
+  m_routeTimeout = std::min<int64_t> (255, (timeout.GetMilliSeconds () + 99) / 100);
+}
+
 std::ostream &
 operator<< (std::ostream & os, SrvAdvertiseHeader const & h)
 {
@@ -383,10 +910,892 @@ operator<< (std::ostream & os, SrvAdvertiseHeader const & h)
 bool
 SrvAdvertiseHeader::operator== (SrvAdvertiseHeader const & o) const
 {
-  return ( m_hopCount == o.m_hopCount && m_reserved == o.m_reserved
-          && m_origin == o.m_origin && m_sink == o.m_sink && m_AseqNo == o.m_AseqNo);
+  return ( m_hopCount == o.m_hopCount && m_routeTimeout == o.m_routeTimeout
+          && m_origin == o.m_origin && m_sink == o.m_sink && m_AseqNo == o.m_AseqNo
+          && m_report == o.m_report);
+}
+
+
+
+//-----------------------------------------------------------------------------
+// RERR
+//-----------------------------------------------------------------------------
+RerrHeader::RerrHeader ()
+  : m_reserved (0)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (RerrHeader);
+
+TypeId
+RerrHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::RerrHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<RerrHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+RerrHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+RerrHeader::GetSerializedSize () const
+{
+  return (3 + 8 * GetDestCount ());
+}
+
+void
+RerrHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU16 (m_reserved);
+  i.WriteU8 (GetDestCount ());
+  std::map<Ipv4Address, uint32_t>::const_iterator j;
+  for (j = m_unreachableDstSeqNo.begin (); j != m_unreachableDstSeqNo.end (); ++j)
+    {
+      WriteTo (i, (*j).first);
+      i.WriteHtonU32 ((*j).second);
+    }
+}
+
+uint32_t
+RerrHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_reserved = i.ReadU16 ();
+  uint8_t dest = i.ReadU8 ();
+  m_unreachableDstSeqNo.clear ();
+  Ipv4Address address;
+  uint32_t seqNo;
+  for (uint8_t k = 0; k < dest; ++k)
+    {
+      ReadFrom (i, address);
+      seqNo = i.ReadNtohU32 ();
+      m_unreachableDstSeqNo.insert (std::make_pair (address, seqNo));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+RerrHeader::Print (std::ostream &os) const
+{
+  os << "Unreachable destination (ipv4 address, seq. number):";
+  std::map<Ipv4Address, uint32_t>::const_iterator j;
+  for (j = m_unreachableDstSeqNo.begin (); j != m_unreachableDstSeqNo.end (); ++j)
+    {
+      os << (*j).first << ", " << (*j).second;
+    }
 }
 
+bool
+RerrHeader::AddUnDestination (Ipv4Address dst, uint32_t seqNo)
+{
+  if (m_unreachableDstSeqNo.find (dst) != m_unreachableDstSeqNo.end ())
+    {
+      return true;
+    }
+
+  if (GetDestCount () == 255)
+    {
+      return false; // can't support more than 255 destinations in single RERR
+    }
+  m_unreachableDstSeqNo.insert (std::make_pair (dst, seqNo));
+  return true;
+}
+
+bool
+RerrHeader::RemoveUnDestination (std::pair<Ipv4Address, uint32_t> & un)
+{
+  if (m_unreachableDstSeqNo.empty ())
+    {
+      return false;
+    }
+  std::map<Ipv4Address, uint32_t>::iterator it = m_unreachableDstSeqNo.begin ();
+  un = *it;
+  m_unreachableDstSeqNo.erase (it);
+  return true;
+}
+
+void
+RerrHeader::Clear ()
+{
+  m_reserved = 0;
+  m_unreachableDstSeqNo.clear ();
+}
+
+bool
+RerrHeader::operator== (RerrHeader const & o) const
+{
+  if (m_reserved != o.m_reserved || GetDestCount () != o.GetDestCount ())
+    {
+      return false;
+    }
+
+  std::map<Ipv4Address, uint32_t>::const_iterator j = m_unreachableDstSeqNo.begin ();
+  std::map<Ipv4Address, uint32_t>::const_iterator k = o.m_unreachableDstSeqNo.begin ();
+  for (uint8_t i = 0; i < GetDestCount (); ++i)
+    {
+      if ((j->first != k->first) || (j->second != k->second))
+        {
+          return false;
+        }
+
+      j++;
+      k++;
+    }
+  return true;
+}
+
+std::ostream &
+operator<< (std::ostream & os, RerrHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+
+//-----------------------------------------------------------------------------
+// PIGGYBACK
+//-----------------------------------------------------------------------------
+PiggybackHeader::PiggybackHeader (uint8_t nextHeader, Ipv4Address sender)
+  : m_nextHeader (nextHeader),
+    m_flags (0),
+    m_hopCount (0),
+    m_reserved (0),
+    m_sender (sender),
+    m_seqNo (0),
+    m_minEnergy (0),
+    m_minSnr (0)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (PiggybackHeader);
+
+TypeId
+PiggybackHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::PiggybackHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<PiggybackHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+PiggybackHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+PiggybackHeader::GetSerializedSize () const
+{
+  return HasHello () ? 24 : 12;
+}
+
+void
+PiggybackHeader::Serialize (Buffer::Iterator i) const
+{
+  uu_32 tmp32;
+  i.WriteU8 (m_nextHeader);
+  i.WriteU8 (m_flags);
+  i.WriteU8 (m_hopCount);
+  i.WriteU8 (m_reserved);
+  WriteTo (i, m_sender);
+  i.WriteHtonU32 (m_seqNo);
+  if (HasHello ())
+    {
+      tmp32.f = m_minEnergy;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      tmp32.f = m_minSnr;
+      i.WriteHtonU32 ((uint32_t)tmp32.i);
+      WriteTo (i, m_sink);
+    }
+}
+
+uint32_t
+PiggybackHeader::Deserialize (Buffer::Iterator start)
+{
+  uu_32 tmp32;
+  Buffer::Iterator i = start;
+  m_nextHeader = i.ReadU8 ();
+  m_flags = i.ReadU8 ();
+  m_hopCount = i.ReadU8 ();
+  m_reserved = i.ReadU8 ();
+  ReadFrom (i, m_sender);
+  m_seqNo = i.ReadNtohU32 ();
+  if (HasHello ())
+    {
+      tmp32.i = i.ReadNtohU32 ();
+      m_minEnergy = (float) tmp32.f;
+      tmp32.i = i.ReadNtohU32 ();
+      m_minSnr = (float) tmp32.f;
+      ReadFrom (i, m_sink);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+PiggybackHeader::Print (std::ostream &os) const
+{
+  os << " next header " << (uint16_t) m_nextHeader << " sender: ipv4 " << m_sender;
+  if (HasAdvertise ())
+    {
+      os << " advertise hops " << (uint16_t) m_hopCount << " sequence number " << m_seqNo;
+    }
+  if (HasHello ())
+    {
+      os << " hello hops " << (uint16_t) m_hopCount << " sequence number " << m_seqNo
+         << " sink: ipv4 " << m_sink;
+    }
+}
+
+void
+PiggybackHeader::SetAdvertise (AdvertiseHeader const & advertiseHeader)
+{
+  m_flags = ADVERTISE_RECORD;
+  m_hopCount = advertiseHeader.GetHopCount ();
+  m_seqNo = advertiseHeader.GetOriginSeqno ();
+}
+
+AdvertiseHeader
+PiggybackHeader::GetAdvertise (Ipv4Address origin) const
+{
+  NS_ASSERT (HasAdvertise ());
+  return AdvertiseHeader (/*hops=*/ m_hopCount, /*reserved=*/ 0, /*orig=*/ origin, /*seqno=*/ m_seqNo);
+}
+
+void
+PiggybackHeader::SetHello (HelloHeader const & helloHeader)
+{
+  m_flags = HELLO_RECORD;
+  m_hopCount = helloHeader.GetHopCount ();
+  m_seqNo = helloHeader.GetOriginSeqno ();
+  m_minEnergy = helloHeader.GetMinEnergy ();
+  m_minSnr = helloHeader.GetMinSnr ();
+  m_sink = helloHeader.GetOrigin ();
+}
+
+HelloHeader
+PiggybackHeader::GetHello () const
+{
+  NS_ASSERT (HasHello ());
+  return HelloHeader (/*hops=*/ m_hopCount, /*flags=*/ 0, /*Min Energy*/ m_minEnergy, /*Min snr*/ m_minSnr,
+                      /*orig=sink*/ m_sink, /*seqno=*/ m_seqNo);
+}
+
+std::ostream &
+operator<< (std::ostream & os, PiggybackHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+bool
+PiggybackHeader::operator== (PiggybackHeader const & o) const
+{
+  return (m_nextHeader == o.m_nextHeader && m_flags == o.m_flags && m_hopCount == o.m_hopCount
+          && m_reserved == o.m_reserved && m_sender == o.m_sender && m_seqNo == o.m_seqNo
+          && (!HasHello () || (m_minEnergy == o.m_minEnergy && m_minSnr == o.m_minSnr && m_sink == o.m_sink)));
+}
+
+//-----------------------------------------------------------------------------
+// PARENTASSIGN
+//-----------------------------------------------------------------------------
+ParentAssignHeader::ParentAssignHeader (Time lifetime)
+  : m_lifetime (lifetime.GetMilliSeconds ())
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ParentAssignHeader);
+
+TypeId
+ParentAssignHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::ParentAssignHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<ParentAssignHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ParentAssignHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ParentAssignHeader::GetSerializedSize () const
+{
+  return 8 + 8 * GetNodeCount ();
+}
+
+void
+ParentAssignHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (GetNodeCount ());
+  i.WriteU8 (0);
+  i.WriteU16 (0);
+  i.WriteHtonU32 (m_lifetime);
+  for (std::map<Ipv4Address, Ipv4Address>::const_iterator j = m_assignments.begin (); j != m_assignments.end (); ++j)
+    {
+      WriteTo (i, j->first);
+      WriteTo (i, j->second);
+    }
+}
+
+uint32_t
+ParentAssignHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t count = i.ReadU8 ();
+  i.ReadU8 ();
+  i.ReadU16 ();
+  m_lifetime = i.ReadNtohU32 ();
+  m_assignments.clear ();
+  for (uint8_t k = 0; k < count; ++k)
+    {
+      Ipv4Address node;
+      Ipv4Address parent;
+      ReadFrom (i, node);
+      ReadFrom (i, parent);
+      m_assignments.insert (std::make_pair (node, parent));
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ParentAssignHeader::Print (std::ostream &os) const
+{
+  os << "Lifetime " << m_lifetime << " ms, assigned parents (node, parent):";
+  for (std::map<Ipv4Address, Ipv4Address>::const_iterator j = m_assignments.begin (); j != m_assignments.end (); ++j)
+    {
+      os << " (" << j->first << ", " << j->second << ")";
+    }
+}
+
+void
+ParentAssignHeader::SetLifetime (Time t)
+{
+  m_lifetime = t.GetMilliSeconds ();
+}
+
+Time
+ParentAssignHeader::GetLifetime () const
+{
+  return MilliSeconds (m_lifetime);
+}
+
+bool
+ParentAssignHeader::AddAssignment (Ipv4Address node, Ipv4Address parent)
+{
+  if (m_assignments.find (node) == m_assignments.end () && GetNodeCount () >= MAX_ASSIGNMENTS)
+    {
+      return false;
+    }
+  m_assignments[node] = parent;
+  return true;
+}
+
+bool
+ParentAssignHeader::RemoveAssignment (std::pair<Ipv4Address, Ipv4Address> & assignment)
+{
+  if (m_assignments.empty ())
+    {
+      return false;
+    }
+  std::map<Ipv4Address, Ipv4Address>::iterator it = m_assignments.begin ();
+  assignment = *it;
+  m_assignments.erase (it);
+  return true;
+}
+
+void
+ParentAssignHeader::Clear ()
+{
+  m_assignments.clear ();
+}
+
+bool
+ParentAssignHeader::operator== (ParentAssignHeader const & o) const
+{
+  return m_lifetime == o.m_lifetime && m_assignments == o.m_assignments;
+}
+
+std::ostream &
+operator<< (std::ostream & os, ParentAssignHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// SOURCEROUTE
+//-----------------------------------------------------------------------------
+SourceRouteHeader::SourceRouteHeader (uint8_t nextHeader)
+  : m_nextHeader (nextHeader),
+    m_segmentsLeft (0)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (SourceRouteHeader);
+
+TypeId
+SourceRouteHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::SourceRouteHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<SourceRouteHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+SourceRouteHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SourceRouteHeader::GetSerializedSize () const
+{
+  return 4 + 4 * m_relays.size ();
+}
+
+void
+SourceRouteHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_nextHeader);
+  i.WriteU8 (m_segmentsLeft);
+  i.WriteU8 (GetRelayCount ());
+  i.WriteU8 (0);
+  for (std::vector<Ipv4Address>::const_iterator j = m_relays.begin (); j != m_relays.end (); ++j)
+    {
+      WriteTo (i, *j);
+    }
+}
+
+uint32_t
+SourceRouteHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_nextHeader = i.ReadU8 ();
+  m_segmentsLeft = i.ReadU8 ();
+  uint8_t count = i.ReadU8 ();
+  i.ReadU8 ();
+  m_relays.clear ();
+  for (uint8_t k = 0; k < count; ++k)
+    {
+      Ipv4Address relay;
+      ReadFrom (i, relay);
+      m_relays.push_back (relay);
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+SourceRouteHeader::Print (std::ostream &os) const
+{
+  os << "next header " << (uint16_t) m_nextHeader << " segments left " << (uint16_t) m_segmentsLeft << " relays:";
+  for (std::vector<Ipv4Address>::const_iterator j = m_relays.begin (); j != m_relays.end (); ++j)
+    {
+      os << " " << *j;
+    }
+}
+
+bool
+SourceRouteHeader::AddRelay (Ipv4Address relay)
+{
+  if (m_relays.size () == 255)
+    {
+      return false;
+    }
+  m_relays.push_back (relay);
+  m_segmentsLeft++;
+  return true;
+}
+
+bool
+SourceRouteHeader::NextRelay (Ipv4Address & relay)
+{
+  if (m_segmentsLeft == 0 || m_segmentsLeft > m_relays.size ())
+    {
+      return false;
+    }
+  relay = m_relays[m_relays.size () - m_segmentsLeft];
+  m_segmentsLeft--;
+  return true;
+}
+
+bool
+SourceRouteHeader::operator== (SourceRouteHeader const & o) const
+{
+  return m_nextHeader == o.m_nextHeader && m_segmentsLeft == o.m_segmentsLeft && m_relays == o.m_relays;
+}
+
+std::ostream &
+operator<< (std::ostream & os, SourceRouteHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// SCOPEDFLOOD
+//-----------------------------------------------------------------------------
+ScopedFloodHeader::ScopedFloodHeader (uint8_t nextHeader, uint8_t scope, Ipv4Address sender)
+  : m_nextHeader (nextHeader),
+    m_scope (scope),
+    m_sender (sender)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ScopedFloodHeader);
+
+TypeId
+ScopedFloodHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::ScopedFloodHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<ScopedFloodHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ScopedFloodHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ScopedFloodHeader::GetSerializedSize () const
+{
+  return 8;
+}
+
+void
+ScopedFloodHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_nextHeader);
+  i.WriteU8 (m_scope);
+  i.WriteU16 (0);
+  WriteTo (i, m_sender);
+}
+
+uint32_t
+ScopedFloodHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_nextHeader = i.ReadU8 ();
+  m_scope = i.ReadU8 ();
+  i.ReadU16 ();
+  ReadFrom (i, m_sender);
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ScopedFloodHeader::Print (std::ostream &os) const
+{
+  os << "next header " << (uint16_t) m_nextHeader << " scope " << (uint16_t) m_scope << " sender " << m_sender;
+}
+
+bool
+ScopedFloodHeader::operator== (ScopedFloodHeader const & o) const
+{
+  return m_nextHeader == o.m_nextHeader && m_scope == o.m_scope && m_sender == o.m_sender;
+}
+
+std::ostream &
+operator<< (std::ostream & os, ScopedFloodHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// SRVPROBE
+//-----------------------------------------------------------------------------
+
+ServerProbeHeader::ServerProbeHeader (uint32_t seqNo, uint32_t load, bool overloaded)
+  : m_overloaded (overloaded),
+    m_seqNo (seqNo),
+    m_load (load)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ServerProbeHeader);
+
+TypeId
+ServerProbeHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::ServerProbeHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<ServerProbeHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ServerProbeHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ServerProbeHeader::GetSerializedSize () const
+{
+  return 12;
+}
+
+void
+ServerProbeHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_overloaded ? (1 << 7) : 0);
+  i.WriteU8 (0);
+  i.WriteU16 (0);
+  i.WriteHtonU32 (m_seqNo);
+  i.WriteHtonU32 (m_load);
+}
+
+uint32_t
+ServerProbeHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_overloaded = (i.ReadU8 () & (1 << 7));
+  i.ReadU8 ();
+  i.ReadU16 ();
+  m_seqNo = i.ReadNtohU32 ();
+  m_load = i.ReadNtohU32 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ServerProbeHeader::Print (std::ostream &os) const
+{
+  os << "seqno " << m_seqNo << " load " << m_load << " overloaded " << m_overloaded;
+}
+
+bool
+ServerProbeHeader::operator== (ServerProbeHeader const & o) const
+{
+  return m_overloaded == o.m_overloaded && m_seqNo == o.m_seqNo && m_load == o.m_load;
+}
+
+std::ostream &
+operator<< (std::ostream & os, ServerProbeHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// CLUSTERADVERTISE
+//-----------------------------------------------------------------------------
+
+ClusterAdvertiseHeader::ClusterAdvertiseHeader (Ipv4Address head, uint32_t seqNo, uint8_t hopCount)
+  : m_hopCount (hopCount),
+    m_hashes (0),
+    m_cells (0),
+    m_head (head),
+    m_seqNo (seqNo),
+    m_sink (Ipv4Address ())
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ClusterAdvertiseHeader);
+
+TypeId
+ClusterAdvertiseHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::ClusterAdvertiseHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<ClusterAdvertiseHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ClusterAdvertiseHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ClusterAdvertiseHeader::GetSerializedSize () const
+{
+  return 16 + (m_cells + 7) / 8;
+}
+
+void
+ClusterAdvertiseHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_hopCount);
+  i.WriteU8 (m_hashes);
+  i.WriteHtonU16 (m_cells);
+  WriteTo (i, m_head);
+  i.WriteHtonU32 (m_seqNo);
+  WriteTo (i, m_sink);
+  for (uint32_t k = 0; k < (m_cells + 7u) / 8; ++k)
+    {
+      i.WriteU8 (k < m_bits.size () ? m_bits[k] : 0);
+    }
+}
+
+uint32_t
+ClusterAdvertiseHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_hopCount = i.ReadU8 ();
+  m_hashes = i.ReadU8 ();
+  m_cells = i.ReadNtohU16 ();
+  ReadFrom (i, m_head);
+  m_seqNo = i.ReadNtohU32 ();
+  ReadFrom (i, m_sink);
+  m_bits.clear ();
+  for (uint32_t k = 0; k < (m_cells + 7u) / 8; ++k)
+    {
+      m_bits.push_back (i.ReadU8 ());
+    }
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ClusterAdvertiseHeader::Print (std::ostream &os) const
+{
+  os << "cluster head " << m_head << " sequence number " << m_seqNo << " hops " << (uint16_t) m_hopCount
+     << " sink " << m_sink << " cells " << m_cells;
+}
+
+void
+ClusterAdvertiseHeader::SetMembers (uint16_t cells, uint8_t hashes, std::vector<uint8_t> const & bits)
+{
+  m_cells = cells;
+  m_hashes = hashes;
+  m_bits = bits;
+  m_bits.resize ((cells + 7u) / 8, 0);
+}
+
+bool
+ClusterAdvertiseHeader::operator== (ClusterAdvertiseHeader const & o) const
+{
+  return m_hopCount == o.m_hopCount && m_hashes == o.m_hashes && m_cells == o.m_cells && m_head == o.m_head
+         && m_seqNo == o.m_seqNo && m_sink == o.m_sink && m_bits == o.m_bits;
+}
+
+std::ostream &
+operator<< (std::ostream & os, ClusterAdvertiseHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// CONTAINER
+//-----------------------------------------------------------------------------
+
+ContainerHeader::ContainerHeader (uint8_t count)
+  : m_count (count)
+{
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ContainerHeader);
+
+TypeId
+ContainerHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::dmsrp::ContainerHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Dmsrp")
+    .AddConstructor<ContainerHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+ContainerHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+ContainerHeader::GetSerializedSize () const
+{
+  return 4;
+}
+
+void
+ContainerHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 (m_count);
+  i.WriteU8 (0);
+  i.WriteU16 (0);
+}
+
+uint32_t
+ContainerHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  m_count = i.ReadU8 ();
+  i.ReadU8 ();
+  i.ReadU16 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+ContainerHeader::Print (std::ostream &os) const
+{
+  os << "entries " << (uint32_t) m_count;
+}
+
+bool
+ContainerHeader::operator== (ContainerHeader const & o) const
+{
+  return m_count == o.m_count;
+}
+
+std::ostream &
+operator<< (std::ostream & os, ContainerHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
 
 }
 }
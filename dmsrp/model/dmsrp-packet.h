@@ -24,7 +24,9 @@
 #include "ns3/enum.h"
 #include "ns3/ipv4-address.h"
 #include <map>
+#include <vector>
 #include "ns3/nstime.h"
+#include "ns3/vector.h"
 
 namespace ns3 {
 namespace dmsrp {
@@ -45,7 +47,16 @@ enum MessageType
 {
   DMSRPTYPE_HELLO  = 1,   //!< DMSRPTYPE_HELLO//DMS
   DMSRPTYPE_ADVERTISE  = 2,   //!< DMSRPTYPE_ADVERTISE//DMS
-  DMSRPTYPE_SRVADVERTISE  = 3   //!< DMSRPTYPE_SRVADVERTISE//DMS
+  DMSRPTYPE_SRVADVERTISE  = 3,   //!< DMSRPTYPE_SRVADVERTISE//DMS
+  DMSRPTYPE_RERR  = 4,   //!< DMSRPTYPE_RERR
+  DMSRPTYPE_PIGGYBACK  = 5,   //!< DMSRPTYPE_PIGGYBACK (carried by data packets only)
+  DMSRPTYPE_PARENTASSIGN  = 6,   //!< DMSRPTYPE_PARENTASSIGN
+  DMSRPTYPE_SOURCEROUTE  = 7,   //!< DMSRPTYPE_SOURCEROUTE (carried by downlink data packets only)
+  DMSRPTYPE_SCOPEDFLOOD  = 8,   //!< DMSRPTYPE_SCOPEDFLOOD (carried by downlink data packets only)
+  DMSRPTYPE_SRVPROBE  = 9,   //!< DMSRPTYPE_SRVPROBE
+  DMSRPTYPE_SRVPROBE_REPLY  = 10,   //!< DMSRPTYPE_SRVPROBE_REPLY
+  DMSRPTYPE_CLUSTERADVERTISE  = 11,  //!< DMSRPTYPE_CLUSTERADVERTISE
+  DMSRPTYPE_CONTAINER  = 12   //!< DMSRPTYPE_CONTAINER
 };
 
 /**
@@ -112,7 +123,7 @@ std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
   0                   1                   2                   3
   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  |     Type      |   Hop Count   |            Reserved           |
+  |     Type      |   Hop Count   |  Sink Count   |     Flags     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                           Cum Energy                          |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -122,11 +133,120 @@ std::ostream & operator<< (std::ostream & os, TypeHeader const & h);
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                           Sequence Number                     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                 Sink IP Address (1)                           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                 Sink Sequence Number (1)                      |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Hop Count (1) |           Cum Energy (1) ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |               |           Min Snr (1) ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |               |                                ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* The fixed part describes the best route of the sender (to the sink
+* Originator IP Address). It is followed by Sink Count records, one per
+* other sink the sender can reach, so that the neighbors keep a route to
+* every sink.
+*
+* When the CLUSTER flag is set, the records are followed by the cluster
+* election data of the sender:
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |H|                         Reserved                            |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         Cluster Score                         |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+* H is set when the sender is a cluster head.
+*
+* When the LINK_QUALITY flag is set, they are followed by the link estimation
+* data of the sender: the counter of its broadcast Hellos, the ETX of its best
+* route, and the fraction of the Hellos of each neighbor it received (in 255ths):
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |         Hello Counter         |  Link Count   |   Reserved    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                            Path ETX                           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                  Neighbor IP Address (1)                      |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Reception (1) |                      ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* When the AIRTIME flag is set, they are followed by the airtime, in
+* microseconds, a frame of the sender takes to reach the sink along its best route:
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                          Path Airtime                         |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* When the CHANNEL_LOAD flag is set, they are followed by the fraction of the
+* time the sender senses the channel busy (in 255ths):
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Channel Load  |                   Reserved                    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* When the MOBILITY flag is set, they are followed by the position (m) and the
+* velocity (m/s) of the sender in the horizontal plane:
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                               X                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                               Y                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                           Speed X                             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                           Speed Y                             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* When the TX_POWER flag is set, they are followed by the transmit power of the
+* sender, in dBm:
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                           Tx Power                            |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* When the PATH_LIFETIME flag is set, they are followed by the shortest time
+* before depletion predicted for the sender and the nodes of its best route, in
+* seconds:
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         Path Lifetime                         |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* When the SINK_LOAD flag is set, they are followed by the load the sink
+* advertised: the number of nodes it serves and the utilisation of its uplink
+* (in 255ths):
+  \verbatim
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |         Subtree Size          |  Uplink Load  |   Reserved    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   \endverbatim
 */
 class HelloHeader : public Header  // DMS
 {
 public:
+  /// Flags of the Hello message
+  enum Flag
+  {
+    CLUSTER = 1 << 0,   //!< the cluster election data follow the sink records
+    LINK_QUALITY = 1 << 1,   //!< the link estimation data follow
+    AIRTIME = 1 << 2,   //!< the path airtime follows
+    CHANNEL_LOAD = 1 << 3,   //!< the channel load of the sender follows
+    MOBILITY = 1 << 4,   //!< the position and velocity of the sender follow
+    TX_POWER = 1 << 5,   //!< the transmit power of the sender follows
+    PATH_LIFETIME = 1 << 6,   //!< the predicted lifetime of the route of the sender follows
+    SINK_LOAD = 1 << 7,   //!< the load of the sink follows
+  };
   /**
    * constructor
    *
@@ -139,7 +259,7 @@ public:
    * \param origin the origin IP address
    * \param originSeqNo the origin sequence number
    */
-   HelloHeader ( uint8_t hopCount = 0, uint16_t reserved = 0, float minEnergy = 0,float minSnr = 0, Ipv4Address origin = Ipv4Address (), uint32_t HSeqNo = 0);
+   HelloHeader ( uint8_t hopCount = 0, uint8_t flags = 0, float minEnergy = 0,float minSnr = 0, Ipv4Address origin = Ipv4Address (), uint32_t HSeqNo = 0);
 
   /**
    * \brief Get the type ID.
@@ -252,18 +372,239 @@ public:
   {
     return m_HseqNo;
   }
+  /**
+   * \brief Set the message flags
+   * \param flags the flags
+   */
+  void SetFlags (uint8_t flags)
+  {
+    m_flags = flags;
+  }
+  /**
+   * \brief Get the message flags
+   * \return the flags
+   */
+  uint8_t GetFlags () const
+  {
+    return m_flags;
+  }
+
+  /**
+   * \brief Set the cluster election data of the sender, and the CLUSTER flag
+   * \param score the cluster score of the sender
+   * \param head whether the sender is a cluster head
+   */
+  void SetCluster (float score, bool head);
+  /**
+   * \brief Get the cluster score of the sender
+   * \return the score (0 without the CLUSTER flag)
+   */
+  float GetClusterScore () const
+  {
+    return m_clusterScore;
+  }
+  /**
+   * \brief Get the cluster head bit
+   * \return true if the sender is a cluster head
+   */
+  bool IsClusterHead () const
+  {
+    return m_clusterHead;
+  }
+  /**
+   * \brief Set the link estimation data of the sender, and the LINK_QUALITY flag
+   * \param counter the counter of the broadcast Hellos of the sender
+   * \param pathEtx the ETX of the best route of the sender
+   */
+  void SetLinkQuality (uint16_t counter, float pathEtx);
+  /**
+   * \brief Add the fraction of the Hellos of a neighbor the sender received
+   * \param neighbor the neighbor
+   * \param reception the fraction, in 255ths
+   * \return false if the header holds 255 records already
+   */
+  bool AddLinkRecord (Ipv4Address neighbor, uint8_t reception);
+  /**
+   * \brief Get the fraction of the Hellos of a neighbor the sender received
+   * \param neighbor the neighbor
+   * \param reception the fraction, in 255ths
+   * \return false if the sender did not report this neighbor
+   */
+  bool GetLinkRecord (Ipv4Address neighbor, uint8_t & reception) const;
+  /**
+   * \brief Get the counter of the broadcast Hellos of the sender
+   * \return the counter (0 without the LINK_QUALITY flag)
+   */
+  uint16_t GetHelloCounter () const
+  {
+    return m_helloCounter;
+  }
+  /**
+   * \brief Get the ETX of the best route of the sender
+   * \return the path ETX (0 without the LINK_QUALITY flag)
+   */
+  float GetPathEtx () const
+  {
+    return m_pathEtx;
+  }
+  /**
+   * \brief Set the airtime of the best route of the sender, and the AIRTIME flag
+   * \param pathAirtime the airtime, in microseconds
+   */
+  void SetPathAirtime (float pathAirtime);
+  /**
+   * \brief Get the airtime of the best route of the sender
+   * \return the path airtime in microseconds (0 without the AIRTIME flag)
+   */
+  float GetPathAirtime () const
+  {
+    return m_pathAirtime;
+  }
+  /**
+   * \brief Set the channel load of the sender, and the CHANNEL_LOAD flag
+   * \param load the fraction of the time the channel is busy, in 255ths
+   */
+  void SetChannelLoad (uint8_t load);
+  /**
+   * \brief Get the channel load of the sender
+   * \return the fraction of the time the channel is busy, in 255ths (0 without the CHANNEL_LOAD flag)
+   */
+  uint8_t GetChannelLoad () const
+  {
+    return m_channelLoad;
+  }
+  /**
+   * \brief Set the position and velocity of the sender, and the MOBILITY flag
+   * \param position the position (the height is not sent)
+   * \param velocity the velocity (the vertical speed is not sent)
+   */
+  void SetMobility (Vector position, Vector velocity);
+  /**
+   * \brief Get the position of the sender
+   * \return the position (the origin without the MOBILITY flag)
+   */
+  Vector GetPosition () const
+  {
+    return m_position;
+  }
+  /**
+   * \brief Get the velocity of the sender
+   * \return the velocity (zero without the MOBILITY flag)
+   */
+  Vector GetVelocity () const
+  {
+    return m_velocity;
+  }
+  /**
+   * \brief Set the transmit power of the sender, and the TX_POWER flag
+   * \param txPower the transmit power, in dBm
+   */
+  void SetTxPower (float txPower);
+  /**
+   * \brief Get the transmit power of the sender
+   * \return the transmit power in dBm (0 without the TX_POWER flag)
+   */
+  float GetTxPower () const
+  {
+    return m_txPower;
+  }
+  /**
+   * \brief Set the predicted lifetime of the best route of the sender, and the PATH_LIFETIME flag
+   * \param pathLifetime the shortest time before depletion of the sender and the nodes of its route, in seconds
+   */
+  void SetPathLifetime (float pathLifetime);
+  /**
+   * \brief Get the predicted lifetime of the best route of the sender
+   * \return the path lifetime in seconds (0 without the PATH_LIFETIME flag)
+   */
+  float GetPathLifetime () const
+  {
+    return m_pathLifetime;
+  }
+  /**
+   * \brief Set the load of the sink, and the SINK_LOAD flag
+   * \param subtreeSize the number of nodes the sink serves
+   * \param uplinkLoad the utilisation of the uplink of the sink, in 255ths
+   */
+  void SetSinkLoad (uint16_t subtreeSize, uint8_t uplinkLoad);
+  /**
+   * \brief Get the number of nodes the sink serves
+   * \return the subtree size (0 without the SINK_LOAD flag)
+   */
+  uint16_t GetSubtreeSize () const
+  {
+    return m_subtreeSize;
+  }
+  /**
+   * \brief Get the utilisation of the uplink of the sink
+   * \return the uplink load in 255ths (0 without the SINK_LOAD flag)
+   */
+  uint8_t GetUplinkLoad () const
+  {
+    return m_uplinkLoad;
+  }
+
+  /**
+   * \brief Add the route of the sender to another sink
+   * \param route a Hello holding the route (its own sink records are ignored)
+   * \return false if the sink is already described or the header is full
+   */
+  bool AddSinkRecord (HelloHeader const & route);
+  /**
+   * \brief Get the number of other sink records
+   * \return the number of records
+   */
+  uint8_t GetSinkCount () const
+  {
+    return m_sinkRecords.size ();
+  }
+  /**
+   * \brief Get a sink record
+   * \param i the index of the record
+   * \return the record as a Hello for this sink alone
+   */
+  HelloHeader GetSinkRecord (uint8_t i) const;
+  /// Remove the other sink records
+  void ClearSinkRecords ()
+  {
+    m_sinkRecords.clear ();
+  }
 
    bool operator== (HelloHeader const & o) const;
 private:
+  /// Route of the sender to another sink
+  struct SinkRecord
+  {
+    Ipv4Address sink;   ///< Sink IP Address
+    uint32_t seqNo;     ///< Sink sequence number
+    uint8_t hopCount;   ///< Hop Count
+    float minEnergy;    ///< Cum energy
+    float minSnr;       ///< Min snr
+  };
 
   uint8_t        m_hopCount;       ///< Hop Count
-  uint16_t        m_reserved;       ///< Not used (must be 0)
+  uint8_t        m_flags;          ///< Message flags
   float        m_minEnergy;       ///< Not used (must be 0
   float        m_minSnr;       ///< Not used (must be 0
 
  // uint32_t       m_helloID;      ///< HELLO ID
   Ipv4Address    m_origin;         ///< Originator IP Address
   uint32_t       m_HseqNo;    ///< Source Sequence Number
+  std::vector<SinkRecord> m_sinkRecords; ///< Routes to the other sinks
+  bool           m_clusterHead;    ///< Sender is a cluster head (CLUSTER flag)
+  float          m_clusterScore;   ///< Cluster score of the sender (CLUSTER flag)
+  uint16_t       m_helloCounter;   ///< Broadcast Hello counter of the sender (LINK_QUALITY flag)
+  float          m_pathEtx;        ///< ETX of the best route of the sender (LINK_QUALITY flag)
+  /// Hello reception of each neighbor of the sender, in 255ths (LINK_QUALITY flag)
+  std::vector<std::pair<Ipv4Address, uint8_t> > m_linkRecords;
+  float          m_pathAirtime;    ///< Airtime of the best route of the sender, in microseconds (AIRTIME flag)
+  uint8_t        m_channelLoad;    ///< Busy fraction of the channel around the sender, in 255ths (CHANNEL_LOAD flag)
+  Vector         m_position;       ///< Position of the sender (MOBILITY flag)
+  Vector         m_velocity;       ///< Velocity of the sender (MOBILITY flag)
+  float          m_txPower;        ///< Transmit power of the sender, in dBm (TX_POWER flag)
+  float          m_pathLifetime;   ///< Predicted lifetime of the best route of the sender, in seconds (PATH_LIFETIME flag)
+  uint16_t       m_subtreeSize;    ///< Number of nodes the sink serves (SINK_LOAD flag)
+  uint8_t        m_uplinkLoad;     ///< Utilisation of the uplink of the sink, in 255ths (SINK_LOAD flag)
 };
 
 /**
@@ -274,6 +615,113 @@ private:
 std::ostream & operator<< (std::ostream & os, HelloHeader const &);
 
 // DMS ************************************************* ADVERTISE
+/**
+* \ingroup dmsrp
+* \brief Topology report of a node, carried by its Advertise and copied by the sink into the SrvAdvertise
+*
+* The residual energy of the node and, for each of its parents, the parent address and
+* the min SNR of the route through it. The number of parents is carried by the header.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                      Residual energy (float)                  |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         Parent IP Address (1)                 |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         Min SNR (1) (float)                   |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         ...                                   |
+  \endverbatim
+*/
+class TopologyReport
+{
+public:
+  /// constructor
+  TopologyReport ();
+
+  /**
+   * \param energy the residual energy of the node
+   */
+  void SetEnergy (float energy)
+  {
+    m_energy = energy;
+  }
+  /**
+   * \returns the residual energy of the node
+   */
+  float GetEnergy () const
+  {
+    return m_energy;
+  }
+  /**
+   * Add a parent of the node
+   * \param parent the parent address
+   * \param snr the min SNR of the route through the parent
+   * \return false if the parent is already listed or the report is full (255 parents)
+   */
+  bool AddLink (Ipv4Address parent, float snr);
+  /**
+   * \returns the number of parents
+   */
+  uint8_t GetLinkCount () const
+  {
+    return (uint8_t) m_links.size ();
+  }
+  /**
+   * \param i the index of the parent
+   * \returns the address of the parent
+   */
+  Ipv4Address GetParent (uint8_t i) const;
+  /**
+   * \param i the index of the parent
+   * \returns the min SNR of the route through the parent
+   */
+  float GetSnr (uint8_t i) const;
+  /**
+   * \returns true if no parent is listed (the report is not carried)
+   */
+  bool IsEmpty () const
+  {
+    return m_links.empty ();
+  }
+  /// Remove the parents
+  void Clear ();
+  /**
+   * \returns the size of the report on the wire, 0 if empty
+   */
+  uint32_t GetSerializedSize () const;
+  /**
+   * \param i the buffer iterator, moved after the report
+   */
+  void Serialize (Buffer::Iterator & i) const;
+  /**
+   * \param i the buffer iterator, moved after the report
+   * \param linkCount the number of parents, given by the header
+   */
+  void Deserialize (Buffer::Iterator & i, uint8_t linkCount);
+  /**
+   * \param o the report to compare
+   * \return true if the reports are equal
+   */
+  bool operator== (TopologyReport const & o) const;
+  /**
+   * \param o the report to compare
+   * \return true if the reports carry the same parents with the same SNR, whatever the energy
+   */
+  bool HasSameLinks (TopologyReport const & o) const;
+
+private:
+  /// A parent of the node
+  struct Link
+  {
+    Ipv4Address parent;   ///< parent address
+    float snr;            ///< min SNR of the route through the parent
+  };
+  float m_energy;               ///< Residual energy of the node
+  std::vector<Link> m_links;    ///< Parents of the node
+};
+
 /**
 * \ingroup dmsrp
 * \brief   Advertise  Message Format
@@ -281,13 +729,21 @@ std::ostream & operator<< (std::ostream & os, HelloHeader const &);
   0                   1                   2                   3
   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  |     Type      |   Hop Count   |            Reserved           |  
+  |     Type      |   Hop Count   |  Link Count   |  Path Length  |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                     Originator IP Address                     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                           Sequence Number                     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |           Topology report (if Link Count > 0) ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                      Relay IP Address (1)                     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                      ...                                      |
   \endverbatim
+*
+* In the non-storing downlink mode every relay appends its address to the path
+* before forwarding the advertise, so the sink learns the whole branch.
 */
 class AdvertiseHeader : public Header  // DMS
 {
@@ -377,12 +833,45 @@ public:
     return m_AseqNo;
   }
 
+
+  /**
+   * \brief Set the topology report of the origin
+   * \param report the report (not carried if empty)
+   */
+  void SetReport (TopologyReport const & report)
+  {
+    m_report = report;
+  }
+  /**
+   * \brief Get the topology report of the origin
+   * \return the report, empty if none was carried
+   */
+  TopologyReport const & GetReport () const
+  {
+    return m_report;
+  }
+  /**
+   * \brief Append a relay to the recorded path
+   * \param relay the relay address
+   * \return false if the path is full (255 relays)
+   */
+  bool AddRelay (Ipv4Address relay);
+  /**
+   * \brief Get the recorded path
+   * \return the relays, the parent of the origin first
+   */
+  std::vector<Ipv4Address> const & GetPath () const
+  {
+    return m_path;
+  }
+
    bool operator== (AdvertiseHeader const & o) const;
 private:
   uint8_t        m_hopCount;       ///< Hop Count
-  uint16_t        m_reserved;       ///< Not used (must be 0)
   Ipv4Address    m_origin;         ///< Originator IP Address
   uint32_t       m_AseqNo;    ///< Source Sequence Number
+  TopologyReport m_report;         ///< Topology report of the origin
+  std::vector<Ipv4Address> m_path; ///< Relays the advertise went through (non-storing mode)
 };
 
 /**
@@ -406,13 +895,19 @@ std::ostream & operator<< (std::ostream & os, AdvertiseHeader const &);
   0                   1                   2                   3
   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-  |     Type      |   Hop Count   |            Reserved           | 
+  |     Type      |   Hop Count   |  Link Count   | Route Timeout |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                     Originator IP Address                     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                         Sink IP Address                       |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   |                           Sequence Number                     |
   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |           Topology report (if Link Count > 0) ...
   \endverbatim
+*
+* Route Timeout is the time, in tenths of a second, the sink keeps its route
+* to the origin (0: the server uses its own timeout).
 */
 class SrvAdvertiseHeader : public Header  // DMS
 {
@@ -421,7 +916,7 @@ public:
    * constructor
    *
    * \param flags the message flags (0)
-   * \param reserved the reserved bits (0)
+   * \param routeTimeout the route timeout of the sink, in tenths of a second (0)
    * \param hopCount the hop count
    * \param advertiseID the advertise ID
    * \param dst the destination IP address
@@ -429,7 +924,7 @@ public:
    * \param origin the origin IP address
    * \param originSeqNo the origin sequence number
    */
-   SrvAdvertiseHeader (  uint8_t hopCount = 0,uint16_t reserved = 0, Ipv4Address origin = Ipv4Address (),
+   SrvAdvertiseHeader (  uint8_t hopCount = 0,uint8_t routeTimeout = 0, Ipv4Address origin = Ipv4Address (),
                         Ipv4Address sink = Ipv4Address (), uint32_t ASeqNo = 0);
 
   /**
@@ -520,13 +1015,45 @@ public:
     return m_AseqNo;
   }
 
+
+  /**
+   * \brief Set the topology report of the origin
+   * \param report the report (not carried if empty)
+   */
+  void SetReport (TopologyReport const & report)
+  {
+    m_report = report;
+  }
+  /**
+   * \brief Get the topology report of the origin
+   * \return the report, empty if none was carried
+   */
+  TopologyReport const & GetReport () const
+  {
+    return m_report;
+  }
+  /**
+   * \brief Set the time the sink keeps its route to the origin
+   * \param timeout the timeout, rounded up to a tenth of a second and capped at 25.5 s
+   */
+  void SetRouteTimeout (Time timeout);
+  /**
+   * \brief Get the time the sink keeps its route to the origin
+   * \return the timeout (zero if the sink did not give it)
+   */
+  Time GetRouteTimeout () const
+  {
+    return MilliSeconds (100 * m_routeTimeout);
+  }
+
    bool operator== (SrvAdvertiseHeader const & o) const;
 private:
   uint8_t        m_hopCount;       ///< Hop Count
-  uint16_t        m_reserved;       ///< Not used (must be 0)
+  uint8_t        m_routeTimeout;   ///< Route timeout of the sink, in tenths of a second
   Ipv4Address    m_origin;         ///< Originator IP Address
   Ipv4Address    m_sink;         ///< Sink IP Address
   uint32_t       m_AseqNo;    ///< Source Sequence Number
+  TopologyReport m_report;         ///< Topology report of the origin
 };
 
 /**
@@ -539,6 +1066,807 @@ std::ostream & operator<< (std::ostream & os, SrvAdvertiseHeader const &);
 // end ADVERTISESERVER header //////////////////////////////////////////////////////////
 
 
+/**
+* \ingroup dmsrp
+* \brief Route Error (RERR) Message Format
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |     Type      |            Reserved           |   DestCount   |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |            Unreachable Destination IP Address (1)             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |         Unreachable Destination Sequence Number (1)           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Additional Unreachable Destination IP Addresses (if needed)  |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |Additional Unreachable Destination Sequence Numbers (if needed)|
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* A RERR travels up the tree (relay -> parent -> ... -> sink -> server).
+* A sequence number of 0 means the sender did not know the sequence
+* number of the destination (it had no down entry for it).
+*/
+class RerrHeader : public Header
+{
+public:
+  /// constructor
+  RerrHeader ();
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator i) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  // No delete flag
+  /**
+   * Add unreachable node address and its sequence number in RERR header
+   * \param dst unreachable IPv4 address
+   * \param seqNo unreachable sequence number
+   * \return false if we already added maximum possible number of unreachable destinations
+   */
+  bool AddUnDestination (Ipv4Address dst, uint32_t seqNo);
+  /**
+   * \brief Delete pair (address + sequence number) from RERR header, if the number of unreachable destinations > 0
+   * \param un unreachable pair (address + sequence number)
+   * \return true on success
+   */
+  bool RemoveUnDestination (std::pair<Ipv4Address, uint32_t> & un);
+  /// Clear header
+  void Clear ();
+  /**
+   * \returns number of unreachable destinations in RERR message
+   */
+  uint8_t GetDestCount () const
+  {
+    return (uint8_t)m_unreachableDstSeqNo.size ();
+  }
+
+  /**
+   * \brief Comparison operator
+   * \param o RERR header to compare
+   * \return true if the RERR headers are equal
+   */
+  bool operator== (RerrHeader const & o) const;
+private:
+  uint16_t m_reserved;        ///< Not used (must be 0)
+
+  /// List of Unreachable destination: IP addresses and sequence numbers
+  std::map<Ipv4Address, uint32_t> m_unreachableDstSeqNo;
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, RerrHeader const &);
+
+// end RERR header //////////////////////////////////////////////////////////
+
+
+/**
+* \ingroup dmsrp
+* \brief   Piggyback option carried by data packets
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Next Header  |     Flags     |   Hop Count   |   Reserved    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                       Sender IP Address                       |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                        Sequence Number                        |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                  Cum Energy (Hello record only)               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                   Min Snr (Hello record only)                 |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |               Sink IP Address (Hello record only)             |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* The option follows a TypeHeader (DMSRPTYPE_PIGGYBACK) right after the IP
+* header of a data packet; the IP protocol field is then
+* RoutingProtocol::DMSRP_DATA_PROT_NUMBER and Next Header keeps the original one.
+* It is rewritten at every hop and removed before the packet reaches its
+* destination. An uplink packet carries the advertise record of its origin
+* (the IP source), a downlink packet carries the Hello record of the sender.
+*/
+class PiggybackHeader : public Header
+{
+public:
+  /// Record carried by the option
+  enum RecordFlag
+  {
+    ADVERTISE_RECORD = 0x01,  //!< advertise record of the IP source (uplink)
+    HELLO_RECORD = 0x02       //!< Hello record of the sender (downlink)
+  };
+  /**
+   * constructor
+   *
+   * \param nextHeader the protocol of the data packet
+   * \param sender the IP address of the node which added the option
+   */
+  PiggybackHeader (uint8_t nextHeader = 0, Ipv4Address sender = Ipv4Address ());
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Set the protocol of the data packet
+   * \param nextHeader the protocol number
+   */
+  void SetNextHeader (uint8_t nextHeader)
+  {
+    m_nextHeader = nextHeader;
+  }
+  /**
+   * \brief Get the protocol of the data packet
+   * \return the protocol number
+   */
+  uint8_t GetNextHeader () const
+  {
+    return m_nextHeader;
+  }
+  /**
+   * \brief Set the sender address
+   * \param a the sender address
+   */
+  void SetSender (Ipv4Address a)
+  {
+    m_sender = a;
+  }
+  /**
+   * \brief Get the sender address
+   * \return the sender address
+   */
+  Ipv4Address GetSender () const
+  {
+    return m_sender;
+  }
+  /**
+   * \brief Carry the advertise record of the IP source
+   * \param advertiseHeader the record (its origin must be the IP source)
+   */
+  void SetAdvertise (AdvertiseHeader const & advertiseHeader);
+  /**
+   * \brief Get the advertise record
+   * \param origin the IP source of the data packet
+   * \return the record
+   */
+  AdvertiseHeader GetAdvertise (Ipv4Address origin) const;
+  /**
+   * \brief Carry the Hello record of the sender
+   * \param helloHeader the record
+   */
+  void SetHello (HelloHeader const & helloHeader);
+  /**
+   * \brief Get the Hello record
+   * \return the record
+   */
+  HelloHeader GetHello () const;
+  /**
+   * \returns true if an advertise record is carried
+   */
+  bool HasAdvertise () const
+  {
+    return (m_flags & ADVERTISE_RECORD) != 0;
+  }
+  /**
+   * \returns true if a Hello record is carried
+   */
+  bool HasHello () const
+  {
+    return (m_flags & HELLO_RECORD) != 0;
+  }
+  /// Drop the carried record
+  void ClearRecord ()
+  {
+    m_flags = 0;
+  }
+
+  bool operator== (PiggybackHeader const & o) const;
+private:
+  uint8_t        m_nextHeader;     ///< Protocol of the data packet
+  uint8_t        m_flags;          ///< Carried record
+  uint8_t        m_hopCount;       ///< Hop Count of the record
+  uint8_t        m_reserved;       ///< Not used (must be 0)
+  Ipv4Address    m_sender;         ///< Node which added the option
+  uint32_t       m_seqNo;          ///< Sequence Number of the record
+  float          m_minEnergy;      ///< Cum energy of the Hello record
+  float          m_minSnr;         ///< Min snr of the Hello record
+  Ipv4Address    m_sink;           ///< Sink of the Hello record
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, PiggybackHeader const &);
+
+// end PIGGYBACK header //////////////////////////////////////////////////////////
+
+
+/**
+* \ingroup dmsrp
+* \brief Parent Assignment (PARENTASSIGN) Message Format
+*
+* Sent by the server to a sink and forwarded down, split by next hop, until every
+* node receives the parent the server computed for it.
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |   NodeCount   |                   Reserved                    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                        Lifetime (ms)                          |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                      Node IP Address (1)                      |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                     Parent IP Address (1)                     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                     ...                                       |
+  \endverbatim
+*/
+class ParentAssignHeader : public Header
+{
+public:
+  /**
+   * constructor
+   * \param lifetime how long the assignments are valid
+   */
+  ParentAssignHeader (Time lifetime = MilliSeconds (0));
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator i) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \param t how long the assignments are valid
+   */
+  void SetLifetime (Time t);
+  /**
+   * \return how long the assignments are valid
+   */
+  Time GetLifetime () const;
+  /**
+   * Add the parent assigned to a node
+   * \param node the node address
+   * \param parent the assigned parent address
+   * \return false if the message is full
+   */
+  bool AddAssignment (Ipv4Address node, Ipv4Address parent);
+  /**
+   * \brief Remove an assignment (node, parent) from the message, if any
+   * \param assignment the removed assignment
+   * \return true on success
+   */
+  bool RemoveAssignment (std::pair<Ipv4Address, Ipv4Address> & assignment);
+  /// Clear header
+  void Clear ();
+  /**
+   * \returns number of assignments in the message
+   */
+  uint8_t GetNodeCount () const
+  {
+    return (uint8_t) m_assignments.size ();
+  }
+  /**
+   * \brief Comparison operator
+   * \param o header to compare
+   * \return true if the headers are equal
+   */
+  bool operator== (ParentAssignHeader const & o) const;
+
+  /// Maximum number of assignments in one message
+  static const uint8_t MAX_ASSIGNMENTS = 100;
+private:
+  uint32_t m_lifetime;        ///< Lifetime of the assignments (ms)
+  /// Assignments: node -> parent
+  std::map<Ipv4Address, Ipv4Address> m_assignments;
+};
+
+/**
+ * \brief Stream output operator
+ * \param os output stream
+ * \return updated stream
+ */
+std::ostream & operator<< (std::ostream & os, ParentAssignHeader const &);
+
+/**
+* \ingroup dmsrp
+* \brief Source Route option of the downlink data packets (non-storing mode)
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Next Header  | Segments Left |  Relay Count  |   Reserved    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                      Relay IP Address (1)                     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                      ...                                      |
+  \endverbatim
+*
+* The option follows a TypeHeader (DMSRPTYPE_SOURCEROUTE) right after the IP
+* header, like the piggyback option. The sink adds it with the relays to visit
+* after its next hop, in order. Each relay sends the packet to the next relay of
+* the list and decrements Segments Left; the relay that finds Segments Left at 0
+* is the parent of the destination: it removes the option and sends the packet
+* to the IP destination.
+*/
+class SourceRouteHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param nextHeader the protocol of the data packet
+   */
+  SourceRouteHeader (uint8_t nextHeader = 0);
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Set the protocol of the data packet
+   * \param nextHeader the protocol number
+   */
+  void SetNextHeader (uint8_t nextHeader)
+  {
+    m_nextHeader = nextHeader;
+  }
+  /**
+   * \brief Get the protocol of the data packet
+   * \return the protocol number
+   */
+  uint8_t GetNextHeader () const
+  {
+    return m_nextHeader;
+  }
+  /**
+   * \brief Append a relay to visit
+   * \param relay the relay address
+   * \return false if the route is full (255 relays)
+   */
+  bool AddRelay (Ipv4Address relay);
+  /**
+   * \returns the number of relays in the route
+   */
+  uint8_t GetRelayCount () const
+  {
+    return (uint8_t) m_relays.size ();
+  }
+  /**
+   * \returns the number of relays still to visit
+   */
+  uint8_t GetSegmentsLeft () const
+  {
+    return m_segmentsLeft;
+  }
+  /**
+   * \brief Take the next relay to visit
+   * \param relay the next relay
+   * \return false if no relay is left (the destination is the next hop)
+   */
+  bool NextRelay (Ipv4Address & relay);
+
+  bool operator== (SourceRouteHeader const & o) const;
+private:
+  uint8_t        m_nextHeader;     ///< Protocol of the data packet
+  uint8_t        m_segmentsLeft;   ///< Relays still to visit
+  std::vector<Ipv4Address> m_relays; ///< Relays to visit, in order
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, SourceRouteHeader const &);
+
+/**
+* \ingroup dmsrp
+* \brief Scoped Flood option of the downlink data packets (Bloom downlink mode)
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Next Header  |     Scope     |           Reserved            |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                       Sender IP Address                       |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* The option follows a TypeHeader (DMSRPTYPE_SCOPEDFLOOD) right after the IP
+* header. A relay whose children filters miss the destination of a downlink packet
+* broadcasts it with this option. A neighbor whose filters hold the destination
+* removes the option and sends the packet down; the others broadcast it again while
+* Scope (the broadcasts still allowed) is above 0.
+*/
+class ScopedFloodHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param nextHeader the protocol of the data packet
+   * \param scope the broadcasts still allowed after this one
+   * \param sender the IP address of the node which broadcast the packet
+   */
+  ScopedFloodHeader (uint8_t nextHeader = 0, uint8_t scope = 0, Ipv4Address sender = Ipv4Address ());
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Get the protocol of the data packet
+   * \return the protocol number
+   */
+  uint8_t GetNextHeader () const
+  {
+    return m_nextHeader;
+  }
+  /**
+   * \brief Get the broadcasts still allowed
+   * \return the scope
+   */
+  uint8_t GetScope () const
+  {
+    return m_scope;
+  }
+  /**
+   * \brief Get the sender address
+   * \return the sender address
+   */
+  Ipv4Address GetSender () const
+  {
+    return m_sender;
+  }
+
+  bool operator== (ScopedFloodHeader const & o) const;
+private:
+  uint8_t        m_nextHeader;     ///< Protocol of the data packet
+  uint8_t        m_scope;          ///< Broadcasts still allowed
+  Ipv4Address    m_sender;         ///< Node which broadcast the packet
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, ScopedFloodHeader const &);
+
+/**
+* \ingroup dmsrp
+* \brief Server Probe (DMSRPTYPE_SRVPROBE) and Server Probe Reply (DMSRPTYPE_SRVPROBE_REPLY) messages
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |O|                         Reserved                            |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                        Sequence Number                        |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                             Load                              |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* A sink with several servers probes each of them; the reply echoes the sequence
+* number and gives the tunnelled packets per second the server receives (Load).
+* O is set when this load is above the capacity of the server.
+*/
+class ServerProbeHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param seqNo the sequence number of the probe
+   * \param load the tunnelled packets per second received by the server
+   * \param overloaded whether the server is above its capacity
+   */
+  ServerProbeHeader (uint32_t seqNo = 0, uint32_t load = 0, bool overloaded = false);
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Get the sequence number
+   * \return the sequence number of the probe
+   */
+  uint32_t GetSeqNo () const
+  {
+    return m_seqNo;
+  }
+  /**
+   * \brief Get the load of the server
+   * \return the tunnelled packets per second received by the server
+   */
+  uint32_t GetLoad () const
+  {
+    return m_load;
+  }
+  /**
+   * \brief Get the overload flag
+   * \return true if the server is above its capacity
+   */
+  bool IsOverloaded () const
+  {
+    return m_overloaded;
+  }
+
+  bool operator== (ServerProbeHeader const & o) const;
+private:
+  bool           m_overloaded;     ///< Server above its capacity
+  uint32_t       m_seqNo;          ///< Sequence number of the probe
+  uint32_t       m_load;           ///< Tunnelled packets per second received by the server
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, ServerProbeHeader const &);
+
+/**
+* \ingroup dmsrp
+* \brief Cluster Advertise Message Format
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |   Hop Count   |  Hash Count   |          Cell Count           |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                   Cluster Head IP Address                     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                       Sequence Number                         |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                        Sink IP Address                        |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                  Members (Cell Count bits) ...
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* A cluster head keeps the advertises of its cluster to itself and sends up,
+* instead, this summary: a Bloom filter of the nodes it has a down route to.
+* The relays above, the sink and the server keep one entry per cluster. Sink IP
+* Address is set by the sink when it forwards the message to the server.
+*/
+class ClusterAdvertiseHeader : public Header
+{
+public:
+  /**
+   * constructor
+   *
+   * \param head the cluster head
+   * \param seqNo the sequence number of the summary
+   * \param hopCount the hop count
+   */
+  ClusterAdvertiseHeader (Ipv4Address head = Ipv4Address (), uint32_t seqNo = 0, uint8_t hopCount = 0);
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Get the cluster head
+   * \return the cluster head address
+   */
+  Ipv4Address GetHead () const
+  {
+    return m_head;
+  }
+  /**
+   * \brief Get the sequence number
+   * \return the sequence number of the summary
+   */
+  uint32_t GetSeqNo () const
+  {
+    return m_seqNo;
+  }
+  /**
+   * \brief Set the hop count
+   * \param count the hop count
+   */
+  void SetHopCount (uint8_t count)
+  {
+    m_hopCount = count;
+  }
+  /**
+   * \brief Get the hop count
+   * \return the hop count
+   */
+  uint8_t GetHopCount () const
+  {
+    return m_hopCount;
+  }
+  /**
+   * \brief Set the sink the summary went through
+   * \param sink the sink address
+   */
+  void SetSink (Ipv4Address sink)
+  {
+    m_sink = sink;
+  }
+  /**
+   * \brief Get the sink the summary went through
+   * \return the sink address
+   */
+  Ipv4Address GetSink () const
+  {
+    return m_sink;
+  }
+  /**
+   * \brief Set the members filter
+   * \param cells the number of cells of the filter
+   * \param hashes the number of cells set by an address
+   * \param bits the cells, one bit each, the first cell in the high bit of the first byte
+   */
+  void SetMembers (uint16_t cells, uint8_t hashes, std::vector<uint8_t> const & bits);
+  /**
+   * \brief Get the number of cells of the members filter
+   * \return the number of cells
+   */
+  uint16_t GetCellCount () const
+  {
+    return m_cells;
+  }
+  /**
+   * \brief Get the number of cells set by an address
+   * \return the number of hashes
+   */
+  uint8_t GetHashCount () const
+  {
+    return m_hashes;
+  }
+  /**
+   * \brief Get the cells of the members filter
+   * \return one bit per cell
+   */
+  std::vector<uint8_t> const & GetMembers () const
+  {
+    return m_bits;
+  }
+
+  bool operator== (ClusterAdvertiseHeader const & o) const;
+private:
+  uint8_t        m_hopCount;       ///< Hop Count
+  uint8_t        m_hashes;         ///< Cells set by an address
+  uint16_t       m_cells;          ///< Cells of the members filter
+  Ipv4Address    m_head;           ///< Cluster head
+  uint32_t       m_seqNo;          ///< Sequence number of the summary
+  Ipv4Address    m_sink;           ///< Sink the summary went through
+  std::vector<uint8_t> m_bits;     ///< Members filter, one bit per cell
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, ClusterAdvertiseHeader const &);
+
+/**
+* \ingroup dmsrp
+* \brief Container Format
+  \verbatim
+  0                   1                   2                   3
+  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Entry Count  |                   Reserved                    |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                IP header and payload of entry 1               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                              ...                              |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+*
+* Payload of a data packet carrying several small uplink packets to the same next
+* hop and destination. The entries follow the header; each entry is a whole IP
+* packet, whose header gives the size.
+*/
+class ContainerHeader : public Header
+{
+public:
+  /// Most entries of a container
+  static const uint8_t MAX_COUNT = 255;
+
+  /**
+   * constructor
+   *
+   * \param count the number of entries
+   */
+  ContainerHeader (uint8_t count = 0);
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Get the number of entries
+   * \return the number of packets in the container
+   */
+  uint8_t GetCount () const
+  {
+    return m_count;
+  }
+
+  bool operator== (ContainerHeader const & o) const;
+private:
+  uint8_t        m_count;          ///< Number of entries
+};
+
+/**
+  * \brief Stream output operator
+  * \param os output stream
+  * \return updated stream
+  */
+std::ostream & operator<< (std::ostream & os, ContainerHeader const &);
 
 }  // namespace dmsrp
 }  // namespace ns3
@@ -32,19 +32,28 @@
 #include "dmsrp-routing-protocol.h"
 #include "ns3/log.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/udp-socket-factory.h"
 #include "ns3/udp-l4-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
 #include "ns3/udp-header.h"
 #include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/wifi-remote-station-manager.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-phy-state-helper.h"
+#include "ns3/mobility-model.h"
 #include "ns3/adhoc-wifi-mac.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/energy-module.h" //DMS
 #include <algorithm>
+#include <cmath>
 #include <limits>
+#include <sstream>
 
 namespace ns3 {
 
@@ -55,20 +64,153 @@ NS_OBJECT_ENSURE_REGISTERED (RoutingProtocol);
 
 /// UDP Port for DMSRP control traffic
 const uint32_t RoutingProtocol::DMSRP_PORT = 651;
+/// IP protocol number of the IP-in-IP tunnel between the sinks and the server
+const uint8_t RoutingProtocol::DMSRP_TUNNEL_PROT_NUMBER = 4;
+/// IP protocol number of data packets carrying a DMSRP option (experimental number, RFC 3692)
+const uint8_t RoutingProtocol::DMSRP_DATA_PROT_NUMBER = 253;
+/// Airtime of a link the station manager knows no rate for, or which loses every frame, in microseconds
+static const double MAX_AIRTIME = 1e6;
+/// Path lifetime advertised while nothing is drained, in seconds
+static const double MAX_PATH_LIFETIME = 1e9;
+
+//-----------------------------------------------------------------------------
+/// Tag used by DMSRP implementation
+class PiggybackTag : public Tag
+{
+
+public:
+  /// Constructor
+  PiggybackTag ()
+    : Tag ()
+  {
+  }
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId ()
+  {
+    static TypeId tid = TypeId ("ns3::dmsrp::PiggybackTag")
+      .SetParent<Tag> ()
+      .SetGroupName ("Dmsrp")
+      .AddConstructor<PiggybackTag> ()
+    ;
+    return tid;
+  }
+
+  TypeId  GetInstanceTypeId () const
+  {
+    return GetTypeId ();
+  }
+
+  uint32_t GetSerializedSize () const
+  {
+    return 0;
+  }
+
+  void  Serialize (TagBuffer) const
+  {
+  }
+
+  void  Deserialize (TagBuffer)
+  {
+  }
+
+  void  Print (std::ostream &os) const
+  {
+    os << "PiggybackTag";
+  }
+};
+
+NS_OBJECT_ENSURE_REGISTERED (PiggybackTag);
 
 
 
 //-----------------------------------------------------------------------------
 RoutingProtocol::RoutingProtocol ()
   : m_activeRouteTimeout (Seconds (6)),
+    m_adaptiveRouteTimeout (false),
+    m_minRouteTimeout (Seconds (2)),
+    m_maxRouteTimeout (Seconds (20)),
+    m_routeTimeoutDistance (100),
+    m_enableLinkLayerFeedback (true),
+    m_enablePiggyback (false),
+    m_piggybackFreshness (Seconds (1)),
+    m_controlTxBatching (true),
+    m_enableTopologyReport (false),
+    m_topologyInterval (Seconds (10)),
     m_seqNo (0),
+    m_rerrRateLimit (10),
+    m_rerrCount (0),
     m_hellotimer (Timer::CANCEL_ON_DESTROY),
     m_advertisetimer (Timer::CANCEL_ON_DESTROY),
+    m_advertisePiggybacked (false),
+    m_helloSuppressed (false),
+    m_rerrRateLimitTimer (Timer::CANCEL_ON_DESTROY),
+    m_topologyTimer (Timer::CANCEL_ON_DESTROY),
+    m_sinkQueueTimer (Timer::CANCEL_ON_DESTROY),
+    m_srvProbeTimer (Timer::CANCEL_ON_DESTROY),
   //  m_routingMode (MULTI_PARENT_MODE),     //DMS 
     m_routingTableUp (),     //DMS   //m_routingMode (3 modes):  BASIC_MODE , MULTI_PARENT_MODE , ENERGY_AWARE_MULTI_PARENT_MODE , SNR_AWARE_MULTI_PARENT_MODE
     m_routingTableDown (m_activeRouteTimeout),     //DMS
+    m_routingTableServer (),
     m_maxHelloHops(1000),  // DMS added by DMS
     m_maxAdvertiseHops(1000),  // DMS added by DMS
+    m_maxHelloSinks (4),
+    m_sinkSelection (FEWEST_HOPS),
+    m_maxSinkCandidates (4),
+    m_sinkDeadInterval (Seconds (5)),
+    m_downlinkMode (STORING),
+    m_bloomFilterSize (256),
+    m_bloomHashCount (3),
+    m_bloomBroadcastScope (2),
+    m_srvAdvertiseRefresh (Seconds (0)),
+    m_enableSinkAqm (false),
+    m_sinkUplinkRate (DataRate ("0bps")),
+    m_sinkAqmTarget (MilliSeconds (5)),
+    m_sinkAqmInterval (MilliSeconds (100)),
+    m_sinkQueueLimit (1000),
+    m_serverAddresses (""),
+    m_serverProbeInterval (Seconds (1)),
+    m_serverDeadInterval (Seconds (3)),
+    m_serverDistribution (REPLICATE),
+    m_serverCapacity (0),
+    m_srvProbeSeqNo (0),
+    m_srvLoadCount (0),
+    m_srvLoad (0),
+    m_srvLoadStart (Seconds (0)),
+    m_enableClusters (false),
+    m_clusterHysteresis (0.2),
+    m_clusterMinEnergy (0.2),
+    m_clusterFilterSize (512),
+    m_isClusterHead (false),
+    m_clusterScore (0),
+    m_clusterSeqNo (0),
+    m_enableAggregation (false),
+    m_aggregationWindow (MilliSeconds (20)),
+    m_aggregationMaxSize (1024),
+    m_aggregationMaxPacketSize (256),
+    m_linkWindow (16),
+    m_helloCounter (0),
+    m_airtimeOverhead (MicroSeconds (75)),
+    m_airtimeTestFrameSize (1024),
+    m_channelLoadSmoothing (0.3),
+    m_transmissionRange (250),
+    m_enableBackupParent (false),
+    m_enablePowerControl (false),
+    m_minTxPower (0),
+    m_maxTxPower (7.5),
+    m_targetSnr (10),
+    m_powerMargin (3),
+    m_txPower (7.5),
+    m_energySampleInterval (Seconds (1)),
+    m_energyDrainSmoothing (0.2),
+    m_sinkLoadBalancing (false),
+    m_sinkLoadHysteresis (0.2),
+    m_sinkUplinkBytes (0),
+    m_sinkUplinkSample (Seconds (0)),
+    m_sinkUplinkLoad (0),
     m_helloTimerExpire(Seconds (5)), //DMS 
     m_advertiseTimerExpire(Seconds (4)) //DMS
 
@@ -87,6 +229,22 @@ RoutingProtocol::GetTypeId (void)
                    TimeValue (Seconds (6)),
                    MakeTimeAccessor (&RoutingProtocol::m_activeRouteTimeout),
                    MakeTimeChecker ())
+    .AddAttribute ("AdaptiveRouteTimeout", "Indicates whether the timeout of a route follows the relative speed of this node and the next hop, instead of ActiveRouteTimeout.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_adaptiveRouteTimeout),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MinRouteTimeout", "Shortest adaptive route timeout. Keep it above the Hello and advertise periods.",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&RoutingProtocol::m_minRouteTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxRouteTimeout", "Longest adaptive route timeout, that of the routes between still nodes.",
+                   TimeValue (Seconds (20)),
+                   MakeTimeAccessor (&RoutingProtocol::m_maxRouteTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("RouteTimeoutDistance", "Distance in meters the next hop may move relatively to this node before a route through it is stale (adaptive route timeouts).",
+                   DoubleValue (100),
+                   MakeDoubleAccessor (&RoutingProtocol::m_routeTimeoutDistance),
+                   MakeDoubleChecker<double> (0))
     .AddAttribute ("EnableBroadcast", "Indicates whether a broadcast data packets forwarding enable.",
                    BooleanValue (true),
                    MakeBooleanAccessor (&RoutingProtocol::SetBroadcastEnable,
@@ -122,14 +280,86 @@ RoutingProtocol::GetTypeId (void)
                    StringValue ("ns3::NetDevice"),
                    MakePointerAccessor (&RoutingProtocol::m_sinkOutPutDevice),
                    MakePointerChecker<NetDevice> ())
-    .AddAttribute ("SnrWeight", "Snr wheight (importance)",
-                   DoubleValue (0.0),
+    .AddAttribute ("SnrWeight", "Snr wheight (importance) in the composite mode",
+                   DoubleValue (0.4),
                    MakeDoubleAccessor (&RoutingProtocol::m_snrWeight),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("EnergyWeight", "Energy wheight (importance) in the composite mode",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&RoutingProtocol::m_energyWeight),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("HopWeight", "Hop count wheight (importance) in the composite mode",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&RoutingProtocol::m_hopWeight),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LifetimeWeight", "Route lifetime wheight (importance) in the composite mode",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&RoutingProtocol::m_lifetimeWeight),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("ParentHysteresis", "Relative margin by which a candidate must beat the current parent to replace it, in the composite mode.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&RoutingProtocol::m_parentHysteresis),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("EnableBackupParent", "Indicates whether a loop-free backup parent is kept, and takes over as soon as the parent is lost.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableBackupParent),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LinkWindow", "Number of last Hellos of a neighbor the reception ratio of its link is computed on (ETX mode).",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&RoutingProtocol::m_linkWindow),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("AirtimeOverhead", "Channel access and protocol overhead added to the transmission time of a frame (airtime mode).",
+                   TimeValue (MicroSeconds (75)),
+                   MakeTimeAccessor (&RoutingProtocol::m_airtimeOverhead),
+                   MakeTimeChecker ())
+    .AddAttribute ("AirtimeTestFrameSize", "Size in bytes of the test frame the airtime of a link is computed for (airtime mode).",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&RoutingProtocol::m_airtimeTestFrameSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ChannelLoadSmoothing", "Weight of a new sample, taken at each Hello, in the channel busy fraction a node advertises.",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&RoutingProtocol::m_channelLoadSmoothing),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("TransmissionRange", "Distance in meters beyond which two nodes are predicted to lose their link (link lifetime mode).",
+                   DoubleValue (250),
+                   MakeDoubleAccessor (&RoutingProtocol::m_transmissionRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("EnablePowerControl", "Indicates whether the transmit power is lowered to the one the next hops need to receive with TargetSnr plus PowerMargin.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enablePowerControl),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MinTxPower", "Lowest transmit power in dBm (power control).",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&RoutingProtocol::m_minTxPower),
                    MakeDoubleChecker<double> ())
-    .AddAttribute ("EnergyWeight", "Energy wheight (importance)",
-                   DoubleValue (0.0),
-                   MakeDoubleAccessor (&RoutingProtocol::m_snrWeight),
+    .AddAttribute ("MaxTxPower", "Highest transmit power in dBm, used while the next hops are unknown (power control). The transmit current set on the devices is drawn at this power.",
+                   DoubleValue (7.5),
+                   MakeDoubleAccessor (&RoutingProtocol::m_maxTxPower),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("TargetSnr", "SNR in dB the next hops should receive the frames with, given the PHY mode (power control).",
+                   DoubleValue (10),
+                   MakeDoubleAccessor (&RoutingProtocol::m_targetSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("PowerMargin", "Margin in dB added to TargetSnr against fading and motion (power control).",
+                   DoubleValue (3),
+                   MakeDoubleAccessor (&RoutingProtocol::m_powerMargin),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("EnergySampleInterval", "Time between two readings of the energy source; the control messages use the last one.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_energySampleInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("EnergyDrainSmoothing", "Weight of a new reading in the smoothed drain rate the lifetime of a node is predicted from.",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&RoutingProtocol::m_energyDrainSmoothing),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("SinkLoadBalancing", "Indicates whether the sinks advertise the nodes they serve and the utilisation of their uplink, and the nodes prefer the least loaded sink.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_sinkLoadBalancing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SinkLoadHysteresis", "Relative margin by which another sink must be less loaded than the current one to replace it (sink load balancing).",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&RoutingProtocol::m_sinkLoadHysteresis),
+                   MakeDoubleChecker<double> (0, 1))
     .AddAttribute ("Routingmode", "Routing mode",
                    UintegerValue (SNR_AWARE_MULTI_PARENT_MODE),
                    MakeUintegerAccessor (&RoutingProtocol::m_routingMode),
@@ -138,9 +368,188 @@ RoutingProtocol::GetTypeId (void)
                    UintegerValue (SNR_AWARE_MULTI_PARENT_MODE),
                    MakeUintegerAccessor (&RoutingProtocol::m_rngRep),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RerrRateLimit", "Maximum number of RERR per second.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&RoutingProtocol::m_rerrRateLimit),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("EnableLinkLayerFeedback", "Indicates whether MAC transmission failures are used to detect broken links.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableLinkLayerFeedback),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxTxFailures", "Number of consecutive unicast frames dropped by the MAC after which a neighbor is declared lost.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RoutingProtocol::SetMaxTxFailures,
+                                         &RoutingProtocol::GetMaxTxFailures),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("EnablePiggyback", "Indicates whether Hello and advertise records are piggybacked on data packets.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enablePiggyback),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PiggybackFreshness", "Age under which piggybacked control information suppresses the standalone Hello/Advertise.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_piggybackFreshness),
+                   MakeTimeChecker ())
+    .AddAttribute ("ControlTxBatching", "Indicates whether the control packets of a round are sent from a single jittered event.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&RoutingProtocol::m_controlTxBatching),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EnableTopologyReport", "Indicates whether the advertises carry the residual energy and the parents of their origin up to the server.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableTopologyReport),
+                   MakeBooleanChecker ())
+    .AddAttribute ("TopologyInterval", "Period of the parent computation at the server (CENTRALIZED_MODE).",
+                   TimeValue (Seconds (10)),
+                   MakeTimeAccessor (&RoutingProtocol::m_topologyInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxHelloSinks", "Maximum number of sinks described in a Hello (the one in use included).",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxHelloSinks),
+                   MakeUintegerChecker<uint32_t> (1, 256))
+    .AddAttribute ("ServerSinkSelection", "How the server selects the sink of a downlink packet among the candidate sinks of its destination.",
+                   EnumValue (FEWEST_HOPS),
+                   MakeEnumAccessor (&RoutingProtocol::m_sinkSelection),
+                   MakeEnumChecker (FEWEST_HOPS, "FewestHops",
+                                    LEAST_LOADED, "LeastLoaded",
+                                    FRESHEST, "Freshest"))
+    .AddAttribute ("MaxSinkCandidates", "Maximum number of candidate sinks the server keeps per destination.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&RoutingProtocol::m_maxSinkCandidates),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SinkDeadInterval", "Time without any SrvAdvertise after which the server considers a sink dead (zero: never). Keep it above the advertise period.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::m_sinkDeadInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("DownlinkMode", "Whether every relay keeps the down routes of its subtree (Storing) or only the sinks do and the downlink packets carry a source route (NonStoring).",
+                   EnumValue (STORING),
+                   MakeEnumAccessor (&RoutingProtocol::m_downlinkMode),
+                   MakeEnumChecker (STORING, "Storing",
+                                    NON_STORING, "NonStoring",
+                                    BLOOM, "Bloom"))
+    .AddAttribute ("BloomFilterSize", "Number of cells of the descendant filter a relay keeps per child (Bloom downlink mode).",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::m_bloomFilterSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BloomHashCount", "Number of cells an address sets in a descendant filter.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&RoutingProtocol::m_bloomHashCount),
+                   MakeUintegerChecker<uint32_t> (1, 16))
+    .AddAttribute ("BloomBroadcastScope", "Number of broadcast hops of a downlink packet whose destination misses the descendant filters (0: drop it).",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&RoutingProtocol::m_bloomBroadcastScope),
+                   MakeUintegerChecker<uint8_t> ())
+    .AddAttribute ("SrvAdvertiseRefresh", "Period after which a sink forwards again to the server an advertise that brings nothing new (zero: forward every new advertise). Keep it plus the advertise period below ActiveRouteTimeout.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&RoutingProtocol::m_srvAdvertiseRefresh),
+                   MakeTimeChecker ())
+    .AddAttribute ("EnableSinkAqm", "Indicates whether a sink queues the packets it tunnels to the server, per origin with CoDel, instead of handing them to its output device at once.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableSinkAqm),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SinkUplinkRate", "Rate the sink queue is served at (0: the DataRate attribute of the sink output device).",
+                   DataRateValue (DataRate ("0bps")),
+                   MakeDataRateAccessor (&RoutingProtocol::m_sinkUplinkRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("SinkAqmTarget", "Acceptable sojourn time in the sink queue (CoDel target).",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&RoutingProtocol::m_sinkAqmTarget),
+                   MakeTimeChecker ())
+    .AddAttribute ("SinkAqmInterval", "Time the sojourn time may stay above the target before the sink queue drops (CoDel interval).",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&RoutingProtocol::m_sinkAqmInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("SinkQueueLimit", "Maximum number of packets in the sink queue.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&RoutingProtocol::m_sinkQueueLimit),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("ServerAddresses", "Servers of a sink beside ServerAddress, separated by spaces or commas. They must be reachable over the sink output device.",
+                   StringValue (""),
+                   MakeStringAccessor (&RoutingProtocol::m_serverAddresses),
+                   MakeStringChecker ())
+    .AddAttribute ("ServerProbeInterval", "Period of the probes a sink with several servers sends to each of them.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&RoutingProtocol::m_serverProbeInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("ServerDeadInterval", "Time without probe reply after which a sink stops using a server.",
+                   TimeValue (Seconds (3)),
+                   MakeTimeAccessor (&RoutingProtocol::m_serverDeadInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("SrvAdvertiseDistribution", "Whether a sink sends every advertise to all its servers and spreads the flows by hash (Replicate), or sends the advertises of a node to one server and the packets to a node to the same server (Partition).",
+                   EnumValue (REPLICATE),
+                   MakeEnumAccessor (&RoutingProtocol::m_serverDistribution),
+                   MakeEnumChecker (REPLICATE, "Replicate",
+                                    PARTITION, "Partition"))
+    .AddAttribute ("ServerCapacity", "Tunnelled packets per second above which a server tells the sinks it is overloaded (0: never).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RoutingProtocol::m_serverCapacity),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EnableClusters", "Indicates whether the nodes elect cluster heads, which keep the advertises of their cluster and send a summary up (Storing downlink mode).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableClusters),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ClusterHysteresis", "Relative margin by which the cluster score of a node must beat its neighbors to become cluster head, and may trail them before it resigns.",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&RoutingProtocol::m_clusterHysteresis),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("ClusterMinEnergy", "Fraction of its initial energy under which a cluster head resigns.",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&RoutingProtocol::m_clusterMinEnergy),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("ClusterFilterSize", "Number of cells of the members filter a cluster head sends up.",
+                   UintegerValue (512),
+                   MakeUintegerAccessor (&RoutingProtocol::m_clusterFilterSize),
+                   MakeUintegerChecker<uint32_t> (8, 8192))
+    .AddAttribute ("EnableAggregation", "Indicates whether the nodes send their small uplink packets, and the ones they forward, in containers.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RoutingProtocol::m_enableAggregation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("AggregationWindow", "How long the first packet of a container waits for the others.",
+                   TimeValue (MilliSeconds (20)),
+                   MakeTimeAccessor (&RoutingProtocol::m_aggregationWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("AggregationMaxSize", "Maximum size of a container in bytes, without its own IP header.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&RoutingProtocol::m_aggregationMaxSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AggregationMaxPacketSize", "Largest packet, IP header included, put in a container.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&RoutingProtocol::m_aggregationMaxPacketSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("DepTime", "Depletion Time",
                    MakeTraceSourceAccessor (&RoutingProtocol::m_depTimeTrace),
                    "ns3::dmsrp::RoutingProtocol::TableChangeTracedCallback")
+    .AddTraceSource ("BloomLookup", "A relay looked up the destination of a downlink packet in the descendant filters.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_bloomLookupTrace),
+                   "ns3::dmsrp::RoutingProtocol::BloomLookupTracedCallback")
+    .AddTraceSource ("BloomFalsePositive", "A downlink packet reached a relay whose subtree does not hold its destination.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_bloomFalsePositiveTrace),
+                   "ns3::dmsrp::RoutingProtocol::BloomFalsePositiveTracedCallback")
+    .AddTraceSource ("ControlTx", "A node used one send event for one or more control packets, given their number.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_controlTxTrace),
+                   "ns3::dmsrp::RoutingProtocol::ControlTxTracedCallback")
+    .AddTraceSource ("SrvAdvertiseSuppressed", "A sink did not forward an advertise to the server, it brought nothing new.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_srvAdvertiseSuppressedTrace),
+                   "ns3::dmsrp::RoutingProtocol::SrvAdvertiseSuppressedTracedCallback")
+    .AddTraceSource ("SinkQueueSojourn", "A packet left the uplink queue of a sink.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_sinkQueueSojournTrace),
+                   "ns3::dmsrp::RoutingProtocol::SinkQueueSojournTracedCallback")
+    .AddTraceSource ("SinkQueueDrop", "The uplink queue of a sink dropped a packet.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_sinkQueueDropTrace),
+                   "ns3::dmsrp::RoutingProtocol::SinkQueueDropTracedCallback")
+    .AddTraceSource ("ServerState", "A server of a sink stopped answering the probes, or answers again.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_serverStateTrace),
+                   "ns3::dmsrp::RoutingProtocol::ServerStateTracedCallback")
+    .AddTraceSource ("ClusterRole", "The node became cluster head, or resigned.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_clusterRoleTrace),
+                   "ns3::dmsrp::RoutingProtocol::ClusterRoleTracedCallback")
+    .AddTraceSource ("Aggregation", "Small uplink packets left together, in a container or alone.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_aggregationTrace),
+                   "ns3::dmsrp::RoutingProtocol::AggregationTracedCallback")
+    .AddTraceSource ("ParentChange", "The best route to the sink goes through another parent.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_parentChangeTrace),
+                   "ns3::dmsrp::RoutingProtocol::ParentChangeTracedCallback")
+    .AddTraceSource ("UplinkOutage", "The node has a route to the sink again after losing its parent.",
+                   MakeTraceSourceAccessor (&RoutingProtocol::m_uplinkOutageTrace),
+                   "ns3::dmsrp::RoutingProtocol::UplinkOutageTracedCallback")
 
   ; 
   return tid;
@@ -156,6 +565,11 @@ void
 RoutingProtocol::DoDispose ()
 {
   m_ipv4 = 0;
+  m_txEvent.Cancel ();
+  m_txQueue.clear ();
+  m_sinkQueue.Clear ();
+  m_aggregator.Clear ();
+  m_energyMonitor.Stop ();
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::iterator iter =
          m_socketAddresses.begin (); iter != m_socketAddresses.end (); iter++)
     {
@@ -180,6 +594,10 @@ RoutingProtocol::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit
                         << ", DMSRP Routing table" << std::endl;
 
   m_routingTableDown.Print (stream);
+  if (m_isServer)
+    {
+      m_routingTableServer.Print (stream);
+    }
   *stream->GetStream () << std::endl;
 }
 
@@ -195,7 +613,10 @@ void
 RoutingProtocol::Start ()
 {
   NS_LOG_FUNCTION (this);
-
+  m_nb.SetCallback (MakeCallback (&RoutingProtocol::SendRerrWhenBreaksLinkToNextHop, this));
+  m_rerrRateLimitTimer.SetFunction (&RoutingProtocol::RerrRateLimitTimerExpire,
+                                    this);
+  m_rerrRateLimitTimer.Schedule (Seconds (1));
 
 }
 
@@ -226,7 +647,7 @@ origin = header.GetSource ();
   RoutingTableEntryUp rtUp;
 
 
-                 if (m_routingTableDown.LookupRoute (dst, rt))
+                 if (LookupDownRoute (dst, rt))
                     {
 
                       
@@ -242,11 +663,34 @@ origin = header.GetSource ();
                           sockerr = Socket::ERROR_NOROUTETOHOST;
                           return Ptr<Ipv4Route> ();
                         }
+                      if (m_downlinkMode == NON_STORING && rt.GetNextHop () != dst)
+                        {
+                          // the packet comes back fully formed through RouteInput, where the source route is added
+                          PiggybackTag tag;
+                          if (!p->PeekPacketTag (tag))
+                            {
+                              p->AddPacketTag (tag);
+                            }
+                          return LoopbackRoute (header, oif);
+                        }
 
          //    NS_LOG_UNCOND ("OUT packet : origin "<<origin << " dst " << dst <<"  "<<Simulator::Now ());  ////DMS2 
                       return route;
                     }
 
+             if (m_isServer && LookupServerRoute (dst, rt))
+              {
+                 route = rt.GetRoute ();
+                 if (oif != 0 && route->GetOutputDevice () != oif)
+                   {
+                     NS_LOG_DEBUG ("Output device doesn't match. Dropped.");
+                     sockerr = Socket::ERROR_NOROUTETOHOST;
+                     return Ptr<Ipv4Route> ();
+                   }
+                 m_routingTableServer.NotifyForwarded (rt.GetNextHop ());
+                 return route;
+              }
+
              if (!m_isServer)
               {
                  if (!m_routingTableUp.IsEmpty())
@@ -265,6 +709,32 @@ origin = header.GetSource ();
                           sockerr = Socket::ERROR_NOROUTETOHOST;
                           return Ptr<Ipv4Route> ();
                         }
+                      if (m_enablePiggyback && m_downlinkMode == STORING && !m_isSink && route->GetGateway () != dst
+                          && Simulator::Now () - m_lastAdvertise >= m_piggybackFreshness / 2)
+                        {
+                          // the packet comes back fully formed through RouteInput, where the advertise record is added
+                          PiggybackTag tag;
+                          if (!p->PeekPacketTag (tag))
+                            {
+                              p->AddPacketTag (tag);
+                            }
+                          return LoopbackRoute (header, oif);
+                        }
+                      if (m_enableAggregation && !m_isSink
+                          && p->GetSize () + header.GetSerializedSize () <= m_aggregationMaxPacketSize)
+                        {
+                          // the packet comes back through RouteInput and waits for its container
+                          PiggybackTag tag;
+                          if (!p->PeekPacketTag (tag))
+                            {
+                              p->AddPacketTag (tag);
+                            }
+                          return LoopbackRoute (header, oif);
+                        }
+                      if (m_isSink && dst != route->GetGateway () && m_servers.Contains (dst))
+                        {
+                          return RouteToServer (route, dst);
+                        }
                       return route;
                     }
               }
@@ -297,9 +767,53 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
   NS_ASSERT (m_ipv4->GetInterfaceForDevice (idev) >= 0);
   int32_t iif = m_ipv4->GetInterfaceForDevice (idev);
 
+  if (idev == m_lo)
+    {
+      PiggybackTag tag;
+      if (p->PeekPacketTag (tag))
+        {
+          // packet of this node deferred by RouteOutput to add a DMSRP option (advertise record, source route)
+          Ptr<Packet> packet = p->Copy ();
+          packet->RemovePacketTag (tag);
+          return Forwarding (packet, header, ucb, ecb, false);
+        }
+    }
+
+  if (header.GetProtocol () == DMSRP_DATA_PROT_NUMBER && !m_isServer)
+    {
+      TypeHeader tHeader;
+      p->PeekHeader (tHeader);
+      if (tHeader.IsValid () && tHeader.Get () == DMSRPTYPE_CONTAINER)
+        {
+          return RecvContainer (p, header, idev, ucb, mcb, lcb, ecb);
+        }
+    }
+
+  if (header.GetProtocol () == DMSRP_DATA_PROT_NUMBER && m_downlinkMode != STORING && !m_isSink && !m_isServer)
+    {
+      TypeHeader tHeader;
+      p->PeekHeader (tHeader);
+      if (tHeader.IsValid () && tHeader.Get () == DMSRPTYPE_SOURCEROUTE)
+        {
+          return ForwardSourceRoute (p, header, iif, ucb, ecb);
+        }
+      if (tHeader.IsValid () && tHeader.Get () == DMSRPTYPE_SCOPEDFLOOD)
+        {
+          return RecvScopedFlood (p, header, iif, ucb, lcb);
+        }
+    }
 
         Ipv4Header header2;
         Ptr<Packet> p2 = p->Copy();
+        Ipv4Header header3 = header;
+        PiggybackHeader carried;
+        if (header.GetProtocol () == DMSRP_DATA_PROT_NUMBER && !m_isServer)
+        {
+          if (!RecvPiggyback (p2, header3, m_ipv4->GetAddress (iif, 0).GetLocal (), carried))
+            {
+              return false;
+            }
+        }
         //NS_LOG_UNCOND ("Packet size: "<<p->GetSize());
 
 
@@ -316,6 +830,10 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
 
         }*/
 
+       if (m_isServer && header.GetProtocol () == DMSRP_TUNNEL_PROT_NUMBER)
+        {
+          m_srvLoadCount++;
+        }
        if(m_isServer|| (m_isSink && m_sinkOutPutDevice==idev))
         {
 
@@ -331,7 +849,7 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
         }
         else
         {
-          header2=header;
+          header2=header3;
         }
 
 
@@ -486,7 +1004,7 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
         }
         else
         {
-          return Forwarding ( p2, header, ucb, ecb, false); 
+          return Forwarding ( p2, header3, ucb, ecb, false, carried); 
         }
 
 
@@ -494,7 +1012,8 @@ RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
 
 bool
 RoutingProtocol::Forwarding (Ptr<const Packet> p, const Ipv4Header & header,
-                             UnicastForwardCallback ucb, ErrorCallback ecb,bool PcktFromServer)
+                             UnicastForwardCallback ucb, ErrorCallback ecb,bool PcktFromServer,
+                             PiggybackHeader const & carried)
 {
   NS_LOG_FUNCTION (this);
   Ipv4Address dst = header.GetDestination ();
@@ -510,19 +1029,39 @@ if (!m_isServer)
 
     if (!m_isSink)
     {
-        if(m_routingTableDown.LookupRoute (dst, toDst))
+        if (m_downlinkMode == BLOOM && header.GetProtocol () == DMSRP_TUNNEL_PROT_NUMBER)
+        {
+          return ForwardBloom (p, header, ucb, Ipv4Address (), m_bloomBroadcastScope, true);
+        }
+        if(LookupDownRoute (dst, toDst))
         {
           route = toDst.GetRoute ();
           NS_LOG_LOGIC (route->GetSource () << " forwarding to " << dst << " from " << origin << " packet " << p->GetUid ());
 
           RoutingTableEntryDown toOrigin;
           m_routingTableDown.LookupRoute (origin, toOrigin);
-          ucb (route, p, header);
+          if (carried.HasAdvertise ())
+            {
+              // the packet turns down here, the advertise record goes on alone
+              PropagateAdvertise (carried.GetAdvertise (origin));
+            }
+          Ptr<Packet> packet = p->Copy ();
+          Ipv4Header ipHeader = header;
+          PiggybackHello (packet, ipHeader, route, toDst.GetInterface ());
+          ucb (route, packet, ipHeader);
           return true;
         
         }
         else
         {
+            if (header.GetProtocol () == DMSRP_TUNNEL_PROT_NUMBER)
+            {
+                  // downlink packet and its destination is no longer below this node:
+                  // do not bounce it back to the parent, tell the upper nodes instead
+                  NS_LOG_LOGIC ("No down route to " << dst << ". Send RERR message.");
+                  SendRerrWhenNoRouteToForward (dst);
+                  return false;
+            }
             if(!m_routingTableUp.IsEmpty())
             {
 
@@ -531,7 +1070,14 @@ if (!m_isServer)
 
                   NS_LOG_LOGIC (route->GetSource () << " forwarding to " << dst << " from " << origin << " packet " << p->GetUid ());
 
-                  ucb (route, p, header)       ;
+                  Ptr<Packet> packet = p->Copy ();
+                  Ipv4Header ipHeader = header;
+                  PiggybackAdvertise (packet, ipHeader, route, carried);
+                  if (m_enableAggregation && m_aggregator.Enqueue (route, packet, ipHeader, ucb))
+                    {
+                      return true;
+                    }
+                  ucb (route, packet, ipHeader)       ;
                   return true;
             }
             else
@@ -544,15 +1090,29 @@ if (!m_isServer)
     else
     {
 
-         if(m_routingTableDown.LookupRoute (dst, toDst))
+         if(LookupDownRoute (dst, toDst))
          {
           route = toDst.GetRoute ();
           NS_LOG_LOGIC (route->GetSource () << " forwarding to " << dst << " from " << origin << " packet " << p->GetUid ());
 
           RoutingTableEntryDown toOrigin;
           m_routingTableDown.LookupRoute (origin, toOrigin);
+          if (carried.HasAdvertise ())
+            {
+              PropagateAdvertise (carried.GetAdvertise (origin));
+            }
 
-          ucb (route, p, header);
+          Ptr<Packet> packet = p->Copy ();
+          Ipv4Header ipHeader = header;
+          if (m_downlinkMode == NON_STORING)
+            {
+              AddSourceRoute (packet, ipHeader, toDst);
+            }
+          else
+            {
+              PiggybackHello (packet, ipHeader, route, toDst.GetInterface ());
+            }
+          ucb (route, packet, ipHeader);
           return true;
          }
          else    // should be sent to the server
@@ -565,12 +1125,17 @@ if (!m_isServer)
                {                    
                    
                    route = toDstUp.GetRoute ();
+                   if (carried.HasAdvertise ())
+                     {
+                       // the tunnel to the server does not carry the option
+                       PropagateAdvertise (carried.GetAdvertise (origin));
+                     }
 
 ////////////////////
                                 Ptr<Packet> p2 = p->Copy();
                                 Ipv4Header newIpv4Header =Ipv4Header();
                                 newIpv4Header.SetSource (Ipv4Address("41.110.3.26"));
-                                 newIpv4Header.SetProtocol (4);
+                                 newIpv4Header.SetProtocol (DMSRP_TUNNEL_PROT_NUMBER);
                                  newIpv4Header.SetPayloadSize (header.GetPayloadSize()+20);
                                 newIpv4Header.SetDestination (/*header.GetDestination()*/Ipv4Address("41.110.5.89") /*dst Ipv4Address("10.1.0.109")*/);  //
                                 p2->AddHeader (header);
@@ -579,6 +1144,36 @@ if (!m_isServer)
 
                                   NS_LOG_LOGIC (route->GetSource () << " forwarding to " << dst << " from " << origin << " packet " << p->GetUid ());
 
+                                  Ipv4Address server;
+                                  if (m_servers.Contains (dst))
+                                    {
+                                      // only this server can deliver it
+                                      if (dst != route->GetGateway ())
+                                        {
+                                          route = RouteToServer (route, dst);
+                                        }
+                                    }
+                                  else if (m_servers.GetSize () > 1 && m_servers.Select (FlowKey (p, header), server)
+                                           && server != route->GetGateway ())
+                                    {
+                                      route = RouteToServer (route, server);
+                                    }
+                                  m_sinkUplinkBytes += p2->GetSize () + newIpv4Header.GetSerializedSize ();
+                                  if (m_enableSinkAqm)
+                                    {
+                                      SinkQueue::Item item;
+                                      item.m_route = route;
+                                      item.m_packet = p2;
+                                      item.m_header = newIpv4Header;
+                                      item.m_ucb = ucb;
+                                      item.m_enqueued = Simulator::Now ();
+                                      m_sinkQueue.Enqueue (origin, item);
+                                      if (!m_sinkQueueTimer.IsRunning ())
+                                        {
+                                          SinkQueueSend ();
+                                        }
+                                      return true;
+                                    }
                                   ucb (route, p2, /*header*/newIpv4Header)       ;
                     //                 NS_LOG_UNCOND ("IT HAS BEEN SENT TO THE STATION");
                                   return true;
@@ -593,6 +1188,8 @@ if (!m_isServer)
               else
               {
                         //NS_LOG_UNCOND ("data pckt came from the server");
+                        NS_LOG_LOGIC ("No down route to " << dst << ". Send RERR message to the server.");
+                        SendRerrWhenNoRouteToForward (dst);
                         return false;
               }
 
@@ -615,11 +1212,12 @@ else //if it is the server
 /////////////////////////
 
 
-        if(m_routingTableDown.LookupRoute (header.GetDestination(), toDst))
+        if(LookupServerRoute (header.GetDestination(), toDst))
         {
 
 
           route = toDst.GetRoute ();
+          m_routingTableServer.NotifyForwarded (toDst.GetNextHop ());
           //NS_LOG_UNCOND ("route gateway "<< route->GetGateway() );
 //////////////////////
                                  Ptr<Packet> p2 = p->Copy();
@@ -627,7 +1225,7 @@ else //if it is the server
                            //     p2->RemoveHeader (oldIpv4Header);
                               //  newIpv4Header=header;
                                 newIpv4Header.SetSource (origin);
-                                 newIpv4Header.SetProtocol (4);
+                                 newIpv4Header.SetProtocol (DMSRP_TUNNEL_PROT_NUMBER);
                                  newIpv4Header.SetPayloadSize (header.GetPayloadSize()+20);
                                 newIpv4Header.SetDestination (/*m_serverAdress dst  route->GetGateway() Ipv4Address("10.1.0.114")*/header.GetDestination());
 
@@ -727,18 +1325,37 @@ RoutingProtocol::NotifyInterfaceUp (uint32_t i)
 
 
 
-  // Allow neighbor manager use this interface for layer 2 feedback if possible
   Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
   if (wifi == 0)
     {
       return;
     }
+  // Sample the time the channel is busy around this node
+  if (wifi->GetPhy () != 0)
+    {
+      PointerValue state;
+      wifi->GetPhy ()->GetAttribute ("State", state);
+      state.Get<WifiPhyStateHelper> ()->TraceConnectWithoutContext ("State", m_channelLoad.GetStateCallback ());
+      if (m_enablePowerControl)
+        {
+          wifi->GetPhy ()->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&RoutingProtocol::SetFrameTxPower, this));
+        }
+    }
+
+  // Allow neighbor manager use this interface for layer 2 feedback if possible
+  if (!m_enableLinkLayerFeedback)
+    {
+      return;
+    }
   Ptr<WifiMac> mac = wifi->GetMac ();
   if (mac == 0)
     {
       return;
     }
 
+  mac->TraceConnectWithoutContext ("TxErrHeader", m_nb.GetTxErrorCallback ());
+  mac->TraceConnectWithoutContext ("TxOkHeader", m_nb.GetTxOkCallback ());
+  m_nb.AddArpCache (l3->GetInterface (i)->GetArpCache ());
 
 }
 
@@ -747,7 +1364,30 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << m_ipv4->GetAddress (i, 0).GetLocal ());
 
-
+  // Disable layer 2 link state monitoring (if possible)
+  Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
+  Ptr<NetDevice> dev = l3->GetNetDevice (i);
+  Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
+  if (wifi != 0 && wifi->GetPhy () != 0)
+    {
+      PointerValue state;
+      wifi->GetPhy ()->GetAttribute ("State", state);
+      state.Get<WifiPhyStateHelper> ()->TraceDisconnectWithoutContext ("State", m_channelLoad.GetStateCallback ());
+      if (m_enablePowerControl)
+        {
+          wifi->GetPhy ()->TraceDisconnectWithoutContext ("PhyTxBegin", MakeCallback (&RoutingProtocol::SetFrameTxPower, this));
+        }
+    }
+  if (m_enableLinkLayerFeedback && wifi != 0)
+    {
+      Ptr<WifiMac> mac = wifi->GetMac ();
+      if (mac != 0)
+        {
+          mac->TraceDisconnectWithoutContext ("TxErrHeader", m_nb.GetTxErrorCallback ());
+          mac->TraceDisconnectWithoutContext ("TxOkHeader", m_nb.GetTxOkCallback ());
+          m_nb.DelArpCache (l3->GetInterface (i)->GetArpCache ());
+        }
+    }
 
   // Close socket
   Ptr<Socket> socket = FindSocketWithInterfaceAddress (m_ipv4->GetAddress (i, 0));
@@ -765,11 +1405,16 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t i)
     {
       NS_LOG_LOGIC ("No dmsrp interfaces");
       m_hellotimer.Cancel ();
+      m_nb.Clear ();
       m_routingTableUp.Clear ();
       m_routingTableDown.Clear ();
+      m_routingTableServer.Clear ();
+      m_descendants.Clear ();
       return;
     }
   m_routingTableDown.DeleteAllRoutesFromInterface (m_ipv4->GetAddress (i, 0));
+  m_descendants.DeleteAllChildrenFromInterface (m_ipv4->GetAddress (i, 0));
+  m_routingTableServer.DeleteAllRoutesFromInterface (m_ipv4->GetAddress (i, 0));
   m_routingTableUp.DeleteAllRoutesFromInterface (m_ipv4->GetAddress (i, 0));
 }
 
@@ -839,6 +1484,8 @@ RoutingProtocol::NotifyRemoveAddress (uint32_t i, Ipv4InterfaceAddress address)
   if (socket)
     {
       m_routingTableDown.DeleteAllRoutesFromInterface (address);
+      m_routingTableServer.DeleteAllRoutesFromInterface (address);
+      m_descendants.DeleteAllChildrenFromInterface (address);
       socket->Close ();
       m_socketAddresses.erase (socket);
 
@@ -968,11 +1615,60 @@ RoutingProtocol::LoopbackRoute (const Ipv4Header & hdr, Ptr<NetDevice> oif) cons
   return rt;
 }
 
-void
+bool
 RoutingProtocol::SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination)
 {
+  // the interface went down or lost its address since the packet was scheduled
+  if (m_socketAddresses.find (socket) == m_socketAddresses.end ()
+      && m_socketSubnetBroadcastAddresses.find (socket) == m_socketSubnetBroadcastAddresses.end ())
+    {
+      NS_LOG_LOGIC ("Drop a control packet to " << destination << ", its socket is closed");
+      return false;
+    }
   socket->SendTo (packet, 0, InetSocketAddress (destination, DMSRP_PORT));
+  return true;
+}
+
+void
+RoutingProtocol::ScheduleTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination)
+{
+  if (!m_controlTxBatching)
+    {
+      Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
+      Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
+      m_controlTxTrace (1);
+      return;
+    }
+  QueuedControlPacket queued;
+  queued.socket = socket;
+  queued.packet = packet;
+  queued.destination = destination;
+  m_txQueue.push_back (queued);
+  if (!m_txEvent.IsRunning ())
+    {
+      Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
+      m_txEvent = Simulator::Schedule (jitter, &RoutingProtocol::FlushTxQueue, this);
+    }
+}
 
+void
+RoutingProtocol::FlushTxQueue ()
+{
+  NS_LOG_FUNCTION (this << m_txQueue.size ());
+  std::vector<QueuedControlPacket> queue;
+  queue.swap (m_txQueue);
+  uint32_t sent = 0;
+  for (std::vector<QueuedControlPacket>::const_iterator i = queue.begin (); i != queue.end (); ++i)
+    {
+      if (SendTo (i->socket, i->packet, i->destination))
+        {
+          sent++;
+        }
+    }
+  if (sent > 0)
+    {
+      m_controlTxTrace (sent);
+    }
 }
 
 
@@ -1027,6 +1723,7 @@ NS_LOG_UNCOND("Mode is: SNR_AWARE_MULTI_PARENT_MODE" <<SNR_AWARE_MULTI_PARENT_MO
       NS_ASSERT_MSG (false, "Received a packet from an unknown socket");
     }
   NS_LOG_DEBUG ("DMSRP node " << this << " received a DMSRP packet from " << sender << " to " << receiver);
+  m_nb.Update (sender, m_activeRouteTimeout);
  // NS_LOG_UNCOND ("DMSRP node " << this << " received a DMSRP packet from " << sender << " to " << receiver);
 
   TypeHeader tHeader (DMSRPTYPE_HELLO);
@@ -1054,6 +1751,39 @@ NS_LOG_UNCOND("Mode is: SNR_AWARE_MULTI_PARENT_MODE" <<SNR_AWARE_MULTI_PARENT_MO
        RecvSrvAdvertise (packet, receiver, sender);// DMS
         break;
       }
+    case DMSRPTYPE_RERR:
+      {
+        RecvRerr (packet, receiver, sender);
+        break;
+      }
+    case DMSRPTYPE_PIGGYBACK:
+    case DMSRPTYPE_SOURCEROUTE:
+    case DMSRPTYPE_SCOPEDFLOOD:
+    case DMSRPTYPE_CONTAINER:
+      {
+        NS_LOG_DEBUG ("Data packet option received as a control message. Drop");
+        break;
+      }
+    case DMSRPTYPE_PARENTASSIGN:
+      {
+        RecvParentAssign (packet, receiver, sender);
+        break;
+      }
+    case DMSRPTYPE_SRVPROBE:
+      {
+        RecvSrvProbe (packet, receiver, sender);
+        break;
+      }
+    case DMSRPTYPE_SRVPROBE_REPLY:
+      {
+        RecvSrvProbeReply (packet, receiver, sender);
+        break;
+      }
+    case DMSRPTYPE_CLUSTERADVERTISE:
+      {
+        RecvClusterAdvertise (packet, receiver, sender);
+        break;
+      }
     }
 }
 
@@ -1068,16 +1798,10 @@ RoutingProtocol::RecvHello (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src
   HelloHeader helloHeader;
   p->RemoveHeader (helloHeader);
 // uint32_t id = helloHeader.GetId ();  //DMS
-  Ipv4Address origin = helloHeader.GetOrigin ();
-
-  m_routingTableUp.Purge ();
  
  // RoutingTableEntryDown toOrigin;
  
 
-       RoutingTableEntryUp myRoutingEntry;
-
-
       // ***** SNR **** // 
       SnrTag tag;
       if (p->PeekPacketTag(tag))
@@ -1085,11 +1809,102 @@ RoutingProtocol::RecvHello (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src
         temp_snr=tag.Get();    
     // NS_LOG_UNCOND("Reveived hello packet-> MinSnr: "<<helloHeader.GetMinSnr()<<"  pckt Snr: "<<tag.Get()<< "  -  Received Cum Energy: "<<helloHeader.GetMinEnergy ()<< "  -Stored cum Energy: "<<m_minEnergy<< "  -Remaining Energy: "<<EnergySrc->GetRemainingEnergy ());     
       }  
+      // ***** SNR **** //
+  if (helloHeader.GetFlags () & HelloHeader::CLUSTER)
+    {
+      m_nb.SetCluster (src, helloHeader.GetClusterScore (), helloHeader.IsClusterHead ());
+    }
+  if (helloHeader.GetFlags () & HelloHeader::CHANNEL_LOAD)
+    {
+      m_nb.SetChannelLoad (src, helloHeader.GetChannelLoad ());
+    }
+  if (helloHeader.GetFlags () & HelloHeader::MOBILITY)
+    {
+      m_nb.SetMobility (src, helloHeader.GetPosition (), helloHeader.GetVelocity ());
+    }
+  if (helloHeader.GetFlags () & HelloHeader::SINK_LOAD)
+    {
+      m_routingTableUp.SetSinkLoad (helloHeader.GetOrigin (), helloHeader.GetOriginSeqno (),
+                                    helloHeader.GetSubtreeSize (), helloHeader.GetUplinkLoad ());
+    }
+  if ((helloHeader.GetFlags () & HelloHeader::TX_POWER) && p->PeekPacketTag (tag) && tag.Get () > 0)
+    {
+      m_nb.SetTxPower (src, helloHeader.GetTxPower (), 10 * std::log10 (tag.Get ()));
+    }
+  if (helloHeader.GetFlags () & HelloHeader::LINK_QUALITY)
+    {
+      m_nb.NotifyHello (src, helloHeader.GetHelloCounter (), m_activeRouteTimeout);
+      uint8_t reception;
+      if (helloHeader.GetLinkRecord (receiver, reception))
+        {
+          m_nb.SetForwardReception (src, reception);
+        }
+    }
+  ProcessHello (helloHeader, receiver, src);
+}
+
+bool
+RoutingProtocol::IsUpstreamHello (HelloHeader const & helloHeader, RoutingTableEntryUp const & current, Ipv4Address src)
+{
+  // a path metric reported before the current sequence number may still go through this node
+  if (helloHeader.GetOrigin () != current.GetDestination () || helloHeader.GetOriginSeqno () < current.GetSeqNo ())
+    {
+      return false;
+    }
+  std::set<Ipv4Address> children;
+  m_routingTableDown.GetChildren (children);
+  return children.find (src) == children.end ();
+}
+
+void
+RoutingProtocol::ProcessSinkRecord (HelloHeader record, Ipv4Address receiver, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << record.GetOrigin () << src);
+  uint8_t hop = record.GetHopCount () + 1;
+  if (hop > m_maxHelloHops)
+    {
+      return;
+    }
+  RoutingTableEntryUp toSink;
+  if (m_routingTableUp.LookupSinkRoute (record.GetOrigin (), toSink) && toSink.GetSeqNo () > record.GetOriginSeqno ())
+    {
+      NS_LOG_LOGIC ("Ignoring stale route to sink " << record.GetOrigin () << " via " << src);
+      return;
+    }
+  int32_t interface = m_ipv4->GetInterfaceForAddress (receiver);
+  RoutingTableEntryUp newEntry (/*device=*/ m_ipv4->GetNetDevice (interface), /*dst=*/ record.GetOrigin (), /*seqNo=*/ record.GetOriginSeqno (),
+                                /*iface=*/ m_ipv4->GetAddress (interface, 0), /*hops=*/ hop,
+                                /*nextHop*/ src, /*timeLife=*/ GetRouteTimeout (src), record.GetMinEnergy (),
+                                std::min (record.GetMinSnr (), (float) temp_snr));
+  newEntry.SetChannelLoad (m_nb.GetChannelLoad (src));
+  if (m_routingMode == LINK_LIFETIME_MODE)
+    {
+      Time linkLifetime = GetLinkLifetime (src);
+      newEntry.SetLinkLifetime (linkLifetime);
+      newEntry.SetLifeTime (std::min (GetRouteTimeout (src), linkLifetime));
+    }
+  // the records carry no path ETX: count at least one transmission per hop after the link
+  newEntry.SetPathEtx (m_nb.GetEtx (src) + record.GetHopCount ());
+  if (m_routingMode == AIRTIME_MODE)
+    {
+      // nor a path airtime: assume the next hops are as fast as the link
+      newEntry.SetPathAirtime (GetLinkAirtime (src, receiver) * hop);
+    }
+  m_routingTableUp.AddSinkRoute (newEntry);
+}
+
+void
+RoutingProtocol::ProcessHello (HelloHeader helloHeader, Ipv4Address receiver, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << receiver << src);
+  Ipv4Address origin = helloHeader.GetOrigin ();
+  RoutingTableEntryUp myRoutingEntry;
+  m_routingTableUp.Purge ();
+
 if(temp_snr<helloHeader.GetMinSnr ())
 {
 helloHeader.SetMinSnr (temp_snr);
 }
-      // ***** SNR **** //
 
 
     //   m_routingTableUp.LookupTheRoute(myRoutingEntry);
@@ -1113,6 +1928,13 @@ m_routingTableUp.PrintInScreen();
  //    NS_LOG_UNCOND(receiver<<" Ignoring HELLO because this node has an output access or is the server");
      return;
   }
+
+  // keep a route to every sink the neighbor can reach
+  ProcessSinkRecord (helloHeader, receiver, src);
+  for (uint8_t k = 0; k < helloHeader.GetSinkCount (); ++k)
+    {
+      ProcessSinkRecord (helloHeader.GetSinkRecord (k), receiver, src);
+    }
 /*  if (m_helloIdCache.IsDuplicate (origin, id))
   {
      NS_LOG_DEBUG (receiver<<" Ignoring HELLO due to duplicate");
@@ -1131,9 +1953,6 @@ m_routingTableUp.PrintInScreen();
      return;
   }
    
-      Ptr<EnergySource> EnergySrc;
-      EnergySrc = this->GetObject<EnergySourceContainer> ()->Get (0);
-
 /*if((m_socketAddresses.begin()->second).GetLocal ()==Ipv4Address("10.1.0.33"))
 {
  // NS_LOG_UNCOND (receiver<<"its minEnergiy is: "<<  m_minEnergy<<"----Reveive HELLO packetfrom:"<<src<< " remaining enrgy: "<<EnergySrc->GetRemainingEnergy ()<<" rem energy: "<<helloHeader.GetMinEnergy()<<"  minSNR: "<<helloHeader.GetMinSnr ()<<" and hop="<<(int)hop); //DMS2
@@ -1184,6 +2003,19 @@ else
         {
         modifyRoutingTable=true;
         }
+        // a neighbor with a lower path ETX in a fresh Hello is not below this node: it may be a parent whatever its hops
+        if (m_routingMode == ETX_MODE && (helloHeader.GetFlags () & HelloHeader::LINK_QUALITY)
+            && helloHeader.GetPathEtx () < myRoutingEntry.GetPathEtx ()
+            && IsUpstreamHello (helloHeader, myRoutingEntry, src))
+        {
+        modifyRoutingTable=true;
+        }
+        if (m_routingMode == AIRTIME_MODE && (helloHeader.GetFlags () & HelloHeader::AIRTIME)
+            && helloHeader.GetPathAirtime () < myRoutingEntry.GetPathAirtime ()
+            && IsUpstreamHello (helloHeader, myRoutingEntry, src))
+        {
+        modifyRoutingTable=true;
+        }
 
 /*        if((myRoutingEntry.GetHop()>=helloHeader.GetHopCount())) 
         {
@@ -1206,10 +2038,27 @@ if(modifyRoutingTable)
 
       RoutingTableEntryUp newEntry (/*device=*/ dev, /*dst=*/ origin,/*seqNo=*/ helloHeader.GetOriginSeqno (),
                                               /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0), /*hops=*/ hop,
-                                              /*nextHop*/ src, /*timeLife=*/ m_activeRouteTimeout,helloHeader.GetMinEnergy () ,std::min (helloHeader.GetMinSnr (),(float) temp_snr ) );
+                                              /*nextHop*/ src, /*timeLife=*/ GetRouteTimeout (src),helloHeader.GetMinEnergy () ,std::min (helloHeader.GetMinSnr (),(float) temp_snr ) );
+      newEntry.SetPathEtx (helloHeader.GetPathEtx () + m_nb.GetEtx (src));
+      newEntry.SetChannelLoad (m_nb.GetChannelLoad (src));
+      if (m_routingMode == LINK_LIFETIME_MODE)
+        {
+          // the route does not outlive the link it goes through
+          Time linkLifetime = GetLinkLifetime (src);
+          newEntry.SetLinkLifetime (linkLifetime);
+          newEntry.SetLifeTime (std::min (GetRouteTimeout (src), linkLifetime));
+        }
+      if (m_routingMode == AIRTIME_MODE)
+        {
+          newEntry.SetPathAirtime (helloHeader.GetPathAirtime () + GetLinkAirtime (src, receiver));
+        }
+      if (m_routingMode == PATH_LIFETIME_MODE)
+        {
+          newEntry.SetPathLifetime (helloHeader.GetPathLifetime ());
+        }
       m_routingTableUp.AddRoute (newEntry);
 
-         helloHeader.SetMinEnergy (helloHeader.GetMinEnergy ()+EnergySrc->GetRemainingEnergy ());
+         helloHeader.SetMinEnergy (helloHeader.GetMinEnergy ()+m_energyMonitor.GetRemainingEnergy ());
          m_minEnergy=helloHeader.GetMinEnergy ();
          m_Snr=helloHeader.GetMinSnr ();
   Ptr<OutputStreamWrapper> testprint = Create<OutputStreamWrapper>("routingtestprint", std::ios::out);
@@ -1222,23 +2071,26 @@ if(modifyRoutingTable)
 void //DMS
 RoutingProtocol::RecvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)  // this function is used by simple node and sinks
 {
-
- SrvAdvertiseHeader srvadvertiseHeader;
-  Ptr<Ipv4Route> route=Create<Ipv4Route>();
-    RoutingTableEntryUp toDst;
- 
-
-
   if(!m_isServer)
   {
-
-
           // NS_LOG_UNCOND( Simulator::Now () <<":"<<(m_socketAddresses.begin()->second).GetLocal () <<" Advertise received  DMS --- source:" << src << " receiver:"  << receiver );
 
          NS_LOG_FUNCTION (this);
           AdvertiseHeader advertiseHeader;
           p->RemoveHeader (advertiseHeader);
    //       uint32_t id = advertiseHeader.GetId ();  //DMS
+
+          if (ProcessAdvertise (advertiseHeader, receiver, src))
+          {
+            PropagateAdvertise (advertiseHeader);
+          }
+  }
+}
+
+bool
+RoutingProtocol::ProcessAdvertise (AdvertiseHeader & advertiseHeader, Ipv4Address receiver, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << receiver << src);
           Ipv4Address origin = advertiseHeader.GetOrigin ();
 
           // Increment RREQ hop count
@@ -1249,7 +2101,18 @@ RoutingProtocol::RecvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address
           {
              NS_LOG_DEBUG (receiver<<" Ignoring ADVERTISE: hops> maxhops");
       //       NS_LOG_UNCOND(receiver<<" Ignoring ADVERTISE: hops> maxhops");
-             return;
+             return false;
+          }
+
+          if (m_downlinkMode == NON_STORING && !m_isSink)
+          {
+             // no down state on the relays: the path recorded in the advertise is enough for the sink
+             return true;
+          }
+          if (m_downlinkMode == BLOOM && !m_isSink)
+          {
+             m_descendants.Update (src, m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0), origin);
+             return true;
           }
 
 
@@ -1273,7 +2136,7 @@ RoutingProtocol::RecvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address
                         }
                         else
                         {
-                             return;
+                             return false;
                         }
                         if((myRoutingEntry.GetHop()>advertiseHeader.GetHopCount())) 
                         {
@@ -1298,21 +2161,47 @@ RoutingProtocol::RecvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address
 
               RoutingTableEntryDown newEntry (/*device=*/ dev, /*dst=*/ origin,/*seqNo=*/ advertiseHeader.GetOriginSeqno (),
                                                       /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0), /*hops=*/ hop,
-                                                      /*nextHop*/ src, /*timeLife=*/ m_activeRouteTimeout);
+                                                      /*nextHop*/ src, /*timeLife=*/ GetRouteTimeout (src));
+              if (m_downlinkMode == NON_STORING)
+                {
+                  // the last relay of the path is the next hop
+                  std::vector<Ipv4Address> path = advertiseHeader.GetPath ();
+                  if (!path.empty () && path.back () == src)
+                    {
+                      path.pop_back ();
+                    }
+                  newEntry.SetPath (path);
+                }
               m_routingTableDown.AddRoute (newEntry);
 
         }
          
    //      m_routingTableDown.PrintInScreen();
-         
-        if(!m_isSink)
+  return true;
+}
+
+void
+RoutingProtocol::PropagateAdvertise (AdvertiseHeader advertiseHeader)
+{
+  NS_LOG_FUNCTION (this << advertiseHeader.GetOrigin ());
+  Ptr<Ipv4Route> route;
+  RoutingTableEntryUp toDst;
+
+        if (AbsorbsAdvertise (advertiseHeader.GetOrigin ()))
+        {
+          NS_LOG_LOGIC ("Advertise of " << advertiseHeader.GetOrigin () << " kept in the cluster");
+        }
+        else if(!m_isSink)
         {
           ForwardAdvertise (advertiseHeader);  //forward to another node or to the sink
         }
         else   // send to the server by adding to the header the
         {
 
-        //  NS_LOG_UNCOND ("A SINK: " << receiver  <<" HAS RECEIVED AN ADVERTISE"<<" src-->dst: "<<src<< "-->"<<receiver<< " pcktID: "<<p->GetUid ()<< "    "<<Simulator::Now ());
+             if (!m_forwardedAdvertises.IsNeeded (advertiseHeader))
+             {
+                return;
+             }
              if((!m_routingTableUp.IsEmpty())) 
              {       
 
@@ -1321,28 +2210,19 @@ RoutingProtocol::RecvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address
                               route = toDst.GetRoute ();
                         
                               SrvAdvertiseHeader srvadvertiseHeader ( /*hops=*/ advertiseHeader.GetHopCount(), /*prefix size=*/ 0, /*orig=*/ advertiseHeader.GetOrigin (), /*sink=*/ route->GetSource(),/*seqno=*/ advertiseHeader.GetSeqno());
-                              Ptr<Packet> packet = Create<Packet> ();
-                              SocketIpTtlTag tag;
-                              tag.SetTtl (1);
-                              packet->AddPacketTag (tag);
-                              packet->AddHeader (srvadvertiseHeader);
-                              TypeHeader tHeader (DMSRPTYPE_SRVADVERTISE);
-                              packet->AddHeader (tHeader);
+                              srvadvertiseHeader.SetReport (advertiseHeader.GetReport ());
+                              RoutingTableEntryDown toOrigin;
+                              if (m_adaptiveRouteTimeout && m_routingTableDown.LookupRoute (advertiseHeader.GetOrigin (), toOrigin))
+                                {
+                                  srvadvertiseHeader.SetRouteTimeout (toOrigin.GetLifeTime ());
+                                }
 
                               ForwardSrvAdvertise (srvadvertiseHeader);                          
 
              }
         }
-
-        return;
-   
-  }
-
-
 }
 
-
-
 void //DMS
 RoutingProtocol::RecvSrvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
 {
@@ -1371,51 +2251,40 @@ RoutingProtocol::RecvSrvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Addr
 
               Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver));
 
+              // any message of the sink, even a duplicate, shows that it is alive
+              m_routingTableServer.NotifySinkAlive (sink, m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0));
 
-
-               bool modifyRoutingTable=false;
-
-              
-
-                if(m_routingTableDown.LookupRoute (origin, myRoutingEntry))
+              if (m_enableTopologyReport)
                 {
-               
-                        if(((myRoutingEntry.GetDestination()==origin) &&(myRoutingEntry.GetSeqNo()<srvadvertiseHeader.GetOriginSeqno())))
-                        {
-                               modifyRoutingTable=true;           
-                        }
-         /*               {
-                              NS_LOG_UNCOND(receiver<< " WWOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOW"); 
-                              return;
-                        }*/
-                        if(myRoutingEntry.GetLifeTime ()<=Seconds(0))
-                        {
-                               modifyRoutingTable=true;   
-        //                       NS_LOG_UNCOND(receiver<< " RT3 ROUTE EXPIRE");        
-                        }              
-
+                  if (hop == 1)
+                    {
+                      // the advertise of the sink itself: a root of the topology
+                      m_topology.AddSink (origin, m_activeRouteTimeout);
+                    }
+                  else if (!srvadvertiseHeader.GetReport ().IsEmpty ())
+                    {
+                      m_topology.Update (origin, srvadvertiseHeader.GetReport (), m_activeRouteTimeout);
+                    }
                 }
-                else
+
+              // every sink that hears the destination is kept as a candidate; only the entry
+              // learned through the same sink is replaced, by a newer advertise
+              if (m_routingTableServer.LookupCandidate (origin, sink, myRoutingEntry)
+                  && myRoutingEntry.GetSeqNo () >= srvadvertiseHeader.GetOriginSeqno ())
                 {
-                        modifyRoutingTable=true;                       
+                  return;
                 }
 
-
-               if(modifyRoutingTable)  /// modify the route
+              // the server does not move: the sink gives the timeout of the way to the origin
+              Time timeout = m_activeRouteTimeout;
+              if (m_adaptiveRouteTimeout && !srvadvertiseHeader.GetRouteTimeout ().IsZero ())
                 {
-                     if(m_routingTableDown.LookupRoute (origin, myRoutingEntry))
-                     {
-                          m_routingTableDown.DeleteRoute(origin);
-                     }
-
-
-                      RoutingTableEntryDown newEntry (/*device=*/ dev, /*dst=*/ origin,/*seqNo=*/ srvadvertiseHeader.GetOriginSeqno (),
-                                                              /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0), /*hops=*/ hop,
-                                                              /*nextHop*/ sink, /*timeLife=*/ m_activeRouteTimeout);
-                      m_routingTableDown.AddRoute (newEntry);
-
+                  timeout = std::min (std::max (srvadvertiseHeader.GetRouteTimeout (), m_minRouteTimeout), m_maxRouteTimeout);
                 }
-
+              RoutingTableEntryDown newEntry (/*device=*/ dev, /*dst=*/ origin,/*seqNo=*/ srvadvertiseHeader.GetOriginSeqno (),
+                                                      /*iface=*/ m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0), /*hops=*/ hop,
+                                                      /*nextHop*/ sink, /*timeLife=*/ timeout);
+              m_routingTableServer.AddRoute (newEntry);
 
 /* NS_LOG_UNCOND("Server routingtable RT3: ");
 m_routingTableDown.PrintInScreen();*/
@@ -1427,6 +2296,229 @@ m_routingTableDown.PrintInScreen();*/
 
 }
 
+void
+RoutingProtocol::RecvParentAssign (Ptr<Packet> p, Ipv4Address, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << " from " << src);
+  ParentAssignHeader parentAssignHeader;
+  p->RemoveHeader (parentAssignHeader);
+  std::map<Ipv4Address, Ipv4Address> assignments;
+  std::pair<Ipv4Address, Ipv4Address> assignment;
+  while (parentAssignHeader.RemoveAssignment (assignment))
+    {
+      assignments.insert (assignment);
+    }
+  DispatchParentAssign (assignments, parentAssignHeader.GetLifetime ());
+}
+
+void
+RoutingProtocol::DispatchParentAssign (std::map<Ipv4Address, Ipv4Address> const & assignments, Time lifetime)
+{
+  NS_LOG_FUNCTION (this);
+  // next hop -> (interface, message)
+  std::map<Ipv4Address, std::pair<Ipv4InterfaceAddress, ParentAssignHeader> > messages;
+  for (std::map<Ipv4Address, Ipv4Address>::const_iterator i = assignments.begin (); i != assignments.end (); ++i)
+    {
+      if (IsMyOwnAddress (i->first))
+        {
+          NS_LOG_LOGIC ("Parent " << i->second << " assigned by the server");
+          m_routingTableUp.SetAssignedParent (i->second, lifetime);
+          continue;
+        }
+      RoutingTableEntryDown toDst;
+      bool found = m_isServer ? m_routingTableServer.LookupRoute (i->first, toDst)
+                              : m_routingTableDown.LookupRoute (i->first, toDst);
+      if (!found)
+        {
+          NS_LOG_LOGIC ("No route down to " << i->first << ", parent assignment dropped");
+          continue;
+        }
+      std::map<Ipv4Address, std::pair<Ipv4InterfaceAddress, ParentAssignHeader> >::iterator message =
+        messages.find (toDst.GetNextHop ());
+      if (message == messages.end ())
+        {
+          message = messages.insert (std::make_pair (toDst.GetNextHop (),
+                                                     std::make_pair (toDst.GetInterface (), ParentAssignHeader (lifetime)))).first;
+        }
+      if (!message->second.second.AddAssignment (i->first, i->second))
+        {
+          // full: send it and go on with an empty one
+          SendParentAssign (message->second.second, message->second.first, message->first);
+          message->second.second.Clear ();
+          message->second.second.AddAssignment (i->first, i->second);
+        }
+    }
+  for (std::map<Ipv4Address, std::pair<Ipv4InterfaceAddress, ParentAssignHeader> >::const_iterator i = messages.begin ();
+       i != messages.end (); ++i)
+    {
+      SendParentAssign (i->second.second, i->second.first, i->first);
+    }
+}
+
+void
+RoutingProtocol::SendParentAssign (ParentAssignHeader const & parentAssignHeader, Ipv4InterfaceAddress iface, Ipv4Address nextHop)
+{
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (iface);
+  if (!socket)
+    {
+      return;
+    }
+  Ptr<Packet> packet = Create<Packet> ();
+  SocketIpTtlTag tag;
+  tag.SetTtl (1);
+  packet->AddPacketTag (tag);
+  packet->AddHeader (parentAssignHeader);
+  TypeHeader tHeader (DMSRPTYPE_PARENTASSIGN);
+  packet->AddHeader (tHeader);
+  ScheduleTo (socket, packet, nextHop);
+}
+
+TopologyReport
+RoutingProtocol::MakeTopologyReport ()
+{
+  TopologyReport report;
+  report.SetEnergy (m_energyMonitor.GetRemainingEnergy ());
+  std::map<Ipv4Address, RoutingTableEntryUp> parents;
+  m_routingTableUp.GetParents (parents);
+  for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = parents.begin (); i != parents.end (); ++i)
+    {
+      report.AddLink (i->first, i->second.GetMinSnr ());
+    }
+  return report;
+}
+
+void
+RoutingProtocol::TopologyTimerExpire ()
+{
+  NS_LOG_FUNCTION (this);
+  std::map<Ipv4Address, Ipv4Address> parents;
+  m_topology.ComputeParents (parents);
+  // an assignment outlives a lost computation or two
+  DispatchParentAssign (parents, m_topologyInterval * 3);
+  m_topologyTimer.Schedule (m_topologyInterval);
+}
+
+void
+RoutingProtocol::SinkQueueSend ()
+{
+  SinkQueue::Item item;
+  while (m_sinkQueue.Dequeue (item))
+    {
+      m_sinkQueueSojournTrace (Simulator::Now () - item.m_enqueued);
+      item.m_ucb (item.m_route, item.m_packet, item.m_header);
+      if (m_sinkUplinkRate.GetBitRate () > 0)
+        {
+          // the next packet leaves when this one is on the wire
+          m_sinkQueueTimer.Schedule (m_sinkUplinkRate.CalculateBytesTxTime (item.m_packet->GetSize () + item.m_header.GetSerializedSize ()));
+          return;
+        }
+    }
+}
+
+void
+RoutingProtocol::NotifySinkQueueDrop (Ipv4Address origin, Time sojourn)
+{
+  NS_LOG_FUNCTION (this << origin << sojourn);
+  m_sinkQueueDropTrace (origin, sojourn);
+}
+
+void
+RoutingProtocol::RecvRerr (Ptr<Packet> p, Ipv4Address, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << " from " << src);
+  RerrHeader rerrHeader;
+  p->RemoveHeader (rerrHeader);
+  if (m_downlinkMode != STORING && !m_isSink && !m_isServer)
+    {
+      // no down routes here, the sink holds them
+      SendRerrMessage (rerrHeader);
+      return;
+    }
+  RerrHeader forwardRerr;
+  std::pair<Ipv4Address, uint32_t> un;
+  while (rerrHeader.RemoveUnDestination (un))
+    {
+      RoutingTableEntryDown toDst;
+      if (m_isServer)
+        {
+          // the sink that reported the error is no longer a candidate, the others take over
+          if (m_routingTableServer.LookupCandidate (un.first, src, toDst)
+              && (un.second == 0 || toDst.GetSeqNo () <= un.second))
+            {
+              m_routingTableServer.DeleteRoute (un.first, src);
+            }
+          continue;
+        }
+      // only the routes that go down through the sender of the RERR are broken; a sink in
+      // non-storing or Bloom mode trusts any relay, the error may come up another branch
+      if (!m_routingTableDown.LookupRoute (un.first, toDst)
+          || (m_downlinkMode == STORING && toDst.GetNextHop () != src))
+        {
+          continue;
+        }
+      // the route has been refreshed by a newer advertise in the meantime
+      if (un.second != 0 && toDst.GetSeqNo () > un.second)
+        {
+          continue;
+        }
+      NS_LOG_LOGIC ("Remove down route to " << un.first << " via " << src);
+      m_routingTableDown.DeleteRoute (un.first);
+      forwardRerr.AddUnDestination (un.first, toDst.GetSeqNo ());
+    }
+
+  if (m_isServer || forwardRerr.GetDestCount () == 0)
+    {
+      return;
+    }
+  SendRerrMessage (forwardRerr);
+}
+
+bool
+RoutingProtocol::RecvPiggyback (Ptr<Packet> p, Ipv4Header & header, Ipv4Address receiver, PiggybackHeader & piggyback)
+{
+  NS_LOG_FUNCTION (this << receiver);
+  TypeHeader tHeader (DMSRPTYPE_PIGGYBACK);
+  p->RemoveHeader (tHeader);
+  if (!tHeader.IsValid () || tHeader.Get () != DMSRPTYPE_PIGGYBACK)
+    {
+      NS_LOG_DEBUG ("Data packet " << p->GetUid () << " with unknown DMSRP option: " << tHeader.Get () << ". Drop");
+      return false;
+    }
+  p->RemoveHeader (piggyback);
+  header.SetProtocol (piggyback.GetNextHeader ());
+  header.SetPayloadSize (header.GetPayloadSize () - tHeader.GetSerializedSize () - piggyback.GetSerializedSize ());
+
+  Ipv4Address sender = piggyback.GetSender ();
+  m_nb.Update (sender, m_activeRouteTimeout);
+  if (piggyback.HasHello ())
+    {
+      if (!m_isSink)
+        {
+          SnrTag tag;
+          if (p->PeekPacketTag (tag))
+            {
+              temp_snr = tag.Get ();
+            }
+          ProcessHello (piggyback.GetHello (), receiver, sender);
+        }
+      // every parent piggybacks its own Hello
+      piggyback.ClearRecord ();
+    }
+  if (piggyback.HasAdvertise ())
+    {
+      AdvertiseHeader advertiseHeader = piggyback.GetAdvertise (header.GetSource ());
+      if (ProcessAdvertise (advertiseHeader, receiver, sender) && !AbsorbsAdvertise (advertiseHeader.GetOrigin ()))
+        {
+          piggyback.SetAdvertise (advertiseHeader);
+        }
+      else
+        {
+          piggyback.ClearRecord ();
+        }
+    }
+  return true;
+}
+
 void
 RoutingProtocol::HelloTimerExpire2 () //DMS
 {
@@ -1434,7 +2526,18 @@ RoutingProtocol::HelloTimerExpire2 () //DMS
   
 if(!m_isServer)
 {
-  SendHello2 ();
+  UpdateClusterRole ();
+  if (m_enablePiggyback && !m_helloSuppressed && ChildrenHaveFreshHello ())
+    {
+      // never twice in a row: the neighbors which are not children yet need the Hello to join
+      NS_LOG_LOGIC ("Hello suppressed, the children got it piggybacked on data packets");
+      m_helloSuppressed = true;
+    }
+  else
+    {
+      m_helloSuppressed = false;
+      SendHello2 ();
+    }
 }
   m_hellotimer.Cancel ();
   m_hellotimer.Schedule (m_helloTimerExpire);
@@ -1447,11 +2550,24 @@ RoutingProtocol::AdvertiseTimerExpire () //DMS
   
 if(!m_isSink) // if this node has not an output access it can send an advertise message
 {
-  SendAdvertise ();
+  if (m_enablePiggyback && m_advertisePiggybacked && Simulator::Now () - m_lastAdvertise < m_piggybackFreshness)
+    {
+      NS_LOG_LOGIC ("Advertise suppressed, it went up piggybacked on a data packet");
+    }
+  else
+    {
+      SendAdvertise ();
+    }
+  if (m_isClusterHead)
+    {
+      SendClusterAdvertise ();
+    }
 }
 else
 {
 SendSrvAdvertise_testUDP();
+  // the server has dropped the route by now
+  m_forwardedAdvertises.Purge (m_activeRouteTimeout);
 
 }
   m_advertisetimer.Cancel ();
@@ -1473,12 +2589,10 @@ m_routingTableDown.PrintInScreen();
 void
 RoutingProtocol::SendHello2 ()   //DMS
 {
- Ptr<EnergySource> EnergySrc;
 int i=0;//dms asupp
   NS_LOG_FUNCTION (this);
       RoutingTableEntryUp myRoutingEntry;
-      EnergySrc = this->GetObject<EnergySourceContainer> ()->Get (0);
-      m_minEnergy=EnergySrc->GetRemainingEnergy ();   
+      m_minEnergy = m_energyMonitor.GetRemainingEnergy ();
  
  if(m_isSink)
  {
@@ -1486,7 +2600,10 @@ int i=0;//dms asupp
 Ipv4InterfaceAddress iface;
 Ipv4Address ipv4ifaceSink;
 
-
+  m_helloCounter++;
+  m_channelLoad.Sample ();
+  UpdateTxPower ();
+  SampleSinkUplink ();
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
     {i++;//dms asupp
       Ptr<Socket> socket = j->first;
@@ -1494,7 +2611,8 @@ Ipv4Address ipv4ifaceSink;
   if (m_sinkOutPutDevice !=m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ()))) 
     {
 //  NS_LOG_UNCOND("remaining energy for sink is: "<<EnergySrc->GetRemainingEnergy ()*100);
-      HelloHeader helloHeader (/*prefix size= 0,*/ /*hops=*/ 0, /* reserved*/ 0,/* Min Energy*/ m_minEnergy,/* Min snr*/ 9999.0, /*orig=sink*/ iface.GetLocal (), /*seqno=*/ m_HseqNo);
+      HelloHeader helloHeader;
+      MakeHelloHeader (iface, helloHeader);
       Ptr<Packet> packet = Create<Packet> ();
       SocketIpTtlTag tag;
       tag.SetTtl (1);
@@ -1513,8 +2631,7 @@ Ipv4Address ipv4ifaceSink;
         {
           destination = iface.GetBroadcast ();
         }
-      Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-      Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
+      ScheduleTo (socket, packet, destination);
    }
     }
 
@@ -1527,19 +2644,28 @@ Ipv4Address ipv4ifaceSink;
    
    if(  m_routingTableUp.LookupBestRoute(myRoutingEntry))
    {
-             EnergySrc = this->GetObject<EnergySourceContainer> ()->Get (0);
-              m_minEnergy=EnergySrc->GetRemainingEnergy ();
+              m_minEnergy = m_energyMonitor.GetRemainingEnergy ();
 
         Ipv4InterfaceAddress iface;
         Ipv4Address ipv4ifaceSink;
         //find the best entry to create its hello header
+        m_helloCounter++;
+        m_channelLoad.Sample ();
+        UpdateTxPower ();
+        if (m_sinkLoadBalancing)
+          {
+            std::set<Ipv4Address> subtree;
+            m_routingTableDown.GetDestinations (subtree);
+            m_routingTableUp.SetSubtreeSize (std::min<size_t> (subtree.size () + 1, 65535));
+          }
 
           for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
             {i++;//dms asupp
               Ptr<Socket> socket = j->first;
                iface = j->second;
         //  NS_LOG_UNCOND("remaining energy for sink is: "<<EnergySrc->GetRemainingEnergy ()*100);
-              HelloHeader helloHeader (/*prefix size= 0,*/ /*hops=*/ myRoutingEntry.GetHop(), /* reserved*/ 0,/* Min Energy*/ std::min (myRoutingEntry.GetCumEnergy(),(float)m_minEnergy),/* Min snr*/ myRoutingEntry.GetMinSnr(), /*sink=*/ myRoutingEntry.GetDestination (), /*seqno=*/ myRoutingEntry.GetSeqNo());
+              HelloHeader helloHeader;
+              MakeHelloHeader (iface, helloHeader);
               Ptr<Packet> packet = Create<Packet> ();
               SocketIpTtlTag tag;
               tag.SetTtl (1);
@@ -1558,8 +2684,7 @@ Ipv4Address ipv4ifaceSink;
                 {
                   destination = iface.GetBroadcast ();
                 }
-              Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-              Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
+              ScheduleTo (socket, packet, destination);
           // NS_LOG_UNCOND("cumul energy for sink is: "<<helloHeader.GetMinEnergy ()*100);
            
             }
@@ -1591,6 +2716,10 @@ else
       Ptr<Socket> socket = j->first;
       Ipv4InterfaceAddress iface = j->second;
       AdvertiseHeader advertiseHeader ( /*hops=*/ 0, /*prefix size=*/ 0, /*orig=*/ iface.GetLocal (), /*seqno=*/ m_AseqNo);
+      if (m_enableTopologyReport)
+        {
+          advertiseHeader.SetReport (MakeTopologyReport ());
+        }
       Ptr<Packet> packet = Create<Packet> ();
       SocketIpTtlTag tag;
       tag.SetTtl (1);
@@ -1603,12 +2732,13 @@ else
       m_routingTableUp.LookupBestRoute(RtoSink);
       if((!m_routingTableUp.IsEmpty()))                         //  && RtoSink.GetFlag () == VALID
       {
-        Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-        Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, RtoSink.GetNextHop () );          
+        ScheduleTo (socket, packet, RtoSink.GetNextHop ());          
       }
     }
 
 m_AseqNo++;
+m_lastAdvertise = Simulator::Now ();
+m_advertisePiggybacked = false;
 }
 }
 
@@ -1673,8 +2803,7 @@ else
 
 
 
-                Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-                Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, m_serverAdress );
+                ScheduleTo (socket, packet, m_serverAdress);
          }
         }
              
@@ -1691,8 +2820,6 @@ RoutingProtocol::ForwardHello2 ( HelloHeader helloHeader)   //DMS
 {
 int i=0;//dms asupp
   NS_LOG_FUNCTION (this);
- Ptr<EnergySource> EnergySrc;
-      EnergySrc = this->GetObject<EnergySourceContainer> ()->Get (0);
 if(((m_socketAddresses.begin()->second).GetLocal ()==Ipv4Address("10.1.0.8"))||((m_socketAddresses.begin()->second).GetLocal ()==Ipv4Address("10.1.0.17")))
 {
  // NS_LOG_UNCOND ((m_socketAddresses.begin()->second).GetLocal ()<< "BATERY remaining enrgy: "<<EnergySrc->GetRemainingEnergy ()<<" cumul enrgy: "<<m_minEnergy); //DMS2
@@ -1725,8 +2852,7 @@ if(((m_socketAddresses.begin()->second).GetLocal ()==Ipv4Address("10.1.0.8"))||(
         {
           destination = iface.GetBroadcast ();
         }
-      Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-      Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, destination);
+      ScheduleTo (socket, packet, destination);
 
     }
 }
@@ -1740,6 +2866,15 @@ RoutingProtocol::ForwardAdvertise ( AdvertiseHeader advertiseHeader)   //DMS   f
 int i=0;//dms asupp
   NS_LOG_FUNCTION (this);
 
+  if (m_downlinkMode == NON_STORING && !m_isSink)
+    {
+      RoutingTableEntryUp toParent;
+      if (m_routingTableUp.LookupBestRoute (toParent))
+        {
+          // the sink source-routes the downlink packets through the relays of the path
+          advertiseHeader.AddRelay (toParent.GetInterface ().GetLocal ());
+        }
+    }
 
   for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
     {i++;//dms asupp
@@ -1754,7 +2889,6 @@ int i=0;//dms asupp
 
      RoutingTableEntryUp RtoSink;
      m_routingTableUp.LookupBestRoute(RtoSink);
-        Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
         if(m_isSink)
         { 
           return;//Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, m_serverAdress );   
@@ -1763,7 +2897,7 @@ int i=0;//dms asupp
         { 
            if((!m_routingTableUp.IsEmpty()))
             {
-               Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, RtoSink.GetNextHop () ); 
+               ScheduleTo (socket, packet, RtoSink.GetNextHop ());
             }  
         }
       
@@ -1814,8 +2948,12 @@ else
                               TypeHeader tHeader (DMSRPTYPE_SRVADVERTISE);
                               packet->AddHeader (tHeader);
  
-                                Time jitter = Time (MilliSeconds (m_uniformRandomVariable->GetInteger (0, 10)));
-                                Simulator::Schedule (jitter, &RoutingProtocol::SendTo, this, socket, packet, m_serverAdress );                    
+                                std::vector<Ipv4Address> servers;
+                                GetAdvertiseServers (srvadvertiseHeader.GetOrigin (), servers);
+                                for (std::vector<Ipv4Address>::const_iterator i = servers.begin (); i != servers.end (); ++i)
+                                  {
+                                    ScheduleTo (socket, packet->Copy (), *i);
+                                  }
              }
           }
      }
@@ -1823,63 +2961,1101 @@ m_AseqNo++;
 }
 }
 
-Ptr<Socket>
-RoutingProtocol::FindSocketWithInterfaceAddress (Ipv4InterfaceAddress addr ) const
+void
+RoutingProtocol::UpdateClusterRole ()
 {
-  NS_LOG_FUNCTION (this << addr);
-  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
-         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+  if (!m_enableClusters || m_isSink || m_isServer || m_downlinkMode != STORING)
     {
-      Ptr<Socket> socket = j->first;
-      Ipv4InterfaceAddress iface = j->second;
-      if (iface == addr)
-        {
-          return socket;
-        }
+      return;
     }
-  Ptr<Socket> socket;
-  return socket;
-}
-
-Ptr<Socket>
-RoutingProtocol::FindSubnetBroadcastSocketWithInterfaceAddress (Ipv4InterfaceAddress addr ) const
-{
-  NS_LOG_FUNCTION (this << addr);
-  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
-         m_socketSubnetBroadcastAddresses.begin (); j != m_socketSubnetBroadcastAddresses.end (); ++j)
+  double initial = m_energyMonitor.GetInitialEnergy ();
+  double fraction = initial > 0 ? m_energyMonitor.GetRemainingEnergy () / initial : 0;
+  m_clusterScore = fraction * (1 + m_nb.GetNeighborCount ());
+
+  float best = 0;
+  Ipv4Address bestNeighbor;
+  bool contested = m_nb.GetBestClusterScore (best, bestNeighbor);
+  bool head;
+  if (fraction < m_clusterMinEnergy)
     {
-      Ptr<Socket> socket = j->first;
-      Ipv4InterfaceAddress iface = j->second;
-      if (iface == addr)
-        {
-          return socket;
-        }
+      head = false;
+    }
+  else if (!contested)
+    {
+      // alone, or the neighbors did not tell their scores yet
+      head = m_isClusterHead;
+    }
+  else if (m_isClusterHead)
+    {
+      head = m_clusterScore >= best * (1 - m_clusterHysteresis);
+    }
+  else
+    {
+      Ipv4Address self = m_ipv4->GetAddress (1, 0).GetLocal ();
+      head = m_clusterScore > best * (1 + m_clusterHysteresis)
+        || (m_clusterHysteresis == 0 && m_clusterScore == best && bestNeighbor < self);
+    }
+  if (head != m_isClusterHead)
+    {
+      NS_LOG_LOGIC ((head ? "Cluster head elected" : "Cluster head resigns") << ", score " << m_clusterScore
+                    << " best neighbor " << bestNeighbor << " " << best);
+      m_isClusterHead = head;
+      m_clusterRoleTrace (head);
     }
-  Ptr<Socket> socket;
-  return socket;
 }
 
-/// Trace function for handle energy depletion.   //DMS
-void
-RoutingProtocol::EnergyDepletion (void) 
+bool
+RoutingProtocol::AbsorbsAdvertise (Ipv4Address origin)
 {
-  //NS_LOG_UNCOND ("Energy depletion WWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWW   "<<Simulator::Now ());
+  return m_isClusterHead && !m_isSink && !IsMyOwnAddress (origin);
 }
+
 void
-RoutingProtocol::DepletionHandler (void)                                            // callback function for energy depletion
+RoutingProtocol::SendClusterAdvertise ()
 {
-
-m_depTimeTrace();
-  //NS_LOG_UNCOND ("Energy depletion"<<Simulator::Now ());
-  //  NS_LOG_UNCOND ("Energy depletion handler   "<<Simulator::Now ());
-   // DoDispose();                                                                   // if the energy source is drained -> the routing protocol stop functioning
+  NS_LOG_FUNCTION (this);
+  std::set<Ipv4Address> members;
+  m_routingTableDown.GetDestinations (members);
+  if (members.empty ())
+    {
+      return;
+    }
+  CountingBloomFilter filter (m_clusterFilterSize, m_bloomHashCount);
+  for (std::set<Ipv4Address>::const_iterator i = members.begin (); i != members.end (); ++i)
+    {
+      filter.Add (*i);
+    }
+  std::vector<uint8_t> bits;
+  filter.GetBits (bits);
+  ClusterAdvertiseHeader clusterHeader (m_ipv4->GetAddress (1, 0).GetLocal (), m_clusterSeqNo++);
+  clusterHeader.SetMembers (m_clusterFilterSize, m_bloomHashCount, bits);
+  ForwardClusterAdvertise (clusterHeader);
 }
 
 void
-RoutingProtocol::DoInitialize (void)
+RoutingProtocol::RecvClusterAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
 {
+  NS_LOG_FUNCTION (this << receiver << src);
+  ClusterAdvertiseHeader clusterHeader;
+  p->RemoveHeader (clusterHeader);
+  uint8_t hop = clusterHeader.GetHopCount () + 1;
+  clusterHeader.SetHopCount (hop);
+  if (hop > m_maxAdvertiseHops || IsMyOwnAddress (clusterHeader.GetHead ()))
+    {
+      return;
+    }
 
-Ipv4InterfaceAddress iface;
+  CountingBloomFilter members (clusterHeader.GetCellCount (), clusterHeader.GetHashCount ());
+  members.SetBits (clusterHeader.GetMembers ());
+  Ipv4InterfaceAddress iface = m_ipv4->GetAddress (m_ipv4->GetInterfaceForAddress (receiver), 0);
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver));
+  // the server reaches the head through the sink, the others through the child the summary came from
+  Ipv4Address nextHop = m_isServer ? clusterHeader.GetSink () : src;
+  if (m_isServer)
+    {
+      m_routingTableServer.NotifySinkAlive (nextHop, iface);
+    }
+  RoutingTableEntryDown toHead (/*device=*/ dev, /*dst=*/ clusterHeader.GetHead (), /*seqNo=*/ clusterHeader.GetSeqNo (),
+                                /*iface=*/ iface, /*hops=*/ hop, /*nextHop=*/ nextHop, /*timeLife=*/ m_activeRouteTimeout);
+  if (!m_clusterTable.Update (clusterHeader.GetHead (), clusterHeader.GetSeqNo (), members, toHead, m_activeRouteTimeout))
+    {
+      return;
+    }
+  if (!m_isServer)
+    {
+      ForwardClusterAdvertise (clusterHeader);
+    }
+}
+
+void
+RoutingProtocol::ForwardClusterAdvertise (ClusterAdvertiseHeader clusterHeader)
+{
+  NS_LOG_FUNCTION (this << clusterHeader.GetHead ());
+  RoutingTableEntryUp toParent;
+  if (!m_routingTableUp.LookupBestRoute (toParent))
+    {
+      return;
+    }
+  Ptr<Socket> socket;
+  std::vector<Ipv4Address> destinations;
+  if (m_isSink)
+    {
+      // every server may have to reach the cluster, whatever the distribution of the advertises
+      clusterHeader.SetSink (toParent.GetRoute ()->GetSource ());
+      socket = GetSinkOutputSocket ();
+      m_servers.GetAlive (destinations);
+      if (destinations.empty ())
+        {
+          destinations.push_back (m_serverAdress);
+        }
+    }
+  else
+    {
+      socket = FindSocketWithInterfaceAddress (toParent.GetInterface ());
+      destinations.push_back (toParent.GetNextHop ());
+    }
+  if (!socket)
+    {
+      return;
+    }
+  for (std::vector<Ipv4Address>::const_iterator i = destinations.begin (); i != destinations.end (); ++i)
+    {
+      Ptr<Packet> packet = Create<Packet> ();
+      SocketIpTtlTag tag;
+      tag.SetTtl (1);
+      packet->AddPacketTag (tag);
+      packet->AddHeader (clusterHeader);
+      TypeHeader tHeader (DMSRPTYPE_CLUSTERADVERTISE);
+      packet->AddHeader (tHeader);
+      ScheduleTo (socket, packet, *i);
+    }
+}
+
+bool
+RoutingProtocol::LookupDownRoute (Ipv4Address dst, RoutingTableEntryDown & rt)
+{
+  return m_routingTableDown.LookupRoute (dst, rt) || m_clusterTable.Lookup (dst, rt);
+}
+
+bool
+RoutingProtocol::LookupServerRoute (Ipv4Address dst, RoutingTableEntryDown & rt)
+{
+  return m_routingTableServer.LookupRoute (dst, rt) || m_clusterTable.Lookup (dst, rt);
+}
+
+Ptr<Socket>
+RoutingProtocol::GetSinkOutputSocket () const
+{
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      if (m_ipv4->GetInterfaceForDevice (m_sinkOutPutDevice) == m_ipv4->GetInterfaceForAddress (j->second.GetLocal ()))
+        {
+          return j->first;
+        }
+    }
+  return Ptr<Socket> ();
+}
+
+void
+RoutingProtocol::GetAdvertiseServers (Ipv4Address origin, std::vector<Ipv4Address> & servers) const
+{
+  servers.clear ();
+  if (m_servers.GetSize () > 1)
+    {
+      Ipv4Address server;
+      if (m_serverDistribution == REPLICATE)
+        {
+          m_servers.GetAlive (servers);
+        }
+      else if (m_servers.Select (origin.Get (), server))
+        {
+          // the same key as FlowKey: the packets to origin go to the server which knows it
+          servers.push_back (server);
+        }
+    }
+  if (servers.empty ())
+    {
+      servers.push_back (m_serverAdress);
+    }
+}
+
+uint32_t
+RoutingProtocol::FlowKey (Ptr<const Packet> p, Ipv4Header const & header) const
+{
+  if (m_serverDistribution == PARTITION)
+    {
+      return header.GetDestination ().Get ();
+    }
+  uint32_t key = header.GetSource ().Get () * 31 + header.GetDestination ().Get ();
+  key = key * 31 + header.GetProtocol ();
+  if ((header.GetProtocol () == UdpL4Protocol::PROT_NUMBER || header.GetProtocol () == TcpL4Protocol::PROT_NUMBER)
+      && header.GetFragmentOffset () == 0 && p->GetSize () >= 4)
+    {
+      // source and destination ports
+      uint8_t ports[4];
+      p->CopyData (ports, 4);
+      key = key * 31 + ((ports[0] << 24) | (ports[1] << 16) | (ports[2] << 8) | ports[3]);
+    }
+  return key;
+}
+
+Ptr<Ipv4Route>
+RoutingProtocol::RouteToServer (Ptr<Ipv4Route> route, Ipv4Address server) const
+{
+  Ptr<Ipv4Route> toServer = Create<Ipv4Route> ();
+  toServer->SetDestination (server);
+  toServer->SetSource (route->GetSource ());
+  toServer->SetGateway (server);
+  toServer->SetOutputDevice (route->GetOutputDevice ());
+  return toServer;
+}
+
+uint32_t
+RoutingProtocol::GetServerLoad ()
+{
+  Time elapsed = Simulator::Now () - m_srvLoadStart;
+  if (elapsed >= Seconds (1))
+    {
+      m_srvLoad = m_srvLoadCount / elapsed.GetSeconds ();
+      m_srvLoadCount = 0;
+      m_srvLoadStart = Simulator::Now ();
+    }
+  return m_srvLoad;
+}
+
+void
+RoutingProtocol::SrvProbeTimerExpire ()
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Ipv4Address> died;
+  m_servers.Refresh (died);
+  for (std::vector<Ipv4Address>::const_iterator i = died.begin (); i != died.end (); ++i)
+    {
+      NotifyServerChange (*i, false);
+    }
+  Ptr<Socket> socket = GetSinkOutputSocket ();
+  if (socket)
+    {
+      std::vector<Ipv4Address> servers;
+      m_servers.GetServers (servers);
+      for (std::vector<Ipv4Address>::const_iterator i = servers.begin (); i != servers.end (); ++i)
+        {
+          Ptr<Packet> packet = Create<Packet> ();
+          SocketIpTtlTag tag;
+          tag.SetTtl (1);
+          packet->AddPacketTag (tag);
+          packet->AddHeader (ServerProbeHeader (m_srvProbeSeqNo));
+          TypeHeader tHeader (DMSRPTYPE_SRVPROBE);
+          packet->AddHeader (tHeader);
+          ScheduleTo (socket, packet, *i);
+        }
+    }
+  m_srvProbeSeqNo++;
+  m_srvProbeTimer.Schedule (m_serverProbeInterval);
+}
+
+void
+RoutingProtocol::RecvSrvProbe (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << src);
+  ServerProbeHeader probe;
+  p->RemoveHeader (probe);
+  if (!m_isServer)
+    {
+      return;
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      if (j->second.GetLocal () == receiver)
+        {
+          uint32_t load = GetServerLoad ();
+          Ptr<Packet> packet = Create<Packet> ();
+          SocketIpTtlTag tag;
+          tag.SetTtl (1);
+          packet->AddPacketTag (tag);
+          packet->AddHeader (ServerProbeHeader (probe.GetSeqNo (), load, m_serverCapacity > 0 && load > m_serverCapacity));
+          TypeHeader tHeader (DMSRPTYPE_SRVPROBE_REPLY);
+          packet->AddHeader (tHeader);
+          ScheduleTo (j->first, packet, src);
+          return;
+        }
+    }
+}
+
+void
+RoutingProtocol::RecvSrvProbeReply (Ptr<Packet> p, Ipv4Address, Ipv4Address src)
+{
+  NS_LOG_FUNCTION (this << src);
+  ServerProbeHeader reply;
+  p->RemoveHeader (reply);
+  if (!m_isSink)
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Server " << src << " load " << reply.GetLoad () << " overloaded " << reply.IsOverloaded ());
+  if (m_servers.NotifyReply (src, reply.IsOverloaded ()))
+    {
+      NotifyServerChange (src, true);
+    }
+}
+
+void
+RoutingProtocol::NotifyServerChange (Ipv4Address server, bool alive)
+{
+  NS_LOG_FUNCTION (this << server << alive);
+  m_serverStateTrace (server, alive);
+  // the servers which own a node, or the new server, miss the advertises already forwarded
+  m_forwardedAdvertises.Clear ();
+}
+
+void
+RoutingProtocol::SendRerrWhenNoRouteToForward (Ipv4Address dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  RerrHeader rerrHeader;
+  rerrHeader.AddUnDestination (dst, 0);
+  SendRerrMessage (rerrHeader);
+}
+
+void
+RoutingProtocol::SendRerrWhenBreaksLinkToNextHop (Ipv4Address nextHop)
+{
+  NS_LOG_FUNCTION (this << nextHop);
+  // lost parent: the next best parent (if any) takes over at once
+  m_routingTableUp.DeleteRoute (nextHop);
+
+  // lost child: every destination below it is now unreachable through this node
+  m_descendants.DeleteChild (nextHop);
+  std::map<Ipv4Address, uint32_t> unreachable;
+  m_routingTableDown.GetListOfDestinationWithNextHop (nextHop, unreachable);
+  if (unreachable.empty ())
+    {
+      return;
+    }
+  RerrHeader rerrHeader;
+  for (std::map<Ipv4Address, uint32_t>::const_iterator i = unreachable.begin (); i != unreachable.end (); ++i)
+    {
+      m_routingTableDown.DeleteRoute (i->first);
+      if (!rerrHeader.AddUnDestination (i->first, i->second))
+        {
+          SendRerrMessage (rerrHeader);
+          rerrHeader.Clear ();
+          rerrHeader.AddUnDestination (i->first, i->second);
+        }
+    }
+  SendRerrMessage (rerrHeader);
+}
+
+void
+RoutingProtocol::SendRerrMessage (RerrHeader rerrHeader)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_isServer)
+    {
+      return;
+    }
+  if (m_isSink)
+    {
+      // the server drops these destinations: their next advertise must reach it
+      RerrHeader reported = rerrHeader;
+      std::pair<Ipv4Address, uint32_t> un;
+      while (reported.RemoveUnDestination (un))
+        {
+          m_forwardedAdvertises.Forget (un.first);
+        }
+    }
+  if (m_rerrCount == m_rerrRateLimit)
+    {
+      // Just make sure that the RerrRateLimit timer is running and will expire
+      NS_ASSERT (m_rerrRateLimitTimer.IsRunning ());
+      // discard the packet and return
+      NS_LOG_LOGIC ("RerrRateLimit reached at " << Simulator::Now ().As (Time::S) << " with timer delay left "
+                                                << m_rerrRateLimitTimer.GetDelayLeft ().As (Time::S)
+                                                << "; suppressing RERR");
+      return;
+    }
+
+  // a relay reports to its parent, a sink reports to the server over its output device
+  RoutingTableEntryUp toParent;
+  if (!m_routingTableUp.LookupBestRoute (toParent))
+    {
+      NS_LOG_LOGIC ("No parent to report the route error to");
+      return;
+    }
+  Ptr<Socket> socket = FindSocketWithInterfaceAddress (toParent.GetInterface ());
+  NS_ASSERT (socket);
+  std::vector<Ipv4Address> destinations;
+  if (!m_isSink)
+    {
+      destinations.push_back (toParent.GetNextHop ());
+    }
+  else
+    {
+      // the lost destinations may be known by any server
+      m_servers.GetAlive (destinations);
+      if (destinations.empty ())
+        {
+          destinations.push_back (m_serverAdress);
+        }
+    }
+
+  Ptr<Packet> packet = Create<Packet> ();
+  SocketIpTtlTag tag;
+  tag.SetTtl (1);
+  packet->AddPacketTag (tag);
+  packet->AddHeader (rerrHeader);
+  TypeHeader tHeader (DMSRPTYPE_RERR);
+  packet->AddHeader (tHeader);
+  m_rerrCount++;
+
+  for (std::vector<Ipv4Address>::const_iterator i = destinations.begin (); i != destinations.end (); ++i)
+    {
+      ScheduleTo (socket, packet->Copy (), *i);
+    }
+}
+
+void
+RoutingProtocol::RerrRateLimitTimerExpire ()
+{
+  NS_LOG_FUNCTION (this);
+  m_rerrCount = 0;
+  m_rerrRateLimitTimer.Schedule (Seconds (1));
+}
+
+bool
+RoutingProtocol::MakeHelloHeader (Ipv4InterfaceAddress iface, HelloHeader & helloHeader)
+{
+  float remainingEnergy = m_energyMonitor.GetRemainingEnergy ();
+  if (m_isSink)
+    {
+      helloHeader = HelloHeader (/*hops=*/ 0, /* reserved*/ 0, /* Min Energy*/ remainingEnergy, /* Min snr*/ 9999.0,
+                                 /*orig=sink*/ iface.GetLocal (), /*seqno=*/ m_HseqNo);
+      AddLinkQuality (helloHeader, 0);
+      if (m_routingMode == AIRTIME_MODE)
+        {
+          helloHeader.SetPathAirtime (0);
+        }
+      AddChannelLoad (helloHeader);
+      AddMobility (helloHeader);
+      AddTxPower (helloHeader);
+      AddPathLifetime (helloHeader, MAX_PATH_LIFETIME);
+      AddSinkLoad (helloHeader);
+      return true;
+    }
+  RoutingTableEntryUp myRoutingEntry;
+  if (!m_routingTableUp.LookupBestRoute (myRoutingEntry))
+    {
+      return false;
+    }
+  helloHeader = HelloHeader (/*hops=*/ myRoutingEntry.GetHop (), /* reserved*/ 0,
+                             /* Min Energy*/ std::min (myRoutingEntry.GetCumEnergy (), remainingEnergy),
+                             /* Min snr*/ myRoutingEntry.GetMinSnr (), /*sink=*/ myRoutingEntry.GetDestination (),
+                             /*seqno=*/ myRoutingEntry.GetSeqNo ());
+  if (m_enableClusters && m_downlinkMode == STORING)
+    {
+      helloHeader.SetCluster (m_clusterScore, m_isClusterHead);
+    }
+  AddLinkQuality (helloHeader, myRoutingEntry.GetPathEtx ());
+  if (m_routingMode == AIRTIME_MODE)
+    {
+      helloHeader.SetPathAirtime (myRoutingEntry.GetPathAirtime ());
+    }
+  AddChannelLoad (helloHeader);
+  AddMobility (helloHeader);
+  AddTxPower (helloHeader);
+  AddPathLifetime (helloHeader, myRoutingEntry.GetPathLifetime ());
+  AddSinkLoad (helloHeader);
+
+  // the routes to the other sinks, for the neighbors to keep a way out if this one breaks
+  std::set<Ipv4Address> sinks;
+  m_routingTableUp.GetSinks (sinks);
+  for (std::set<Ipv4Address>::const_iterator i = sinks.begin ();
+       i != sinks.end () && helloHeader.GetSinkCount () + 1u < m_maxHelloSinks; ++i)
+    {
+      RoutingTableEntryUp toSink;
+      if (*i == myRoutingEntry.GetDestination () || !m_routingTableUp.LookupSinkRoute (*i, toSink))
+        {
+          continue;
+        }
+      helloHeader.AddSinkRecord (HelloHeader (/*hops=*/ toSink.GetHop (), /* reserved*/ 0,
+                                              /* Min Energy*/ std::min (toSink.GetCumEnergy (), remainingEnergy),
+                                              /* Min snr*/ toSink.GetMinSnr (), /*sink=*/ *i, /*seqno=*/ toSink.GetSeqNo ()));
+    }
+  return true;
+}
+
+void
+RoutingProtocol::PiggybackAdvertise (Ptr<Packet> packet, Ipv4Header & header, Ptr<Ipv4Route> route, PiggybackHeader const & carried)
+{
+  Ipv4Address origin = header.GetSource ();
+  AdvertiseHeader advertiseHeader;
+  bool own = false;
+  if (carried.HasAdvertise ())
+    {
+      advertiseHeader = carried.GetAdvertise (origin);
+    }
+  else if (m_enablePiggyback && m_downlinkMode == STORING && IsMyOwnAddress (origin)
+           && Simulator::Now () - m_lastAdvertise >= m_piggybackFreshness / 2)
+    {
+      advertiseHeader = AdvertiseHeader (/*hops=*/ 0, /*prefix size=*/ 0, /*orig=*/ origin, /*seqno=*/ m_AseqNo);
+      own = true;
+    }
+  else
+    {
+      return;
+    }
+
+  if (route->GetGateway () == header.GetDestination ())
+    {
+      // the option must not reach the destination
+      if (!own)
+        {
+          PropagateAdvertise (advertiseHeader);
+        }
+      return;
+    }
+  NS_LOG_LOGIC ("Piggyback advertise of " << origin << " seqno " << advertiseHeader.GetOriginSeqno ());
+  PiggybackHeader piggyback (header.GetProtocol (), route->GetSource ());
+  piggyback.SetAdvertise (advertiseHeader);
+  AddPiggyback (packet, header, piggyback);
+  if (own)
+    {
+      m_AseqNo++;
+      m_lastAdvertise = Simulator::Now ();
+      m_advertisePiggybacked = true;
+    }
+}
+
+void
+RoutingProtocol::PiggybackHello (Ptr<Packet> packet, Ipv4Header & header, Ptr<Ipv4Route> route, Ipv4InterfaceAddress iface)
+{
+  Ipv4Address nextHop = route->GetGateway ();
+  if (!m_enablePiggyback || nextHop == header.GetDestination ())
+    {
+      return;
+    }
+  std::map<Ipv4Address, Time>::const_iterator i = m_lastHelloPiggyback.find (nextHop);
+  if (i != m_lastHelloPiggyback.end () && Simulator::Now () - i->second < m_piggybackFreshness / 2)
+    {
+      return;
+    }
+  HelloHeader helloHeader;
+  if (!MakeHelloHeader (iface, helloHeader))
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Piggyback Hello to " << nextHop);
+  PiggybackHeader piggyback (header.GetProtocol (), route->GetSource ());
+  piggyback.SetHello (helloHeader);
+  AddPiggyback (packet, header, piggyback);
+  m_lastHelloPiggyback[nextHop] = Simulator::Now ();
+}
+
+void
+RoutingProtocol::AddPiggyback (Ptr<Packet> packet, Ipv4Header & header, PiggybackHeader & piggyback)
+{
+  piggyback.SetNextHeader (header.GetProtocol ());
+  packet->AddHeader (piggyback);
+  TypeHeader tHeader (DMSRPTYPE_PIGGYBACK);
+  packet->AddHeader (tHeader);
+  header.SetProtocol (DMSRP_DATA_PROT_NUMBER);
+  header.SetPayloadSize (header.GetPayloadSize () + tHeader.GetSerializedSize () + piggyback.GetSerializedSize ());
+}
+
+void
+RoutingProtocol::AddLinkQuality (HelloHeader & helloHeader, float pathEtx)
+{
+  if (m_routingMode != ETX_MODE)
+    {
+      return;
+    }
+  // piggybacked Hellos carry the counter of the last broadcast one, they are not counted twice
+  helloHeader.SetLinkQuality (m_helloCounter, pathEtx);
+  std::vector<std::pair<Ipv4Address, uint8_t> > receptions;
+  m_nb.GetReceptions (receptions);
+  for (std::vector<std::pair<Ipv4Address, uint8_t> >::const_iterator i = receptions.begin ();
+       i != receptions.end () && helloHeader.AddLinkRecord (i->first, i->second); ++i)
+    {
+    }
+}
+
+void
+RoutingProtocol::AddChannelLoad (HelloHeader & helloHeader)
+{
+  if (m_routingMode != CHANNEL_LOAD_MODE)
+    {
+      return;
+    }
+  helloHeader.SetChannelLoad ((uint8_t) std::floor (m_channelLoad.GetLoad () * 255 + 0.5));
+}
+
+void
+RoutingProtocol::AddMobility (HelloHeader & helloHeader)
+{
+  Ptr<MobilityModel> mobility = m_ipv4->GetObject<MobilityModel> ();
+  if ((m_routingMode != LINK_LIFETIME_MODE && !m_adaptiveRouteTimeout) || mobility == 0)
+    {
+      return;
+    }
+  helloHeader.SetMobility (mobility->GetPosition (), mobility->GetVelocity ());
+}
+
+void
+RoutingProtocol::AddTxPower (HelloHeader & helloHeader)
+{
+  if (!m_enablePowerControl)
+    {
+      return;
+    }
+  // the broadcasts go out at full power
+  helloHeader.SetTxPower (m_maxTxPower);
+}
+
+void
+RoutingProtocol::AddPathLifetime (HelloHeader & helloHeader, float pathLifetime)
+{
+  if (m_routingMode != PATH_LIFETIME_MODE)
+    {
+      return;
+    }
+  double lifetime = std::min (m_energyMonitor.GetLifetime ().GetSeconds (), MAX_PATH_LIFETIME);
+  helloHeader.SetPathLifetime (std::min ((float) lifetime, pathLifetime));
+}
+
+void
+RoutingProtocol::AddSinkLoad (HelloHeader & helloHeader)
+{
+  if (!m_sinkLoadBalancing)
+    {
+      return;
+    }
+  if (m_isSink)
+    {
+      std::set<Ipv4Address> subtree;
+      m_routingTableDown.GetDestinations (subtree);
+      helloHeader.SetSinkLoad (std::min<size_t> (subtree.size (), 65535), m_sinkUplinkLoad);
+      return;
+    }
+  uint16_t subtreeSize;
+  uint8_t uplinkLoad;
+  if (m_routingTableUp.GetSinkLoad (helloHeader.GetOrigin (), subtreeSize, uplinkLoad))
+    {
+      helloHeader.SetSinkLoad (subtreeSize, uplinkLoad);
+    }
+}
+
+void
+RoutingProtocol::SampleSinkUplink ()
+{
+  if (!m_sinkLoadBalancing)
+    {
+      return;
+    }
+  DataRate rate = m_sinkUplinkRate;
+  DataRateValue value;
+  if (rate.GetBitRate () == 0 && m_sinkOutPutDevice != 0 && m_sinkOutPutDevice->GetAttributeFailSafe ("DataRate", value))
+    {
+      rate = value.Get ();
+    }
+  Time elapsed = Simulator::Now () - m_sinkUplinkSample;
+  if (elapsed.IsStrictlyPositive () && rate.GetBitRate () > 0)
+    {
+      double utilisation = std::min (m_sinkUplinkBytes * 8.0 / (rate.GetBitRate () * elapsed.GetSeconds ()), 1.0);
+      m_sinkUplinkLoad = (uint8_t) std::floor (utilisation * 255 + 0.5);
+    }
+  m_sinkUplinkBytes = 0;
+  m_sinkUplinkSample = Simulator::Now ();
+}
+
+void
+RoutingProtocol::UpdateTxPower ()
+{
+  if (!m_enablePowerControl)
+    {
+      return;
+    }
+  // the children are known in the storing mode only; otherwise every neighbor may be one
+  std::set<Ipv4Address> nextHops;
+  if (m_downlinkMode == STORING)
+    {
+      m_routingTableDown.GetChildren (nextHops);
+    }
+  else
+    {
+      m_nb.GetNeighbors (nextHops);
+    }
+  RoutingTableEntryUp toSink;
+  if (!m_isSink && m_routingTableUp.LookupBestRoute (toSink))
+    {
+      nextHops.insert (toSink.GetNextHop ());
+    }
+  // a node without next hop looks for neighbors at full power
+  double txPower = nextHops.empty () ? m_maxTxPower : m_minTxPower;
+  for (std::set<Ipv4Address>::const_iterator i = nextHops.begin (); i != nextHops.end (); ++i)
+    {
+      double required;
+      if (!m_nb.GetRequiredTxPower (*i, m_targetSnr + m_powerMargin, required))
+        {
+          txPower = m_maxTxPower;
+          break;
+        }
+      txPower = std::max (txPower, required);
+    }
+  m_txPower = std::min (txPower, m_maxTxPower);
+  NS_LOG_LOGIC ("Transmit power " << m_txPower << " dBm for " << nextHops.size () << " next hops");
+}
+
+void
+RoutingProtocol::SetFrameTxPower (Ptr<const Packet> packet, double)
+{
+  // the frames carry no power of their own: the PHY reads its power range once
+  // this trace returns, both for the channel and for the energy model
+  WifiMacHeader header;
+  if (packet->PeekHeader (header) != 0 && header.GetAddr1 ().IsGroup ())
+    {
+      SetPhyTxPower (m_maxTxPower);
+    }
+  else
+    {
+      SetPhyTxPower (m_txPower);
+    }
+}
+
+void
+RoutingProtocol::SetPhyTxPower (double txPower)
+{
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (j->second.GetLocal ()));
+      Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
+      if (wifi != 0 && wifi->GetPhy () != 0)
+        {
+          wifi->GetPhy ()->SetTxPowerStart (txPower);
+          wifi->GetPhy ()->SetTxPowerEnd (txPower);
+        }
+    }
+}
+
+Time
+RoutingProtocol::GetLinkLifetime (Ipv4Address neighbor)
+{
+  Ptr<MobilityModel> mobility = m_ipv4->GetObject<MobilityModel> ();
+  if (mobility == 0)
+    {
+      return Simulator::GetMaximumSimulationTime ();
+    }
+  return m_nb.GetLinkLifetime (neighbor, mobility->GetPosition (), mobility->GetVelocity (), m_transmissionRange);
+}
+
+Time
+RoutingProtocol::GetRouteTimeout (Ipv4Address neighbor)
+{
+  Ptr<MobilityModel> mobility = m_ipv4->GetObject<MobilityModel> ();
+  if (!m_adaptiveRouteTimeout || mobility == 0)
+    {
+      return m_activeRouteTimeout;
+    }
+  // a neighbor that did not advertise its motion is taken as still
+  Vector relative = mobility->GetVelocity ();
+  Vector velocity;
+  if (m_nb.GetVelocity (neighbor, velocity))
+    {
+      relative.x -= velocity.x;
+      relative.y -= velocity.y;
+    }
+  double speed = std::sqrt (relative.x * relative.x + relative.y * relative.y);
+  if (speed * m_maxRouteTimeout.GetSeconds () <= m_routeTimeoutDistance)
+    {
+      return m_maxRouteTimeout;
+    }
+  return std::max (Seconds (m_routeTimeoutDistance / speed), m_minRouteTimeout);
+}
+
+double
+RoutingProtocol::GetLinkAirtime (Ipv4Address neighbor, Ipv4Address receiver)
+{
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver));
+  Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
+  if (wifi == 0 || wifi->GetRemoteStationManager () == 0)
+    {
+      return MAX_AIRTIME;
+    }
+  Ptr<WifiRemoteStationManager> manager = wifi->GetRemoteStationManager ();
+  // a neighbor not resolved by ARP yet is costed at the rate of the broadcast frames
+  Mac48Address mac = m_nb.GetHardwareAddress (neighbor);
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  hdr.SetAddr1 (mac == Mac48Address () ? Mac48Address::GetBroadcast () : mac);
+  WifiTxVector txVector = manager->GetDataTxVector (hdr);
+  uint64_t rate = txVector.GetMode ().GetDataRate (txVector);
+  double errorRate = mac == Mac48Address () ? 0 : manager->GetInfo (mac).GetFrameErrorRate ();
+  if (rate == 0 || errorRate >= 1)
+    {
+      return MAX_AIRTIME;
+    }
+  // IEEE 802.11s airtime: (O + Bt / r) / (1 - ef)
+  double airtime = (m_airtimeOverhead.GetMicroSeconds () + m_airtimeTestFrameSize * 8 * 1e6 / rate) / (1 - errorRate);
+  return std::min (airtime, MAX_AIRTIME);
+}
+
+bool
+RoutingProtocol::ChildrenHaveFreshHello ()
+{
+  std::set<Ipv4Address> children;
+  m_routingTableDown.GetChildren (children);
+  if (children.empty ())
+    {
+      return false;
+    }
+  for (std::set<Ipv4Address>::const_iterator i = children.begin (); i != children.end (); ++i)
+    {
+      std::map<Ipv4Address, Time>::const_iterator j = m_lastHelloPiggyback.find (*i);
+      if (j == m_lastHelloPiggyback.end () || Simulator::Now () - j->second >= m_piggybackFreshness)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+RoutingProtocol::AddSourceRoute (Ptr<Packet> packet, Ipv4Header & header, RoutingTableEntryDown const & toDst)
+{
+  if (toDst.GetNextHop () == header.GetDestination ())
+    {
+      return;
+    }
+  // the path is recorded from the destination up, the relays are visited from the sink down
+  SourceRouteHeader sourceRoute (header.GetProtocol ());
+  std::vector<Ipv4Address> const & path = toDst.GetPath ();
+  for (std::vector<Ipv4Address>::const_reverse_iterator i = path.rbegin (); i != path.rend (); ++i)
+    {
+      sourceRoute.AddRelay (*i);
+    }
+  NS_LOG_LOGIC ("Source route to " << header.GetDestination () << ": " << sourceRoute);
+  packet->AddHeader (sourceRoute);
+  TypeHeader tHeader (DMSRPTYPE_SOURCEROUTE);
+  packet->AddHeader (tHeader);
+  header.SetProtocol (DMSRP_DATA_PROT_NUMBER);
+  header.SetPayloadSize (header.GetPayloadSize () + tHeader.GetSerializedSize () + sourceRoute.GetSerializedSize ());
+}
+
+bool
+RoutingProtocol::ForwardSourceRoute (Ptr<const Packet> p, const Ipv4Header & header, int32_t iif,
+                                     UnicastForwardCallback ucb, ErrorCallback ecb)
+{
+  NS_LOG_FUNCTION (this << p->GetUid () << header.GetDestination ());
+  Ptr<Packet> packet = p->Copy ();
+  Ipv4Header ipHeader = header;
+  TypeHeader tHeader (DMSRPTYPE_SOURCEROUTE);
+  packet->RemoveHeader (tHeader);
+  SourceRouteHeader sourceRoute;
+  packet->RemoveHeader (sourceRoute);
+
+  Ipv4Address nextHop;
+  if (sourceRoute.NextRelay (nextHop))
+    {
+      packet->AddHeader (sourceRoute);
+      packet->AddHeader (tHeader);
+    }
+  else
+    {
+      // last relay: the destination is a child, the option must not reach it
+      nextHop = header.GetDestination ();
+      ipHeader.SetProtocol (sourceRoute.GetNextHeader ());
+      ipHeader.SetPayloadSize (ipHeader.GetPayloadSize () - tHeader.GetSerializedSize () - sourceRoute.GetSerializedSize ());
+    }
+
+  if (m_ipv4->IsForwarding (iif) == false)
+    {
+      NS_LOG_LOGIC ("Forwarding disabled for this interface");
+      ecb (packet, ipHeader, Socket::ERROR_NOROUTETOHOST);
+      return true;
+    }
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetDestination (header.GetDestination ());
+  route->SetGateway (nextHop);
+  route->SetSource (m_ipv4->GetAddress (iif, 0).GetLocal ());
+  route->SetOutputDevice (m_ipv4->GetNetDevice (iif));
+  NS_LOG_LOGIC (route->GetSource () << " source-routing to " << header.GetDestination () << " via " << nextHop << " packet " << p->GetUid ());
+  ucb (route, packet, ipHeader);
+  return true;
+}
+
+bool
+RoutingProtocol::ForwardBloom (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb,
+                               Ipv4Address from, uint8_t scope, bool unicast)
+{
+  NS_LOG_FUNCTION (this << p->GetUid () << header.GetDestination ());
+  Ipv4Address dst = header.GetDestination ();
+  Ipv4Address child;
+  Ipv4InterfaceAddress iface;
+  uint32_t matches = m_descendants.Lookup (dst, child, iface, from);
+  m_bloomLookupTrace (dst, matches);
+  if (matches > 0)
+    {
+      Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+      route->SetDestination (dst);
+      route->SetGateway (child);
+      route->SetSource (iface.GetLocal ());
+      route->SetOutputDevice (m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (iface.GetLocal ())));
+      NS_LOG_LOGIC (route->GetSource () << " forwarding to " << dst << " via " << child << " (" << matches << " filters match)");
+      Ptr<Packet> packet = p->Copy ();
+      Ipv4Header ipHeader = header;
+      PiggybackHello (packet, ipHeader, route, iface);
+      ucb (route, packet, ipHeader);
+      return true;
+    }
+
+  if (unicast)
+    {
+      // the filter of the parent pointed here, or the destination left since
+      m_bloomFalsePositiveTrace (dst);
+    }
+  if (scope == 0 || !MarkFlooded (p, header))
+    {
+      NS_LOG_DEBUG ("No descendant filter holds " << dst << ". Drop packet " << p->GetUid ());
+      return false;
+    }
+  NS_LOG_LOGIC ("No descendant filter holds " << dst << ". Broadcast packet " << p->GetUid ());
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      Ipv4InterfaceAddress out = j->second;
+      Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+      route->SetDestination (dst);
+      route->SetGateway (out.GetBroadcast ());
+      route->SetSource (out.GetLocal ());
+      route->SetOutputDevice (m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (out.GetLocal ())));
+      Ptr<Packet> packet = p->Copy ();
+      Ipv4Header ipHeader = header;
+      ScopedFloodHeader flood (header.GetProtocol (), scope - 1, out.GetLocal ());
+      packet->AddHeader (flood);
+      TypeHeader tHeader (DMSRPTYPE_SCOPEDFLOOD);
+      packet->AddHeader (tHeader);
+      ipHeader.SetProtocol (DMSRP_DATA_PROT_NUMBER);
+      ipHeader.SetPayloadSize (header.GetPayloadSize () + tHeader.GetSerializedSize () + flood.GetSerializedSize ());
+      ucb (route, packet, ipHeader);
+    }
+  return true;
+}
+
+bool
+RoutingProtocol::RecvContainer (Ptr<const Packet> p, const Ipv4Header & header, Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+                                MulticastForwardCallback mcb, LocalDeliverCallback lcb, ErrorCallback ecb)
+{
+  NS_LOG_FUNCTION (this << p->GetUid ());
+  std::vector<Aggregator::Item> items;
+  if (!Aggregator::Unpack (p, header.GetTtl (), items))
+    {
+      NS_LOG_DEBUG ("Malformed container " << p->GetUid () << ". Drop");
+      return false;
+    }
+  // the entries were received with the container
+  SnrTag snr;
+  bool hasSnr = p->PeekPacketTag (snr);
+  for (std::vector<Aggregator::Item>::iterator i = items.begin (); i != items.end (); ++i)
+    {
+      if (hasSnr)
+        {
+          i->m_packet->AddPacketTag (snr);
+        }
+      if (!RouteInput (i->m_packet, i->m_header, idev, ucb, mcb, lcb, ecb))
+        {
+          ecb (i->m_packet, i->m_header, Socket::ERROR_NOROUTETOHOST);
+        }
+    }
+  return true;
+}
+
+bool
+RoutingProtocol::RecvScopedFlood (Ptr<const Packet> p, const Ipv4Header & header, int32_t iif,
+                                  UnicastForwardCallback ucb, LocalDeliverCallback lcb)
+{
+  NS_LOG_FUNCTION (this << p->GetUid () << header.GetDestination ());
+  Ptr<Packet> packet = p->Copy ();
+  Ipv4Header ipHeader = header;
+  TypeHeader tHeader (DMSRPTYPE_SCOPEDFLOOD);
+  packet->RemoveHeader (tHeader);
+  ScopedFloodHeader flood;
+  packet->RemoveHeader (flood);
+  ipHeader.SetProtocol (flood.GetNextHeader ());
+  ipHeader.SetPayloadSize (ipHeader.GetPayloadSize () - tHeader.GetSerializedSize () - flood.GetSerializedSize ());
+
+  if (!MarkFlooded (packet, ipHeader))
+    {
+      NS_LOG_DEBUG ("Flooded packet " << p->GetUid () << " already seen. Drop");
+      return true;
+    }
+  if (m_ipv4->IsDestinationAddress (ipHeader.GetDestination (), iif))
+    {
+      if (!lcb.IsNull ())
+        {
+          lcb (packet, ipHeader, iif);
+        }
+      return true;
+    }
+  if (m_downlinkMode != BLOOM)
+    {
+      return true;
+    }
+  ForwardBloom (packet, ipHeader, ucb, flood.GetSender (), flood.GetScope (), false);
+  return true;
+}
+
+bool
+RoutingProtocol::MarkFlooded (Ptr<const Packet> p, const Ipv4Header & header)
+{
+  for (std::map<std::pair<Ipv4Address, uint64_t>, Time>::iterator i = m_floodCache.begin (); i != m_floodCache.end (); )
+    {
+      if (i->second + m_activeRouteTimeout < Simulator::Now ())
+        {
+          m_floodCache.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  return m_floodCache.insert (std::make_pair (std::make_pair (header.GetSource (), p->GetUid ()), Simulator::Now ())).second;
+}
+
+Ptr<Socket>
+RoutingProtocol::FindSocketWithInterfaceAddress (Ipv4InterfaceAddress addr ) const
+{
+  NS_LOG_FUNCTION (this << addr);
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      Ptr<Socket> socket = j->first;
+      Ipv4InterfaceAddress iface = j->second;
+      if (iface == addr)
+        {
+          return socket;
+        }
+    }
+  Ptr<Socket> socket;
+  return socket;
+}
+
+Ptr<Socket>
+RoutingProtocol::FindSubnetBroadcastSocketWithInterfaceAddress (Ipv4InterfaceAddress addr ) const
+{
+  NS_LOG_FUNCTION (this << addr);
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketSubnetBroadcastAddresses.begin (); j != m_socketSubnetBroadcastAddresses.end (); ++j)
+    {
+      Ptr<Socket> socket = j->first;
+      Ipv4InterfaceAddress iface = j->second;
+      if (iface == addr)
+        {
+          return socket;
+        }
+    }
+  Ptr<Socket> socket;
+  return socket;
+}
+
+/// Trace function for handle energy depletion.   //DMS
+void
+RoutingProtocol::EnergyDepletion (void) 
+{
+  //NS_LOG_UNCOND ("Energy depletion WWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWWW   "<<Simulator::Now ());
+}
+void
+RoutingProtocol::DepletionHandler (void)                                            // callback function for energy depletion
+{
+
+m_depTimeTrace();
+  //NS_LOG_UNCOND ("Energy depletion"<<Simulator::Now ());
+  //  NS_LOG_UNCOND ("Energy depletion handler   "<<Simulator::Now ());
+   // DoDispose();                                                                   // if the energy source is drained -> the routing protocol stop functioning
+}
+
+void
+RoutingProtocol::DoInitialize (void)
+{
+
+Ipv4InterfaceAddress iface;
 Ipv4InterfaceAddress iface2;
 
 RngSeedManager::SetRun(1);
@@ -1890,10 +4066,69 @@ double rand; //already declared
 
 Ptr<NetDevice> wifiNetDevice;// DMS
 m_routingTableUp.SetRoutingMode (m_routingMode);
+m_routingTableUp.SetMetricWeights (m_snrWeight, m_energyWeight, m_hopWeight, m_lifetimeWeight);
+m_routingTableUp.SetParentHysteresis (m_parentHysteresis);
+m_nb.SetLinkWindow (m_linkWindow);
+m_channelLoad.SetSmoothing (m_channelLoadSmoothing);
+m_txPower = m_maxTxPower;
+m_routingTableUp.SetLinkLifetimeHorizon (m_activeRouteTimeout);
+m_routingTableUp.SetSinkLoadBalancing (m_sinkLoadBalancing, m_sinkLoadHysteresis);
+m_routingTableUp.SetParentChangeCallback (MakeCallback (&TracedCallback<Ipv4Address, Ipv4Address>::operator(), &m_parentChangeTrace));
+m_routingTableUp.SetBackupParent (m_enableBackupParent);
+m_routingTableUp.SetOutageCallback (MakeCallback (&TracedCallback<Time>::operator(), &m_uplinkOutageTrace));
+m_routingTableServer.SetSinkSelection (m_sinkSelection);
+m_routingTableServer.SetMaxCandidates (m_maxSinkCandidates);
+m_routingTableServer.SetSinkDeadInterval (m_sinkDeadInterval);
+m_descendants.SetFilterSize (m_bloomFilterSize, m_bloomHashCount);
+m_descendants.SetGenerationTime (m_activeRouteTimeout);
+m_sinkQueue.SetCodel (m_sinkAqmTarget, m_sinkAqmInterval);
+m_sinkQueue.SetLimit (m_sinkQueueLimit);
+m_sinkQueue.SetDropCallback (MakeCallback (&RoutingProtocol::NotifySinkQueueDrop, this));
+m_sinkQueueTimer.SetFunction (&RoutingProtocol::SinkQueueSend, this);
+m_forwardedAdvertises.SetRefresh (m_srvAdvertiseRefresh);
+m_forwardedAdvertises.SetSuppressCallback (MakeCallback (&TracedCallback<Ipv4Address, uint32_t>::operator(), &m_srvAdvertiseSuppressedTrace));
+m_aggregator.SetWindow (m_aggregationWindow);
+m_aggregator.SetMaxSize (m_aggregationMaxSize);
+m_aggregator.SetMaxPacketSize (m_aggregationMaxPacketSize);
+m_aggregator.SetProtocol (DMSRP_DATA_PROT_NUMBER);
+m_aggregator.SetSendCallback (MakeCallback (&TracedCallback<uint32_t>::operator(), &m_aggregationTrace));
+m_servers.Clear ();
+m_servers.SetDeadInterval (m_serverDeadInterval);
+if (m_isSink)
+  {
+    m_servers.Add (m_serverAdress);
+    std::string list = m_serverAddresses;
+    std::replace (list.begin (), list.end (), ',', ' ');
+    std::istringstream servers (list);
+    std::string server;
+    while (servers >> server)
+      {
+        m_servers.Add (Ipv4Address (server.c_str ()));
+      }
+    if (m_servers.GetSize () > 1)
+      {
+        m_srvProbeTimer.SetFunction (&RoutingProtocol::SrvProbeTimerExpire, this);
+        m_srvProbeTimer.Schedule (Seconds (m_uniformRandomVariable->GetValue (0, m_serverProbeInterval.GetSeconds ())));
+      }
+  }
+if (m_isSink && m_enableSinkAqm && m_sinkUplinkRate.GetBitRate () == 0 && m_sinkOutPutDevice != 0)
+  {
+    // serve the queue at the speed of the wired link
+    DataRateValue rate;
+    if (m_sinkOutPutDevice->GetAttributeFailSafe ("DataRate", rate))
+      {
+        m_sinkUplinkRate = rate.Get ();
+      }
+  }
 
 if(m_isServer)
 {
   //NS_LOG_UNCOND((m_socketAddresses.begin()->second).GetLocal ()<<" :is SERVER"<<" NBr of Interfces :"<<m_ipv4->GetNInterfaces());
+  if (m_enableTopologyReport && m_routingMode == CENTRALIZED_MODE)
+    {
+      m_topologyTimer.SetFunction (&RoutingProtocol::TopologyTimerExpire, this);
+      m_topologyTimer.Schedule (m_topologyInterval);
+    }
 }
 
 else
@@ -1985,11 +4220,25 @@ if(!m_isServer)
 //  radioEnergyHelper.Set ("CcaBusyCurrentA", DoubleValue (0.0));
 //  radioEnergyHelper.Set ("SleepCurrentA", DoubleValue (0.0));
   radioEnergyHelper.Set ("IdleCurrentA", DoubleValue (0.000426));
+  if (m_enablePowerControl)
+    {
+      // the transmit current falls with the power, from TxCurrentA at MaxTxPower
+      double maxTxPowerW = std::pow (10.0, (m_maxTxPower - 30) / 10);
+      radioEnergyHelper.SetTxCurrentModel ("ns3::LinearWifiTxCurrentModel",
+                                           "Voltage", DoubleValue (3.0),
+                                           "IdleCurrent", DoubleValue (0.000426),
+                                           "Eta", DoubleValue (maxTxPowerW / (3.0 * (0.0147 - 0.000426))));
+    }
   // set energy depletion callback
   WifiRadioEnergyModel::WifiRadioEnergyDepletionCallback callback = MakeCallback (&RoutingProtocol::DepletionHandler, this);  //NS_LOG_UNCOND("step 4");
   radioEnergyHelper.SetDepletionCallback (callback); //NS_LOG_UNCOND("step 5");
   // install on node
   DeviceEnergyModelContainer deviceModels = radioEnergyHelper.Install (wifiNetDevice, energySource);//NS_LOG_UNCOND("step 6");
+  // the control messages read the remaining energy of the last sample
+  m_energyMonitor.SetInterval (m_energySampleInterval);
+  m_energyMonitor.SetSmoothing (m_energyDrainSmoothing);
+  m_energyMonitor.SetEnergySource (energySource);
+  m_energyMonitor.Start ();
 
 
 
@@ -21,6 +21,16 @@
 
 #include "dmsrp-rtable.h"
 #include "dmsrp-packet.h"
+#include "dmsrp-neighbor.h"
+#include "dmsrp-topology.h"
+#include "dmsrp-bloom-filter.h"
+#include "dmsrp-sink-queue.h"
+#include "dmsrp-server-set.h"
+#include "dmsrp-cluster.h"
+#include "dmsrp-aggregator.h"
+#include "dmsrp-channel-load.h"
+#include "dmsrp-energy-monitor.h"
+#include "dmsrp-advertise-filter.h"
 #include "ns3/snr-tag.h"     //DMS
 #include "ns3/node.h"
 #include "ns3/random-variable-stream.h"
@@ -29,7 +39,9 @@
 #include "ns3/ipv4-interface.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/traced-callback.h"
+#include "ns3/data-rate.h"
 #include <map>
+#include <vector>
 
 namespace ns3 {
 namespace dmsrp {
@@ -50,6 +62,70 @@ public:
    */
   static TypeId GetTypeId (void);
   static const uint32_t DMSRP_PORT;
+  static const uint8_t DMSRP_TUNNEL_PROT_NUMBER;
+  static const uint8_t DMSRP_DATA_PROT_NUMBER;
+
+  /**
+   * TracedCallback signature for the lookups of the descendant filters
+   * \param [in] dst the destination of the downlink packet
+   * \param [in] matches the number of children whose filters hold it (0: miss)
+   */
+  typedef void (* BloomLookupTracedCallback)(Ipv4Address dst, uint32_t matches);
+  /**
+   * TracedCallback signature for the downlink packets sent to a node whose subtree
+   * does not hold their destination
+   * \param [in] dst the destination of the packet
+   */
+  typedef void (* BloomFalsePositiveTracedCallback)(Ipv4Address dst);
+  /**
+   * TracedCallback signature for the send events of control packets
+   * \param [in] packets the number of control packets the event sends
+   */
+  typedef void (* ControlTxTracedCallback)(uint32_t packets);
+  /**
+   * TracedCallback signature for the advertises a sink does not forward to the server
+   * \param [in] origin the origin of the advertise
+   * \param [in] seqno its sequence number
+   */
+  typedef void (* SrvAdvertiseSuppressedTracedCallback)(Ipv4Address origin, uint32_t seqno);
+  /**
+   * TracedCallback signature for the packets leaving the uplink queue of a sink
+   * \param [in] sojourn the time the packet spent in the queue
+   */
+  typedef void (* SinkQueueSojournTracedCallback)(Time sojourn);
+  /**
+   * TracedCallback signature for the packets dropped by the uplink queue of a sink
+   * \param [in] origin the origin of the packet
+   * \param [in] sojourn the time the packet spent in the queue
+   */
+  typedef void (* SinkQueueDropTracedCallback)(Ipv4Address origin, Time sojourn);
+  /**
+   * TracedCallback signature for the health changes of the servers of a sink
+   * \param [in] server the server address
+   * \param [in] alive whether the server answers the probes again or stopped answering
+   */
+  typedef void (* ServerStateTracedCallback)(Ipv4Address server, bool alive);
+  /**
+   * TracedCallback signature for the cluster head elections
+   * \param [in] head whether this node became a cluster head or resigned
+   */
+  typedef void (* ClusterRoleTracedCallback)(bool head);
+  /**
+   * TracedCallback signature for the uplink batches
+   * \param [in] count the number of packets sent together
+   */
+  typedef void (* AggregationTracedCallback)(uint32_t count);
+  /**
+   * TracedCallback signature for the parent changes
+   * \param [in] previous the previous parent, 0.0.0.0 at the first one
+   * \param [in] parent the new parent
+   */
+  typedef void (* ParentChangeTracedCallback)(Ipv4Address previous, Ipv4Address parent);
+  /**
+   * TracedCallback signature for the uplink outages
+   * \param [in] outage time without a route to the sink after the parent was lost
+   */
+  typedef void (* UplinkOutageTracedCallback)(Time outage);
 
   /// constructor
   RoutingProtocol ();
@@ -88,6 +164,22 @@ public:
   {
     return m_enableBroadcast;
   }
+  /**
+   * Set the number of consecutive MAC TX failures after which a neighbor is lost
+   * \param n the number of failures
+   */
+  void SetMaxTxFailures (uint16_t n)
+  {
+    m_nb.SetMaxTxFailures (n);
+  }
+  /**
+   * Get the number of consecutive MAC TX failures after which a neighbor is lost
+   * \returns the number of failures
+   */
+  uint16_t GetMaxTxFailures () const
+  {
+    return m_nb.GetMaxTxFailures ();
+  }
 
   void SetIsSink (bool f)     //DMS
   {
@@ -160,8 +252,18 @@ private:
 
   // Protocol parameters.
   Time m_activeRouteTimeout;          ///< Period of time during which the route is considered to be valid.
+  bool m_adaptiveRouteTimeout;         ///< Indicates whether the route timeouts follow the speed of the nodes
+  Time m_minRouteTimeout;              ///< Shortest adaptive route timeout
+  Time m_maxRouteTimeout;              ///< Longest adaptive route timeout
+  double m_routeTimeoutDistance;       ///< Relative move, in meters, after which a route is stale
    
   bool m_enableBroadcast;              ///< Indicates whether a a broadcast data packets forwarding enable
+  bool m_enableLinkLayerFeedback;      ///< Indicates whether MAC TX failures are used to detect broken links
+  bool m_enablePiggyback;              ///< Indicates whether Hello/Advertise records are piggybacked on data packets
+  Time m_piggybackFreshness;           ///< Age under which piggybacked control information suppresses the standalone message
+  bool m_controlTxBatching;            ///< Indicates whether the control packets of a round share one send event
+  bool m_enableTopologyReport;         ///< Indicates whether the advertises carry the parents of their origin to the server
+  Time m_topologyInterval;             ///< Period of the parent computation at the server
   bool m_isSink; //DMS Has outside access? : should be initialized via the application
   bool m_isServer; //DMS this Node is a server? : should be initialized via the application
   Ipv4Address m_serverAdress; //DMS Serveradresse : should be initialized via the application
@@ -191,6 +293,9 @@ private:
   RoutingMode m_routingMode; //DMS
   TracedCallback < > m_depTimeTrace; //DMS
   uint32_t m_rngRep; //DMS
+  uint16_t m_rerrRateLimit;             ///< Maximum number of RERR per second.
+  /// Number of RERRs used for RERR rate control
+  uint16_t m_rerrCount;
 
 
 
@@ -214,9 +319,12 @@ private:
    * \param header the IP header
    * \param ucb the UnicastForwardCallback function
    * \param ecb the ErrorCallback function
+   * \param PcktFromServer true if the packet came from the server through the sink output device
+   * \param carried the piggyback option removed from the packet by this node, if any
    * \returns true if forwarded
    */ 
-  bool Forwarding (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb, ErrorCallback ecb, bool PcktFromServer);
+  bool Forwarding (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb, ErrorCallback ecb, bool PcktFromServer,
+                   PiggybackHeader const & carried = PiggybackHeader ());
 
 
 
@@ -260,6 +368,267 @@ private:
   void RecvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);//DMS
   /// Receive SRVADVERTISE
   void RecvSrvAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);//DMS
+  /// Receive RERR from node with address src
+  void RecvRerr (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  /**
+   * Remove the piggyback option of a data packet and process the records it carries
+   * \param p the data packet, starting with the option
+   * \param header the IP header, restored to the original protocol and payload size
+   * \param receiver the address of the interface the packet came on
+   * \param piggyback the removed option, still holding the advertise record to carry further up
+   * \returns false if the option is malformed
+   */
+  bool RecvPiggyback (Ptr<Packet> p, Ipv4Header & header, Ipv4Address receiver, PiggybackHeader & piggyback);
+  /// Keep the route to one sink described by a Hello record of neighbor src
+  void ProcessSinkRecord (HelloHeader record, Ipv4Address receiver, Ipv4Address src);
+  /// Update the routes up with a Hello (received or piggybacked) from neighbor src
+  void ProcessHello (HelloHeader helloHeader, Ipv4Address receiver, Ipv4Address src);
+  /**
+   * Check whether a Hello may give a parent with more hops for a lower path metric: it must be
+   * about the sink of the current route, not older than it, and not come from a child of this node
+   * \param helloHeader the Hello
+   * \param current the current best route up
+   * \param src the neighbor which sent the Hello
+   * \returns true if the path metric of the Hello can be trusted
+   */
+  bool IsUpstreamHello (HelloHeader const & helloHeader, RoutingTableEntryUp const & current, Ipv4Address src);
+  /**
+   * Update the routes down with an advertise (received or piggybacked) from neighbor src
+   * \returns true if the advertise is new and must be propagated up
+   */
+  bool ProcessAdvertise (AdvertiseHeader & advertiseHeader, Ipv4Address receiver, Ipv4Address src);
+  /// Propagate an advertise up: to the parent, or to the server if this node is a sink
+  void PropagateAdvertise (AdvertiseHeader advertiseHeader);
+  /// Receive PARENTASSIGN
+  void RecvParentAssign (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  /**
+   * Apply the assignments of this node and send the others down, one PARENTASSIGN per next hop
+   * (per sink at the server)
+   * \param assignments node -> assigned parent
+   * \param lifetime how long the assignments are valid
+   */
+  void DispatchParentAssign (std::map<Ipv4Address, Ipv4Address> const & assignments, Time lifetime);
+  /// Elect this node cluster head, or not, from its cluster score and the ones of its neighbors
+  void UpdateClusterRole ();
+  /**
+   * \param origin the origin of an advertise
+   * \returns true if this node is the cluster head of origin and keeps its advertises
+   */
+  bool AbsorbsAdvertise (Ipv4Address origin);
+  /// Send the summary of the cluster of this node up
+  void SendClusterAdvertise ();
+  /// Receive CLUSTERADVERTISE
+  void RecvClusterAdvertise (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  /// Forward a CLUSTERADVERTISE to the parent, or to the servers (sink)
+  void ForwardClusterAdvertise (ClusterAdvertiseHeader clusterHeader);
+  /**
+   * Lookup a down route, in the cluster summaries if the destination has none of its own
+   * \param dst the destination
+   * \param rt the route found
+   * \returns true on success
+   */
+  bool LookupDownRoute (Ipv4Address dst, RoutingTableEntryDown & rt);
+  /**
+   * Lookup the route of the server to a destination, in the cluster summaries if it has none of its own
+   * \param dst the destination
+   * \param rt the route found
+   * \returns true on success
+   */
+  bool LookupServerRoute (Ipv4Address dst, RoutingTableEntryDown & rt);
+  /**
+   * Add the link estimation data to a Hello (ETX mode)
+   * \param helloHeader the Hello
+   * \param pathEtx the ETX of the best route of this node
+   */
+  void AddLinkQuality (HelloHeader & helloHeader, float pathEtx);
+  /**
+   * Airtime of a test frame sent to a neighbor, from the rate and the frame
+   * error rate the WiFi station manager holds for it (airtime mode)
+   * \param neighbor the neighbor
+   * \param receiver the address of the interface the neighbor is reached on
+   * \returns the airtime, in microseconds
+   */
+  double GetLinkAirtime (Ipv4Address neighbor, Ipv4Address receiver);
+  /**
+   * Add the channel load of this node to a Hello (channel load mode)
+   * \param helloHeader the Hello
+   */
+  void AddChannelLoad (HelloHeader & helloHeader);
+  /**
+   * Add the position and velocity of this node to a Hello (link lifetime mode)
+   * \param helloHeader the Hello
+   */
+  void AddMobility (HelloHeader & helloHeader);
+  /**
+   * Predict the time before the link to a neighbor breaks
+   * \param neighbor the neighbor
+   * \returns the time, the maximum simulation time if the motion of either end is unknown
+   */
+  Time GetLinkLifetime (Ipv4Address neighbor);
+  /**
+   * Time a route through a neighbor stays valid: ActiveRouteTimeout, or the
+   * time the neighbor takes to move RouteTimeoutDistance away if the timeouts are adaptive
+   * \param neighbor the neighbor
+   * \returns the timeout
+   */
+  Time GetRouteTimeout (Ipv4Address neighbor);
+  /**
+   * Compute the transmit power of the unicast frames: the lowest one that reaches
+   * the parent and the children with TargetSnr plus PowerMargin (power control)
+   */
+  void UpdateTxPower ();
+  /**
+   * Set the power of a frame the wifi PHY starts to send: MaxTxPower for the
+   * broadcasts, so that every neighbor keeps hearing the Hellos, and the power
+   * of the next hops for the unicast frames (power control)
+   * \param packet the frame, with its MAC header
+   */
+  void SetFrameTxPower (Ptr<const Packet> packet, double);
+  /**
+   * Set the transmit power of the wifi devices of this node
+   * \param txPower the power, in dBm
+   */
+  void SetPhyTxPower (double txPower);
+  /**
+   * Add the transmit power of the Hellos of this node to a Hello (power control)
+   * \param helloHeader the Hello
+   */
+  void AddTxPower (HelloHeader & helloHeader);
+  /**
+   * Add the predicted lifetime of the best route of this node to a Hello (path lifetime mode)
+   * \param helloHeader the Hello
+   * \param pathLifetime the path lifetime of the best route, this node excluded, in seconds
+   */
+  void AddPathLifetime (HelloHeader & helloHeader, float pathLifetime);
+  /**
+   * Add the load of the sink of a Hello: this one's own if it is a sink, the
+   * last one the sink advertised otherwise (sink load balancing)
+   * \param helloHeader the Hello
+   */
+  void AddSinkLoad (HelloHeader & helloHeader);
+  /// Take the utilisation of the uplink of this sink since the previous sample (sink load balancing)
+  void SampleSinkUplink ();
+  /// Receive SRVPROBE (server)
+  void RecvSrvProbe (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  /// Receive SRVPROBE_REPLY (sink)
+  void RecvSrvProbeReply (Ptr<Packet> p, Ipv4Address receiver, Ipv4Address src);
+  /// A server of this sink died or came back
+  void NotifyServerChange (Ipv4Address server, bool alive);
+  /// \returns the socket of the sink output device, if any
+  Ptr<Socket> GetSinkOutputSocket () const;
+  /**
+   * The servers a sink sends the advertise of a node to
+   * \param origin the node
+   * \param servers the selected servers
+   */
+  void GetAdvertiseServers (Ipv4Address origin, std::vector<Ipv4Address> & servers) const;
+  /**
+   * The key a sink maps a tunnelled packet on a server with
+   * \param p the packet, without its IP header
+   * \param header the IP header of the packet
+   * \returns the flow hash (replicate) or the destination (partition)
+   */
+  uint32_t FlowKey (Ptr<const Packet> p, Ipv4Header const & header) const;
+  /**
+   * \param route the route to the primary server
+   * \param server another server on the segment of the sink output device
+   * \returns a copy of route through server
+   */
+  Ptr<Ipv4Route> RouteToServer (Ptr<Ipv4Route> route, Ipv4Address server) const;
+  /// \returns the tunnelled packets per second this server received lately
+  uint32_t GetServerLoad ();
+  /// Send a PARENTASSIGN to next hop nextHop through interface iface
+  void SendParentAssign (ParentAssignHeader const & parentAssignHeader, Ipv4InterfaceAddress iface, Ipv4Address nextHop);
+  /// \returns the residual energy and the parents of this node, for the server
+  TopologyReport MakeTopologyReport ();
+  /**
+   * Build the Hello this node advertises on interface iface
+   * \returns false if a simple node has no route up yet
+   */
+  bool MakeHelloHeader (Ipv4InterfaceAddress iface, HelloHeader & helloHeader);
+  /**
+   * Piggyback an advertise record on a data packet going up: the record removed from the packet
+   * by this node, or the record of this node if it is the origin and its last advertise is getting old
+   * \param packet the data packet
+   * \param header its IP header, updated if the option is added
+   * \param route the route up
+   * \param carried the option removed from the packet by this node
+   */
+  void PiggybackAdvertise (Ptr<Packet> packet, Ipv4Header & header, Ptr<Ipv4Route> route, PiggybackHeader const & carried);
+  /**
+   * Piggyback the Hello of this node on a data packet going down to a child which did not get it lately
+   * \param packet the data packet
+   * \param header its IP header, updated if the option is added
+   * \param route the route down
+   * \param iface the interface of the route down
+   */
+  void PiggybackHello (Ptr<Packet> packet, Ipv4Header & header, Ptr<Ipv4Route> route, Ipv4InterfaceAddress iface);
+  /// Add the piggyback option to a data packet and fix its IP header
+  void AddPiggyback (Ptr<Packet> packet, Ipv4Header & header, PiggybackHeader & piggyback);
+  /// \returns true if every child got the Hello of this node piggybacked lately
+  bool ChildrenHaveFreshHello ();
+  /**
+   * Add the source route option to a data packet a sink sends down (non-storing mode),
+   * unless its destination is a child of the sink
+   * \param packet the data packet
+   * \param header its IP header, updated if the option is added
+   * \param toDst the down route, holding the path to the destination
+   */
+  void AddSourceRoute (Ptr<Packet> packet, Ipv4Header & header, RoutingTableEntryDown const & toDst);
+  /**
+   * Forward a source-routed packet to the next relay of its route, or to its destination
+   * after removing the option if this node is the last relay. No routing table is used.
+   * \param p the data packet, starting with the option
+   * \param header its IP header
+   * \param iif the interface the packet came on, the one it leaves through
+   * \param ucb the unicast forward callback
+   * \param ecb the error callback
+   * \returns true if the packet was handled
+   */
+  bool ForwardSourceRoute (Ptr<const Packet> p, const Ipv4Header & header, int32_t iif,
+                           UnicastForwardCallback ucb, ErrorCallback ecb);
+  /**
+   * Send a downlink packet to the child whose descendant filter holds its destination,
+   * or broadcast it with the scoped flood option on a miss (Bloom mode)
+   * \param p the data packet, without DMSRP option
+   * \param header its IP header
+   * \param ucb the unicast forward callback
+   * \param from the node that broadcast the packet to this node, not to be sent back to
+   * \param scope the broadcasts this node may still do
+   * \param unicast true if the packet was sent to this node by its parent, not broadcast
+   * \returns true if the packet was sent
+   */
+  bool ForwardBloom (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb,
+                     Ipv4Address from, uint8_t scope, bool unicast);
+  /**
+   * Receive a downlink packet broadcast with the scoped flood option (Bloom mode)
+   * \param p the data packet, starting with the option
+   * \param header its IP header
+   * \param iif the interface the packet came on
+   * \param ucb the unicast forward callback
+   * \param lcb the local delivery callback
+   * \returns true if the packet was handled
+   */
+  bool RecvScopedFlood (Ptr<const Packet> p, const Ipv4Header & header, int32_t iif,
+                        UnicastForwardCallback ucb, LocalDeliverCallback lcb);
+  /**
+   * Take the packets out of a container and route them one by one
+   * \param p the container, starting with the DMSRP type
+   * \param header the IP header of the container
+   * \param idev the device the container came on
+   * \param ucb the unicast forward callback
+   * \param mcb the multicast forward callback
+   * \param lcb the local delivery callback
+   * \param ecb the error callback
+   * \returns false if the container is malformed
+   */
+  bool RecvContainer (Ptr<const Packet> p, const Ipv4Header & header, Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+                      MulticastForwardCallback mcb, LocalDeliverCallback lcb, ErrorCallback ecb);
+  /**
+   * Remember that a downlink packet was flooded or received flooded
+   * \returns false if it already was
+   */
+  bool MarkFlooded (Ptr<const Packet> p, const Ipv4Header & header);
 
 
   void SendHello2 (); //DMS
@@ -271,14 +640,55 @@ private:
   void ForwardAdvertise(AdvertiseHeader advertiseHeader); //DMS
   void ForwardSrvAdvertise(SrvAdvertiseHeader srvadvertiseHeader); //DMS   forward advertise packet received by the sink to the server
 
+  /**
+   * Send RERR message when no route to forward a downlink packet
+   * \param dst - destination node IP address
+   */
+  void SendRerrWhenNoRouteToForward (Ipv4Address dst);
+  /**
+   * Remove the routes through a lost neighbor and report the down routes that broke
+   * \param nextHop the lost neighbor
+   */
+  void SendRerrWhenBreaksLinkToNextHop (Ipv4Address nextHop);
+  /**
+   * Send RERR message up the tree: to the best parent, or to the server if this node is a sink
+   * \param rerrHeader the RERR header listing the unreachable destinations
+   */
+  void SendRerrMessage (RerrHeader rerrHeader);
+
 
   /**
    * Send packet to desitnation scoket
    * \param socket - destination node socket
    * \param packet - packet to send
    * \param destination - destination node IP address
+   * \return false if the socket was closed meanwhile
    */
-  void SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination);
+  bool SendTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination);
+  /**
+   * Send a control packet after a random jitter. With ControlTxBatching, the packets
+   * queued before the jitter expires go out together from the same event.
+   * \param socket - destination node socket
+   * \param packet - packet to send
+   * \param destination - destination node IP address
+   */
+  void ScheduleTo (Ptr<Socket> socket, Ptr<Packet> packet, Ipv4Address destination);
+  /// Send all the queued control packets
+  void FlushTxQueue ();
+
+  /// Control packet waiting for the next send event
+  struct QueuedControlPacket
+  {
+    Ptr<Socket> socket;          ///< socket to send from
+    Ptr<Packet> packet;          ///< the packet
+    Ipv4Address destination;     ///< destination address
+  };
+  /// Control packets waiting for m_txEvent
+  std::vector<QueuedControlPacket> m_txQueue;
+  /// Send event of the queued control packets
+  EventId m_txEvent;
+  /// Send events of control packets, with the number of packets each one sends
+  TracedCallback<uint32_t> m_controlTxTrace;
 
   /// Hello timer
   Timer m_hellotimer; //DMS
@@ -289,6 +699,32 @@ private:
   void HelloTimerExpire2 ();//DMS
   /// Schedule next send of hello message
   void AdvertiseTimerExpire ();//DMS
+  /// Time of the last advertise of this node (standalone or piggybacked)
+  Time m_lastAdvertise;
+  /// Indicates whether the last advertise of this node was piggybacked
+  bool m_advertisePiggybacked;
+  /// Time of the last Hello piggybacked to each child
+  std::map<Ipv4Address, Time> m_lastHelloPiggyback;
+  /// Indicates whether the last Hello round was suppressed
+  bool m_helloSuppressed;
+  /// RERR rate limit timer
+  Timer m_rerrRateLimitTimer;
+  /// Reset RERR count and schedule RERR rate limit timer with delay 1 sec.
+  void RerrRateLimitTimerExpire ();
+  /// Parent computation timer (server)
+  Timer m_topologyTimer;
+  /// Compute the parents from the topology database and push them down
+  void TopologyTimerExpire ();
+  /// Uplink pacing timer (sink)
+  Timer m_sinkQueueTimer;
+  /// Send the next packet of the uplink queue and wait for its transmission time
+  void SinkQueueSend ();
+  /// Report a packet dropped by the uplink queue
+  void NotifySinkQueueDrop (Ipv4Address origin, Time sojourn);
+  /// Server probe timer (sink with several servers)
+  Timer m_srvProbeTimer;
+  /// Update the health of the servers and probe them again
+  void SrvProbeTimerExpire ();
 
 
 
@@ -303,15 +739,107 @@ private:
   /// Provides uniform random variables.
   Ptr<UniformRandomVariable> m_uniformRandomVariable;
 
+  /// Handle neighbors and layer 2 link failures
+  Neighbors m_nb;
+
   /// Routing table                  //DMS
   RoutingTableUp m_routingTableUp;       //DMS
   RoutingTableDown m_routingTableDown;       //DMS  
+  RoutingTableServer m_routingTableServer;   ///< Candidate sinks per destination, used by the server only
+  TopologyDatabase m_topology;               ///< Topology reported by the nodes, used by the server only
   uint32_t m_maxHelloHops; //DMS 
   uint32_t m_maxAdvertiseHops; //DMS 
+  uint32_t m_maxHelloSinks;             ///< Maximum number of sinks described in a Hello
+  SinkSelection m_sinkSelection;        ///< How the server selects the sink of a downlink packet
+  uint32_t m_maxSinkCandidates;         ///< Maximum number of candidate sinks per destination at the server
+  Time m_sinkDeadInterval;              ///< Time without SrvAdvertise after which the server considers a sink dead
+  DownlinkMode m_downlinkMode;          ///< Whether the relays keep down routes, follow source routes or use Bloom filters
+  DescendantFilters m_descendants;      ///< Descendants of each child, used by the relays in Bloom mode
+  uint32_t m_bloomFilterSize;           ///< Cells of a descendant filter
+  uint32_t m_bloomHashCount;            ///< Cells set by an address in a descendant filter
+  uint8_t m_bloomBroadcastScope;        ///< Broadcast hops of a downlink packet missed by the filters
+  /// Flooded downlink packets: (IP source, packet uid) -> time seen
+  std::map<std::pair<Ipv4Address, uint64_t>, Time> m_floodCache;
+  /// Lookups of the descendant filters
+  TracedCallback<Ipv4Address, uint32_t> m_bloomLookupTrace;
+  /// Downlink packets that reached a node whose subtree does not hold their destination
+  TracedCallback<Ipv4Address> m_bloomFalsePositiveTrace;
+  AdvertiseFilter m_forwardedAdvertises;  ///< Advertises forwarded by this sink to the server
+  Time m_srvAdvertiseRefresh;           ///< Period after which a sink forwards an unchanged advertise again
+  /// Advertises a sink did not forward to the server
+  TracedCallback<Ipv4Address, uint32_t> m_srvAdvertiseSuppressedTrace;
+  bool m_enableSinkAqm;                 ///< Whether a sink queues the tunnelled packets itself
+  DataRate m_sinkUplinkRate;            ///< Rate the sink queue is served at (0: the DataRate of the output device)
+  Time m_sinkAqmTarget;                 ///< CoDel target of the sink queue
+  Time m_sinkAqmInterval;               ///< CoDel interval of the sink queue
+  uint32_t m_sinkQueueLimit;            ///< Maximum number of packets in the sink queue
+  SinkQueue m_sinkQueue;                ///< Tunnelled packets waiting for the uplink, per origin
+  /// Time the packets spent in the sink queue
+  TracedCallback<Time> m_sinkQueueSojournTrace;
+  /// Packets dropped by the sink queue
+  TracedCallback<Ipv4Address, Time> m_sinkQueueDropTrace;
+  std::string m_serverAddresses;        ///< Servers of a sink beside ServerAddress, separated by spaces or commas
+  Time m_serverProbeInterval;           ///< Period of the server probes of a sink
+  Time m_serverDeadInterval;            ///< Time without probe reply after which a server is dead
+  ServerDistribution m_serverDistribution; ///< Whether the advertises are replicated on or partitioned among the servers
+  uint32_t m_serverCapacity;            ///< Tunnelled packets per second above which a server says it is overloaded (0: never)
+  ServerSet m_servers;                  ///< Servers of this sink, with their health
+  uint32_t m_srvProbeSeqNo;             ///< Sequence number of the next server probe
+  uint32_t m_srvLoadCount;              ///< Tunnelled packets received by this server since m_srvLoadStart
+  uint32_t m_srvLoad;                   ///< Tunnelled packets per second received by this server lately
+  Time m_srvLoadStart;                  ///< Start of the current load measurement
+  /// Servers which died or came back
+  TracedCallback<Ipv4Address, bool> m_serverStateTrace;
+  bool m_enableClusters;                ///< Indicates whether the nodes elect cluster heads
+  double m_clusterHysteresis;           ///< Relative score margin of the cluster head elections
+  double m_clusterMinEnergy;            ///< Residual energy fraction under which a cluster head resigns
+  uint32_t m_clusterFilterSize;         ///< Number of cells of the members filter of a cluster head
+  bool m_isClusterHead;                 ///< This node is a cluster head
+  float m_clusterScore;                 ///< Cluster score of this node
+  uint32_t m_clusterSeqNo;              ///< Sequence number of the next cluster summary
+  ClusterTable m_clusterTable;          ///< Clusters below this node (the server: all of them)
+  /// Cluster head elections and resignations of this node
+  TracedCallback<bool> m_clusterRoleTrace;
+  bool m_enableAggregation;             ///< Indicates whether small uplink packets are sent in containers
+  Time m_aggregationWindow;             ///< Holding time of the first packet of a container
+  uint32_t m_aggregationMaxSize;        ///< Maximum size of a container
+  uint32_t m_aggregationMaxPacketSize;  ///< Largest packet put in a container
+  Aggregator m_aggregator;              ///< Uplink packets waiting for their container
+  /// Number of packets of each container sent
+  TracedCallback<uint32_t> m_aggregationTrace;
+  uint16_t m_linkWindow;                ///< Number of last Hellos the link reception ratios are computed on
+  uint16_t m_helloCounter;              ///< Counter of the broadcast Hellos of this node
+  Time m_airtimeOverhead;               ///< Channel access and protocol overhead of a frame (airtime mode)
+  uint32_t m_airtimeTestFrameSize;      ///< Size of the test frame the link airtime is computed for, in bytes
+  ChannelLoad m_channelLoad;            ///< Busy fraction of the channel around this node
+  double m_channelLoadSmoothing;        ///< Weight of a new busy fraction sample in the channel load
+  double m_transmissionRange;           ///< Range assumed to predict the link lifetimes, in meters
+  bool m_enableBackupParent;            ///< Indicates whether a backup parent replaces a lost parent at once
+  bool m_enablePowerControl;            ///< Indicates whether the transmit power follows the SNR margin of the links
+  double m_minTxPower;                  ///< Lowest transmit power, in dBm (power control)
+  double m_maxTxPower;                  ///< Highest transmit power, in dBm (power control)
+  double m_targetSnr;                   ///< SNR the next hops should receive the frames with, in dB (power control)
+  double m_powerMargin;                 ///< Margin added to the target SNR against fading and motion, in dB (power control)
+  double m_txPower;                     ///< Transmit power of the unicast frames of this node, in dBm (power control)
+  EnergyMonitor m_energyMonitor;        ///< Remaining energy and drain rate of this node
+  Time m_energySampleInterval;          ///< Time between two readings of the energy source
+  double m_energyDrainSmoothing;        ///< Weight of a new reading in the drain rate
+  bool m_sinkLoadBalancing;             ///< Indicates whether the nodes prefer the least loaded sink
+  double m_sinkLoadHysteresis;          ///< Margin another sink must have over the current one
+  uint64_t m_sinkUplinkBytes;           ///< Bytes this sink sent to the server since the last sample
+  Time m_sinkUplinkSample;              ///< Time of the last uplink sample
+  uint8_t m_sinkUplinkLoad;             ///< Utilisation of the uplink of this sink, in 255ths
   Time m_helloTimerExpire; //DMS 
   Time m_advertiseTimerExpire; //DMS
   double m_snrWeight; //DMS
   double m_energyWeight; //DMS
+  double m_hopWeight;                   ///< Weight of the hop count in the composite metric
+  double m_lifetimeWeight;              ///< Weight of the route lifetime in the composite metric
+  double m_parentHysteresis;            ///< Margin a parent candidate must have in the composite mode
+  /// Parent changes of this node: previous parent, new parent
+  TracedCallback<Ipv4Address, Ipv4Address> m_parentChangeTrace;
+  /// Time without a route to the sink after each parent loss
+  TracedCallback<Time> m_uplinkOutageTrace;
 };
 
 } //namespace dmsrp
@@ -29,6 +29,8 @@
 #include "dmsrp-rtable.h"
 #include <algorithm>
 #include <iomanip>
+#include <cmath>
+#include <limits>
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 
@@ -38,6 +40,8 @@ NS_LOG_COMPONENT_DEFINE ("DmsrpRoutingTable");
 
 namespace dmsrp {
 
+/// Channel load beyond which a parent costs the same, so that a saturated one keeps a finite cost
+static const float MAX_CHANNEL_LOAD = 0.99f;
 
 // DMS  RoutingTableEntryUp  //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 RoutingTableEntryUp::RoutingTableEntryUp (Ptr<NetDevice> dev, Ipv4Address dst,uint32_t seqNo,
@@ -48,6 +52,11 @@ RoutingTableEntryUp::RoutingTableEntryUp (Ptr<NetDevice> dev, Ipv4Address dst,ui
     m_lifeTime (lifetime + Simulator::Now ()),
     m_cumEnergy (cumEnergy),
     m_minSnr (minSnr),
+    m_pathEtx (0),
+    m_pathAirtime (0),
+    m_channelLoad (0),
+    m_linkBreak (Simulator::GetMaximumSimulationTime ()),
+    m_pathLifetime (0),
     m_iface (iface)
 {
   m_ipv4Route = Create<Ipv4Route> ();
@@ -142,6 +151,20 @@ RoutingTableEntryDown::PrintInScreen () const
 //   RoutingTableUp DMS ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 RoutingTableUp::RoutingTableUp ()
+  : m_snrWeight (0.4),
+    m_energyWeight (0.3),
+    m_hopWeight (0.2),
+    m_lifetimeWeight (0.1),
+    m_parentHysteresis (0.1),
+    m_linkLifetimeHorizon (Seconds (6)),
+    m_enableBackup (false),
+    m_hasBackup (false),
+    m_promoted (false),
+    m_parentLost (false),
+    m_outage (false),
+    m_sinkLoadBalancing (false),
+    m_sinkLoadHysteresis (0.2),
+    m_subtreeSize (1)
 {
 
 }
@@ -204,90 +227,396 @@ bool
 RoutingTableUp::LookupBestRoute (RoutingTableEntryUp & rt)   // DMS //All entries have the same number of hps in routingtableup, 
 {
   NS_LOG_FUNCTION (this);
-double maxCumEnergyValue=-1.0;
-double maxMinSnrValue=-1.0;
-Ipv4Address BestParentRoutAddress;
-//uint16_t minHops=10000;
-Time minLifetime=Seconds(100);
   Purge ();
-  if (m_ipv4AddressEntry.empty ())
+  std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator promoted = m_ipv4AddressEntry.find (m_promotedParent);
+  if (m_promoted && promoted != m_ipv4AddressEntry.end ())
+    {
+      rt = promoted->second;
+    }
+  else
+    {
+      Ipv4Address sink;
+      std::map<Ipv4Address, RoutingTableEntryUp> toSink;
+      if (m_sinkLoadBalancing && SelectSink (sink))
+        {
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+            {
+              if (i->second.GetDestination () == sink)
+                {
+                  toSink.insert (*i);
+                }
+            }
+          // the routes of the other sinks if none of the best routes goes there
+          std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::const_iterator j = m_sinkEntries.find (sink);
+          if (toSink.empty () && j != m_sinkEntries.end ())
+            {
+              toSink = LoopFreeCandidates (j->second);
+            }
+        }
+      if (!SelectBestRoute (toSink.empty () ? m_ipv4AddressEntry : toSink, rt))
+        {
+          return false;
+        }
+    }
+  m_currentSink = rt.GetDestination ();
+  if (rt.GetNextHop () != m_currentParent)
+    {
+      Ipv4Address previous = m_currentParent;
+      m_currentParent = rt.GetNextHop ();
+      if (!m_parentChangeCallback.IsNull ())
+        {
+          m_parentChangeCallback (previous, m_currentParent);
+        }
+    }
+  return true;
+}
+
+bool
+RoutingTableUp::SelectBestRoute (std::map<Ipv4Address, RoutingTableEntryUp> const & table, RoutingTableEntryUp & rt) const
+{
+  if (table.empty ())
     {
       return false;
     }
+  std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator best = table.begin ();
 
   switch (m_routingMode)
     {
     case BASIC_MODE:
       {
-          rt = m_ipv4AddressEntry.begin ()->second;
-          return true;
           break;
       }
     case MULTI_PARENT_MODE:
       {
-         BestParentRoutAddress = m_ipv4AddressEntry.begin ()->second.GetNextHop ();
-         minLifetime=m_ipv4AddressEntry.begin ()->second.GetLifeTime ();
-          for (std::map<Ipv4Address, RoutingTableEntryUp>::iterator i =
-                 m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
             {
-                      if (i->second.GetLifeTime() > minLifetime)
+                      if (i->second.GetLifeTime () > best->second.GetLifeTime ())
                         {
-                             minLifetime=Seconds(i->second.GetLifeTime()) ;
-                             BestParentRoutAddress=i->second.GetNextHop ();
+                             best = i;
                         }
-               ++i;
             }
-
-          std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = m_ipv4AddressEntry.find (BestParentRoutAddress);
-          rt = i->second;
-          return true;
           break;
       }
     case ENERGY_AWARE_MULTI_PARENT_MODE:
       {
-          for (std::map<Ipv4Address, RoutingTableEntryUp>::iterator i =
-                 m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
             {
-
-                      if (i->second.GetCumEnergy() > maxCumEnergyValue)
+                      if (i->second.GetCumEnergy () > best->second.GetCumEnergy ())
                         {
-                             maxCumEnergyValue=i->second.GetCumEnergy() ;
-                             BestParentRoutAddress=i->second.GetNextHop ();
+                             best = i;
                         }
-               ++i;
             }
-
-          std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = m_ipv4AddressEntry.find (BestParentRoutAddress);
-          rt = i->second;
-          return true;
           break;
       }
     case SNR_AWARE_MULTI_PARENT_MODE:
       {
-
-          for (std::map<Ipv4Address, RoutingTableEntryUp>::iterator i =
-                 m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
             {
-
-                      if (i->second.GetMinSnr () > maxMinSnrValue)
+                      if (i->second.GetMinSnr () > best->second.GetMinSnr ())
                         {
-                             maxMinSnrValue=i->second.GetMinSnr() ;
-                             BestParentRoutAddress=i->second.GetNextHop ();
+                             best = i;
                         }
-
-               ++i;
             }
-
-          std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = m_ipv4AddressEntry.find (BestParentRoutAddress);
-          rt = i->second;
-          return true;
           break;
-        break;
-      }    
+      }
+    case CENTRALIZED_MODE:
+      {
+          // the parent assigned by the server, while it is valid and still a neighbor
+          std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator assigned = table.find (m_assignedParent);
+          if (Simulator::Now () < m_assignedParentExpiry && assigned != table.end ())
+            {
+              best = assigned;
+              break;
+            }
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+                      if (i->second.GetMinSnr () > best->second.GetMinSnr ())
+                        {
+                             best = i;
+                        }
+            }
+          break;
+      }
+    case COMPOSITE_MODE:
+      {
+          double maxSnr = 0;
+          double maxEnergy = 0;
+          double maxLifetime = 0;
+          uint16_t minHops = std::numeric_limits<uint16_t>::max ();
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+              maxSnr = std::max (maxSnr, (double) i->second.GetMinSnr ());
+              maxEnergy = std::max (maxEnergy, (double) i->second.GetCumEnergy ());
+              maxLifetime = std::max (maxLifetime, i->second.GetLifeTime ().GetSeconds ());
+              minHops = std::min (minHops, std::max (i->second.GetHop (), (uint16_t) 1));
+            }
+          double bestScore = -1;
+          double currentScore = -1;
+          std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator current = table.end ();
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+              double score = m_hopWeight * minHops / std::max (i->second.GetHop (), (uint16_t) 1);
+              if (maxSnr > 0)
+                {
+                  score += m_snrWeight * i->second.GetMinSnr () / maxSnr;
+                }
+              if (maxEnergy > 0)
+                {
+                  score += m_energyWeight * i->second.GetCumEnergy () / maxEnergy;
+                }
+              if (maxLifetime > 0)
+                {
+                  score += m_lifetimeWeight * i->second.GetLifeTime ().GetSeconds () / maxLifetime;
+                }
+              if (score > bestScore)
+                {
+                  bestScore = score;
+                  best = i;
+                }
+              if (i->second.GetNextHop () == m_currentParent)
+                {
+                  currentScore = score;
+                  current = i;
+                }
+            }
+          // the current parent is only replaced by a clearly better one
+          if (current != table.end () && bestScore <= currentScore * (1 + m_parentHysteresis))
+            {
+              best = current;
+            }
+          break;
+      }
+    case ETX_MODE:
+      {
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+                      if (i->second.GetPathEtx () < best->second.GetPathEtx ())
+                        {
+                             best = i;
+                        }
+            }
+          break;
+      }
+    case AIRTIME_MODE:
+      {
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+                      if (i->second.GetPathAirtime () < best->second.GetPathAirtime ())
+                        {
+                             best = i;
+                        }
+            }
+          break;
+      }
+    case CHANNEL_LOAD_MODE:
+      {
+          // a parent free of the channel a fraction (1 - load) of the time delays each frame by 1 / (1 - load)
+          double bestCost = std::numeric_limits<double>::max ();
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+              double cost = i->second.GetHop () / (1 - std::min (i->second.GetChannelLoad (), MAX_CHANNEL_LOAD));
+              if (cost < bestCost)
+                {
+                  bestCost = cost;
+                  best = i;
+                }
+            }
+          break;
+      }
+    case LINK_LIFETIME_MODE:
+      {
+          // links lasting beyond the horizon are equally good, the SNR decides between them
+          Time bestLifetime = std::min (best->second.GetLinkLifetime (), m_linkLifetimeHorizon);
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+              Time lifetime = std::min (i->second.GetLinkLifetime (), m_linkLifetimeHorizon);
+              if (lifetime > bestLifetime
+                  || (lifetime == bestLifetime && i->second.GetMinSnr () > best->second.GetMinSnr ()))
+                {
+                  bestLifetime = lifetime;
+                  best = i;
+                }
+            }
+          break;
+      }
+    case PATH_LIFETIME_MODE:
+      {
+          // max-min: the route whose weakest node lasts longest, the nearest sink if they all last
+          for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = table.begin (); i != table.end (); ++i)
+            {
+              if (i->second.GetPathLifetime () > best->second.GetPathLifetime ()
+                  || (i->second.GetPathLifetime () == best->second.GetPathLifetime ()
+                      && (i->second.GetHop () < best->second.GetHop ()
+                          || (i->second.GetHop () == best->second.GetHop () && i->second.GetMinSnr () > best->second.GetMinSnr ()))))
+                {
+                  best = i;
+                }
+            }
+          break;
+      }
+    default:
+      {
+          return false;
+      }
+    }
+  rt = best->second;
+  return true;
+}
 
+void
+RoutingTableUp::SetSinkLoad (Ipv4Address sink, uint32_t seqNo, uint16_t subtreeSize, uint8_t uplinkLoad)
+{
+  std::map<Ipv4Address, SinkLoad>::iterator i = m_sinkLoads.find (sink);
+  if (i != m_sinkLoads.end () && i->second.seqNo > seqNo)
+    {
+      return;
     }
+  SinkLoad & load = m_sinkLoads[sink];
+  load.seqNo = seqNo;
+  load.subtreeSize = subtreeSize;
+  load.uplinkLoad = uplinkLoad;
+}
+
+bool
+RoutingTableUp::GetSinkLoad (Ipv4Address sink, uint16_t & subtreeSize, uint8_t & uplinkLoad) const
+{
+  std::map<Ipv4Address, SinkLoad>::const_iterator i = m_sinkLoads.find (sink);
+  if (i == m_sinkLoads.end ())
+    {
+      return false;
+    }
+  subtreeSize = i->second.subtreeSize;
+  uplinkLoad = i->second.uplinkLoad;
+  return true;
+}
+
+bool
+RoutingTableUp::SelectSink (Ipv4Address & sink) const
+{
+  std::set<Ipv4Address> sinks;
+  for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+    {
+      sinks.insert (i->second.GetDestination ());
+    }
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::const_iterator i = m_sinkEntries.begin (); i != m_sinkEntries.end (); ++i)
+    {
+      sinks.insert (i->first);
+    }
+  bool found = false;
+  bool hasCurrent = false;
+  double bestCost = 0;
+  double currentCost = 0;
+  for (std::set<Ipv4Address>::const_iterator i = sinks.begin (); i != sinks.end (); ++i)
+    {
+      std::map<Ipv4Address, SinkLoad>::const_iterator load = m_sinkLoads.find (*i);
+      if (load == m_sinkLoads.end ())
+        {
+          continue;
+        }
+      // the current sink counts this node already; a busy uplink delays each packet by 1 / (1 - utilisation)
+      uint32_t served = load->second.subtreeSize + (*i == m_currentSink ? 0 : m_subtreeSize);
+      double cost = served / (1 - std::min (load->second.uplinkLoad / 255.0f, MAX_CHANNEL_LOAD));
+      if (*i == m_currentSink)
+        {
+          hasCurrent = true;
+          currentCost = cost;
+        }
+      if (!found || cost < bestCost)
+        {
+          found = true;
+          bestCost = cost;
+          sink = *i;
+        }
+    }
+  if (hasCurrent && bestCost >= currentCost * (1 - m_sinkLoadHysteresis))
+    {
+      sink = m_currentSink;
+    }
+  return found;
+}
+
+bool
+RoutingTableUp::AddSinkRoute (RoutingTableEntryUp & rt)
+{
+  NS_LOG_FUNCTION (this << rt.GetDestination () << rt.GetNextHop ());
+  std::map<Ipv4Address, RoutingTableEntryUp> & candidates = m_sinkEntries[rt.GetDestination ()];
+  std::map<Ipv4Address, RoutingTableEntryUp> ranked = LoopFreeCandidates (candidates);
+  if (!ranked.empty ())
+    {
+      // the rank rule of the Hellos: a child that re-advertises this route has more hops
+      RoutingTableEntryUp const & first = ranked.begin ()->second;
+      if (rt.GetSeqNo () < first.GetSeqNo ()
+          || (rt.GetSeqNo () == first.GetSeqNo () && rt.GetHop () > first.GetHop ()))
+        {
+          NS_LOG_LOGIC ("Ignoring route to sink " << rt.GetDestination () << " via " << rt.GetNextHop ()
+                        << ": seqNo " << rt.GetSeqNo () << " hops " << rt.GetHop ());
           return false;
+        }
+      if (rt.GetSeqNo () > first.GetSeqNo ())
+        {
+          candidates.clear ();
+        }
+    }
+  candidates.erase (rt.GetNextHop ());
+  return candidates.insert (std::make_pair (rt.GetNextHop (), rt)).second;
+}
+
+std::map<Ipv4Address, RoutingTableEntryUp>
+RoutingTableUp::LoopFreeCandidates (std::map<Ipv4Address, RoutingTableEntryUp> const & candidates) const
+{
+  uint32_t seqNo = 0;
+  uint16_t minHops = 0;
+  for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      if (i == candidates.begin () || i->second.GetSeqNo () > seqNo
+          || (i->second.GetSeqNo () == seqNo && i->second.GetHop () < minHops))
+        {
+          seqNo = i->second.GetSeqNo ();
+          minHops = i->second.GetHop ();
+        }
+    }
+  std::map<Ipv4Address, RoutingTableEntryUp> ranked;
+  for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      if (i->second.GetSeqNo () == seqNo && i->second.GetHop () == minHops)
+        {
+          ranked.insert (*i);
+        }
+    }
+  return ranked;
+}
+
+bool
+RoutingTableUp::LookupSinkRoute (Ipv4Address sink, RoutingTableEntryUp & rt)
+{
+  NS_LOG_FUNCTION (this << sink);
+  Purge ();
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::const_iterator i = m_sinkEntries.find (sink);
+  if (i == m_sinkEntries.end ())
+    {
+      NS_LOG_LOGIC ("No route to sink " << sink);
+      return false;
+    }
+  return SelectBestRoute (LoopFreeCandidates (i->second), rt);
+}
 
+void
+RoutingTableUp::GetSinks (std::set<Ipv4Address> & sinks)
+{
+  Purge ();
+  sinks.clear ();
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::const_iterator i = m_sinkEntries.begin ();
+       i != m_sinkEntries.end (); ++i)
+    {
+      sinks.insert (i->first);
+    }
+}
+
+void
+RoutingTableUp::GetParents (std::map<Ipv4Address, RoutingTableEntryUp> & parents)
+{
+  Purge ();
+  parents = m_ipv4AddressEntry;
 }
 
 bool //DMS
@@ -336,6 +665,12 @@ RoutingTableUp::AddRoute (RoutingTableEntryUp & rt)
 {
   NS_LOG_FUNCTION (this);
   Purge ();
+  // the backup may be one of the routes replaced here
+  std::map<Ipv4Address, RoutingTableEntryUp> candidates = m_ipv4AddressEntry;
+  if (m_hasBackup)
+    {
+      candidates.insert (std::make_pair (m_backup.GetNextHop (), m_backup));
+    }
 /*
 if(m_routingMode==BASIC_MODE)
 {
@@ -371,9 +706,67 @@ else
 }
 
   std::pair<std::map<Ipv4Address, RoutingTableEntryUp>::iterator, bool> result = m_ipv4AddressEntry.insert (std::make_pair (rt.GetNextHop (), rt));//??? dst replaced by getway
+  candidates[rt.GetNextHop ()] = rt;
+  m_promoted = false;
+  UpdateBackup (candidates);
+  if (m_outage)
+    {
+      m_outage = false;
+      if (!m_outageCallback.IsNull ())
+        {
+          m_outageCallback (Simulator::Now () - m_outageStart);
+        }
+    }
   return result.second;
 }
 
+void
+RoutingTableUp::UpdateBackup (std::map<Ipv4Address, RoutingTableEntryUp> const & candidates)
+{
+  m_hasBackup = false;
+  RoutingTableEntryUp primary;
+  if (!m_enableBackup || !SelectBestRoute (m_ipv4AddressEntry, primary))
+    {
+      return;
+    }
+  std::map<Ipv4Address, RoutingTableEntryUp> loopFree;
+  for (std::map<Ipv4Address, RoutingTableEntryUp>::const_iterator i = candidates.begin (); i != candidates.end (); ++i)
+    {
+      if (i->first != primary.GetNextHop () && i->second.GetLifeTime () >= Seconds (0)
+          && i->second.GetDestination () == primary.GetDestination ()
+          && i->second.GetHop () <= primary.GetHop () && i->second.GetSeqNo () + 1 >= primary.GetSeqNo ())
+        {
+          loopFree.insert (*i);
+        }
+    }
+  m_hasBackup = SelectBestRoute (loopFree, m_backup);
+}
+
+
+bool
+RoutingTableUp::DeleteRoute (Ipv4Address nextHop)
+{
+  NS_LOG_FUNCTION (this << nextHop);
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::iterator i = m_sinkEntries.begin ();
+       i != m_sinkEntries.end (); ++i)
+    {
+      i->second.erase (nextHop);
+    }
+  if (m_hasBackup && m_backup.GetNextHop () == nextHop)
+    {
+      m_hasBackup = false;
+    }
+  if (m_ipv4AddressEntry.erase (nextHop) != 0)
+    {
+      NS_LOG_LOGIC ("Route deletion via " << nextHop << " successful");
+      m_parentLost = m_parentLost || nextHop == m_currentParent;
+      Purge ();
+      return true;
+    }
+  NS_LOG_LOGIC ("Route deletion via " << nextHop << " not successful");
+  return false;
+}
+
 
 bool
 RoutingTableUp::UpdateLifeTimeEntry (RoutingTableEntryUp & rt, Time lt)  //ADDED BY DMS
@@ -415,6 +808,21 @@ RoutingTableUp::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
           ++i;
         }
     }
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::iterator j = m_sinkEntries.begin ();
+       j != m_sinkEntries.end (); ++j)
+    {
+      for (std::map<Ipv4Address, RoutingTableEntryUp>::iterator i = j->second.begin (); i != j->second.end (); )
+        {
+          if (i->second.GetInterface () == iface)
+            {
+              j->second.erase (i++);
+            }
+          else
+            {
+              ++i;
+            }
+        }
+    }
 }
 
 void
@@ -422,10 +830,6 @@ RoutingTableUp::Purge ()
 {
   NS_LOG_FUNCTION (this);
 uint16_t minHops=10000;
-  if (m_ipv4AddressEntry.empty ())
-    {
-      return;
-    }
 
           for (std::map<Ipv4Address, RoutingTableEntryUp>::iterator i =
                  m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); )
@@ -443,6 +847,7 @@ uint16_t minHops=10000;
     {
       if ((i->second.GetLifeTime () < Seconds (0))/*||(i->second.GetHop ()>minHops)*/)
         {
+              m_parentLost = m_parentLost || i->first == m_currentParent;
               std::map<Ipv4Address, RoutingTableEntryUp>::iterator tmp = i;
               ++i;
               m_ipv4AddressEntry.erase (tmp);
@@ -453,6 +858,62 @@ uint16_t minHops=10000;
           ++i;
         }
     }
+
+  std::map<Ipv4Address, RoutingTableEntryUp> bestPerSink;
+  for (std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> >::iterator i = m_sinkEntries.begin ();
+       i != m_sinkEntries.end (); )
+    {
+      Purge (i->second);
+      RoutingTableEntryUp best;
+      if (SelectBestRoute (LoopFreeCandidates (i->second), best))
+        {
+          bestPerSink.insert (std::make_pair (i->first, best));
+          ++i;
+        }
+      else
+        {
+          m_sinkEntries.erase (i++);
+        }
+    }
+
+  if (m_parentLost)
+    {
+      NS_LOG_LOGIC ("Parent " << m_currentParent << " lost");
+      if (m_hasBackup && m_backup.GetLifeTime () >= Seconds (0) && m_backup.GetNextHop () != m_currentParent)
+        {
+          NS_LOG_LOGIC ("Promote backup parent " << m_backup.GetNextHop ());
+          m_ipv4AddressEntry.insert (std::make_pair (m_backup.GetNextHop (), m_backup));
+          m_promoted = true;
+          m_promotedParent = m_backup.GetNextHop ();
+        }
+      m_hasBackup = false;
+    }
+
+  // all the routes in use broke: switch to the best other sink at once
+  RoutingTableEntryUp best;
+  if (m_ipv4AddressEntry.empty () && SelectBestRoute (bestPerSink, best))
+    {
+      NS_LOG_LOGIC ("Switch to sink " << best.GetDestination ());
+      m_ipv4AddressEntry = LoopFreeCandidates (m_sinkEntries[best.GetDestination ()]);
+    }
+
+  if (m_parentLost)
+    {
+      m_parentLost = false;
+      if (!m_ipv4AddressEntry.empty ())
+        {
+          // another route was at hand
+          if (!m_outageCallback.IsNull ())
+            {
+              m_outageCallback (Seconds (0));
+            }
+        }
+      else if (!m_outage)
+        {
+          m_outage = true;
+          m_outageStart = Simulator::Now ();
+        }
+    }
 }
 
 void
@@ -601,6 +1062,62 @@ RoutingTableDown::UpdateLifeTimeEntry (RoutingTableEntryDown & rt, Time lt)  //A
   return true;
 }
 
+void
+RoutingTableDown::GetListOfDestinationWithNextHop (Ipv4Address nextHop,
+                                                   std::map<Ipv4Address, uint32_t> & unreachable)
+{
+  NS_LOG_FUNCTION (this << nextHop);
+  Purge ();
+  unreachable.clear ();
+  for (std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator i =
+         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+    {
+      if (i->second.GetNextHop () == nextHop)
+        {
+          NS_LOG_LOGIC ("Unreachable insert " << i->first << " " << i->second.GetSeqNo ());
+          unreachable.insert (std::make_pair (i->first, i->second.GetSeqNo ()));
+        }
+    }
+}
+
+void
+RoutingTableDown::GetChildren (std::set<Ipv4Address> & children)
+{
+  NS_LOG_FUNCTION (this);
+  Purge ();
+  children.clear ();
+  for (std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator i =
+         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+    {
+      Ipv4Address nextHop = i->second.GetNextHop ();
+      if (nextHop.IsBroadcast () || nextHop == Ipv4Address::GetLoopback ()
+          || nextHop == i->second.GetInterface ().GetBroadcast ())
+        {
+          continue;
+        }
+      children.insert (nextHop);
+    }
+}
+
+void
+RoutingTableDown::GetDestinations (std::set<Ipv4Address> & destinations)
+{
+  NS_LOG_FUNCTION (this);
+  Purge ();
+  destinations.clear ();
+  for (std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator i =
+         m_ipv4AddressEntry.begin (); i != m_ipv4AddressEntry.end (); ++i)
+    {
+      Ipv4Address nextHop = i->second.GetNextHop ();
+      if (nextHop.IsBroadcast () || nextHop == Ipv4Address::GetLoopback ()
+          || nextHop == i->second.GetInterface ().GetBroadcast ())
+        {
+          continue;
+        }
+      destinations.insert (i->first);
+    }
+}
+
 void
 RoutingTableDown::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
 {
@@ -710,5 +1227,380 @@ RoutingTableDown::PrintInScreen ()  const //DMS added by dms
 
 
 // end RoutingTableDown DMS ////////////////////////////////////////////////////
+
+
+// RoutingTableServer ////////////////////////////////////////////////////////////
+
+RoutingTableServer::RoutingTableServer ()
+  : m_sinkSelection (FEWEST_HOPS),
+    m_maxCandidates (4),
+    m_loadHalfLife (Seconds (1)),
+    m_sinkDeadInterval (Seconds (0))
+{
+}
+
+bool
+RoutingTableServer::IsFresher (RoutingTableEntryDown const & a, RoutingTableEntryDown const & b)
+{
+  if (a.GetSeqNo () != b.GetSeqNo ())
+    {
+      return a.GetSeqNo () > b.GetSeqNo ();
+    }
+  return a.GetLifeTime () > b.GetLifeTime ();
+}
+
+bool
+RoutingTableServer::IsAlive (Shard const & shard) const
+{
+  return shard.m_alive
+         && (m_sinkDeadInterval.IsZero () || Simulator::Now () - shard.m_lastSeen <= m_sinkDeadInterval);
+}
+
+void
+RoutingTableServer::GetCandidates (Ipv4Address dst, std::map<Ipv4Address, RoutingTableEntryDown> & candidates) const
+{
+  candidates.clear ();
+  std::map<Ipv4Address, std::set<Ipv4Address> >::const_iterator i = m_index.find (dst);
+  if (i == m_index.end ())
+    {
+      return;
+    }
+  for (std::set<Ipv4Address>::const_iterator j = i->second.begin (); j != i->second.end (); ++j)
+    {
+      std::map<Ipv4Address, Shard>::const_iterator shard = m_shards.find (*j);
+      if (shard == m_shards.end () || !IsAlive (shard->second))
+        {
+          continue;
+        }
+      std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator k = shard->second.m_entries.find (dst);
+      if (k == shard->second.m_entries.end () || k->second.GetLifeTime () < Seconds (0))
+        {
+          continue;
+        }
+      candidates.insert (std::make_pair (*j, k->second));
+    }
+}
+
+bool
+RoutingTableServer::AddRoute (RoutingTableEntryDown & rt)
+{
+  NS_LOG_FUNCTION (this << rt.GetDestination () << rt.GetNextHop ());
+  Ipv4Address dst = rt.GetDestination ();
+  Ipv4Address sink = rt.GetNextHop ();
+  std::map<Ipv4Address, RoutingTableEntryDown> candidates;
+  GetCandidates (dst, candidates);
+  if (m_maxCandidates != 0 && candidates.find (sink) == candidates.end ()
+      && candidates.size () >= m_maxCandidates)
+    {
+      std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator stalest = candidates.begin ();
+      for (std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator i = candidates.begin ();
+           i != candidates.end (); ++i)
+        {
+          if (IsFresher (stalest->second, i->second))
+            {
+              stalest = i;
+            }
+        }
+      if (!IsFresher (rt, stalest->second))
+        {
+          NS_LOG_LOGIC ("Candidate sink " << sink << " of " << dst << " rejected");
+          return false;
+        }
+      NS_LOG_LOGIC ("Candidate sink " << stalest->first << " of " << dst << " replaced");
+      DeleteRoute (dst, stalest->first);
+    }
+  std::map<Ipv4Address, Shard>::iterator shard = m_shards.find (sink);
+  if (shard == m_shards.end ())
+    {
+      NotifySinkAlive (sink, rt.GetInterface ());
+      shard = m_shards.find (sink);
+    }
+  shard->second.m_entries[dst] = rt;
+  m_index[dst].insert (sink);
+  return true;
+}
+
+bool
+RoutingTableServer::DeleteRoute (Ipv4Address dst, Ipv4Address sink)
+{
+  NS_LOG_FUNCTION (this << dst << sink);
+  std::map<Ipv4Address, std::set<Ipv4Address> >::iterator i = m_index.find (dst);
+  if (i == m_index.end () || i->second.erase (sink) == 0)
+    {
+      return false;
+    }
+  if (i->second.empty ())
+    {
+      m_index.erase (i);
+    }
+  std::map<Ipv4Address, Shard>::iterator shard = m_shards.find (sink);
+  return shard != m_shards.end () && shard->second.m_entries.erase (dst) != 0;
+}
+
+bool
+RoutingTableServer::DeleteRoute (Ipv4Address dst)
+{
+  NS_LOG_FUNCTION (this << dst);
+  std::map<Ipv4Address, std::set<Ipv4Address> >::iterator i = m_index.find (dst);
+  if (i == m_index.end ())
+    {
+      return false;
+    }
+  for (std::set<Ipv4Address>::const_iterator j = i->second.begin (); j != i->second.end (); ++j)
+    {
+      std::map<Ipv4Address, Shard>::iterator shard = m_shards.find (*j);
+      if (shard != m_shards.end ())
+        {
+          shard->second.m_entries.erase (dst);
+        }
+    }
+  m_index.erase (i);
+  return true;
+}
+
+bool
+RoutingTableServer::LookupRoute (Ipv4Address dst, RoutingTableEntryDown & rt) const
+{
+  NS_LOG_FUNCTION (this << dst);
+  std::map<Ipv4Address, RoutingTableEntryDown> candidates;
+  GetCandidates (dst, candidates);
+  if (!SelectSink (candidates, rt))
+    {
+      NS_LOG_LOGIC ("Route to " << dst << " not found");
+      return false;
+    }
+  return true;
+}
+
+bool
+RoutingTableServer::LookupCandidate (Ipv4Address dst, Ipv4Address sink, RoutingTableEntryDown & rt) const
+{
+  NS_LOG_FUNCTION (this << dst << sink);
+  std::map<Ipv4Address, Shard>::const_iterator shard = m_shards.find (sink);
+  if (shard == m_shards.end () || !IsAlive (shard->second))
+    {
+      return false;
+    }
+  std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator i = shard->second.m_entries.find (dst);
+  if (i == shard->second.m_entries.end () || i->second.GetLifeTime () < Seconds (0))
+    {
+      return false;
+    }
+  rt = i->second;
+  return true;
+}
+
+uint32_t
+RoutingTableServer::GetCandidateCount (Ipv4Address dst) const
+{
+  std::map<Ipv4Address, RoutingTableEntryDown> candidates;
+  GetCandidates (dst, candidates);
+  return candidates.size ();
+}
+
+void
+RoutingTableServer::NotifySinkAlive (Ipv4Address sink, Ipv4InterfaceAddress iface)
+{
+  NS_LOG_FUNCTION (this << sink);
+  std::map<Ipv4Address, Shard>::iterator i = m_shards.find (sink);
+  if (i == m_shards.end ())
+    {
+      i = m_shards.insert (std::make_pair (sink, Shard ())).first;
+    }
+  else if (!i->second.m_alive)
+    {
+      // the entries of an invalidated sink are not trusted again, new advertises will refill the shard
+      NS_LOG_LOGIC ("Sink " << sink << " is back");
+      i->second.m_entries.clear ();
+    }
+  i->second.m_alive = true;
+  i->second.m_lastSeen = Simulator::Now ();
+  i->second.m_iface = iface;
+}
+
+bool
+RoutingTableServer::InvalidateSink (Ipv4Address sink)
+{
+  NS_LOG_FUNCTION (this << sink);
+  std::map<Ipv4Address, Shard>::iterator i = m_shards.find (sink);
+  if (i == m_shards.end ())
+    {
+      return false;
+    }
+  i->second.m_alive = false;
+  return true;
+}
+
+bool
+RoutingTableServer::IsSinkAlive (Ipv4Address sink) const
+{
+  std::map<Ipv4Address, Shard>::const_iterator i = m_shards.find (sink);
+  return i != m_shards.end () && IsAlive (i->second);
+}
+
+void
+RoutingTableServer::NotifyForwarded (Ipv4Address sink)
+{
+  SinkLoad & load = m_sinkLoad[sink];
+  load.m_load = GetSinkLoad (sink) + 1;
+  load.m_lastUpdate = Simulator::Now ();
+}
+
+double
+RoutingTableServer::GetSinkLoad (Ipv4Address sink) const
+{
+  std::map<Ipv4Address, SinkLoad>::const_iterator i = m_sinkLoad.find (sink);
+  if (i == m_sinkLoad.end ())
+    {
+      return 0;
+    }
+  if (m_loadHalfLife.IsZero ())
+    {
+      return i->second.m_load;
+    }
+  double elapsed = (Simulator::Now () - i->second.m_lastUpdate).GetSeconds ();
+  return i->second.m_load * std::pow (0.5, elapsed / m_loadHalfLife.GetSeconds ());
+}
+
+bool
+RoutingTableServer::SelectSink (std::map<Ipv4Address, RoutingTableEntryDown> const & candidates,
+                                RoutingTableEntryDown & rt) const
+{
+  std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator best = candidates.end ();
+  for (std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator i = candidates.begin ();
+       i != candidates.end (); ++i)
+    {
+      if (best == candidates.end ())
+        {
+          best = i;
+          continue;
+        }
+      bool better = false;
+      switch (m_sinkSelection)
+        {
+        case FEWEST_HOPS:
+          better = i->second.GetHop () < best->second.GetHop ()
+            || (i->second.GetHop () == best->second.GetHop () && IsFresher (i->second, best->second));
+          break;
+        case LEAST_LOADED:
+          {
+            double load = GetSinkLoad (i->first);
+            double bestLoad = GetSinkLoad (best->first);
+            better = load < bestLoad
+              || (load == bestLoad && i->second.GetHop () < best->second.GetHop ());
+            break;
+          }
+        case FRESHEST:
+          better = IsFresher (i->second, best->second);
+          break;
+        }
+      if (better)
+        {
+          best = i;
+        }
+    }
+  if (best == candidates.end ())
+    {
+      return false;
+    }
+  rt = best->second;
+  NS_LOG_LOGIC ("Route to " << rt.GetDestination () << " through sink " << best->first);
+  return true;
+}
+
+void
+RoutingTableServer::DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<Ipv4Address, Shard>::iterator i = m_shards.begin (); i != m_shards.end (); ++i)
+    {
+      if (i->second.m_iface == iface)
+        {
+          i->second.m_alive = false;
+        }
+    }
+}
+
+void
+RoutingTableServer::Clear ()
+{
+  m_shards.clear ();
+  m_index.clear ();
+  m_sinkLoad.clear ();
+}
+
+void
+RoutingTableServer::Purge ()
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<Ipv4Address, Shard>::iterator i = m_shards.begin (); i != m_shards.end (); ++i)
+    {
+      if (!IsAlive (i->second))
+        {
+          i->second.m_entries.clear ();
+          continue;
+        }
+      for (std::map<Ipv4Address, RoutingTableEntryDown>::iterator j = i->second.m_entries.begin ();
+           j != i->second.m_entries.end (); )
+        {
+          if (j->second.GetLifeTime () < Seconds (0))
+            {
+              i->second.m_entries.erase (j++);
+            }
+          else
+            {
+              ++j;
+            }
+        }
+    }
+  for (std::map<Ipv4Address, std::set<Ipv4Address> >::iterator i = m_index.begin (); i != m_index.end (); )
+    {
+      for (std::set<Ipv4Address>::iterator j = i->second.begin (); j != i->second.end (); )
+        {
+          std::map<Ipv4Address, Shard>::const_iterator shard = m_shards.find (*j);
+          if (shard == m_shards.end () || shard->second.m_entries.find (i->first) == shard->second.m_entries.end ())
+            {
+              i->second.erase (j++);
+            }
+          else
+            {
+              ++j;
+            }
+        }
+      if (i->second.empty ())
+        {
+          m_index.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+RoutingTableServer::Print (Ptr<OutputStreamWrapper> stream) const
+{
+  *stream->GetStream () << "\nDMSRP Server routing table\n"
+                        << "Destination\tGateway\t\tInterface\tFlag\tExpire\t\tHops\n";
+  for (std::map<Ipv4Address, std::set<Ipv4Address> >::const_iterator i = m_index.begin (); i != m_index.end (); ++i)
+    {
+      std::map<Ipv4Address, RoutingTableEntryDown> candidates;
+      GetCandidates (i->first, candidates);
+      RoutingTableEntryDown selected;
+      if (!SelectSink (candidates, selected))
+        {
+          continue;
+        }
+      for (std::map<Ipv4Address, RoutingTableEntryDown>::const_iterator j = candidates.begin (); j != candidates.end (); ++j)
+        {
+          *stream->GetStream () << (j->first == selected.GetNextHop () ? "*" : " ");
+          j->second.Print (stream);
+        }
+    }
+  *stream->GetStream () << "\n";
+}
+
+// end RoutingTableServer ////////////////////////////////////////////////////////
 }
 }
@@ -21,13 +21,17 @@
 
 #include <stdint.h>
 #include <cassert>
+#include <algorithm>
 #include <map>
+#include <set>
+#include <vector>
 #include <sys/types.h>
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/timer.h"
 #include "ns3/net-device.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/callback.h"
 
 namespace ns3 {
 namespace dmsrp {
@@ -39,6 +43,36 @@ enum RoutingMode
   MULTI_PARENT_MODE = 1,      //!< 
   ENERGY_AWARE_MULTI_PARENT_MODE = 2,      //!< 
   SNR_AWARE_MULTI_PARENT_MODE = 3,      //!< 
+  CENTRALIZED_MODE = 4,      //!< parent assigned by the server, best SNR route meanwhile
+  COMPOSITE_MODE = 5,      //!< weighted SNR, energy, hops and lifetime, with hysteresis
+  ETX_MODE = 6,      //!< fewest expected transmissions to the sink
+  AIRTIME_MODE = 7,      //!< least cumulative airtime to the sink
+  CHANNEL_LOAD_MODE = 8,      //!< fewest hops, stretched by the channel load around the parent
+  LINK_LIFETIME_MODE = 9,      //!< longest predicted link lifetime, then best SNR
+  PATH_LIFETIME_MODE = 10,      //!< longest predicted time before a node of the path is depleted, then fewest hops
+};
+
+/// How the server picks the sink a downlink packet goes through, among the candidate sinks of its destination
+enum SinkSelection
+{
+  FEWEST_HOPS = 0,      //!< the sink closest to the destination
+  LEAST_LOADED = 1,     //!< the sink that carried the least downlink traffic lately
+  FRESHEST = 2,         //!< the sink that reported the newest advertise of the destination
+};
+
+/// Where the downlink routes are kept
+enum DownlinkMode
+{
+  STORING = 0,          //!< every relay keeps a down route to each node of its subtree
+  NON_STORING = 1,      //!< only the sinks keep down routes, with the path; relays follow a source route
+  BLOOM = 2,            //!< relays keep a Bloom filter of the descendants of each child
+};
+
+/// How a sink with several servers shares its advertises among them
+enum ServerDistribution
+{
+  REPLICATE = 0,        //!< every server learns every node; flows are spread by flow hash
+  PARTITION = 1,        //!< each node is learnt by one server; flows go to the server of their destination
 };
 
 // DMS RoutingTableEntryUp ---------------------------------------
@@ -244,9 +278,9 @@ public:
    * Set the m_cumEnergy
    * \param lt The m_cumEnergy
    */
-  void SetCumEnergy (float minSnr)
+  void SetCumEnergy (float cumEnergy)
   {
-    m_minSnr = minSnr;
+    m_cumEnergy = cumEnergy;
   }
   /**
    * Get the m_cumEnergy
@@ -256,6 +290,86 @@ public:
   {
     return m_cumEnergy;
   }
+  /**
+   * Set the expected number of transmissions to the sink
+   * \param pathEtx the ETX of the parent link plus the path ETX of the parent
+   */
+  void SetPathEtx (float pathEtx)
+  {
+    m_pathEtx = pathEtx;
+  }
+  /**
+   * Get the expected number of transmissions to the sink
+   * \returns the path ETX
+   */
+  float GetPathEtx () const
+  {
+    return m_pathEtx;
+  }
+  /**
+   * Set the airtime a frame takes to reach the sink
+   * \param pathAirtime the airtime of the parent link plus the path airtime of the parent, in microseconds
+   */
+  void SetPathAirtime (float pathAirtime)
+  {
+    m_pathAirtime = pathAirtime;
+  }
+  /**
+   * Get the airtime a frame takes to reach the sink
+   * \returns the path airtime, in microseconds
+   */
+  float GetPathAirtime () const
+  {
+    return m_pathAirtime;
+  }
+  /**
+   * Set the channel load around the next hop
+   * \param channelLoad the fraction of the time the next hop senses the channel busy
+   */
+  void SetChannelLoad (float channelLoad)
+  {
+    m_channelLoad = channelLoad;
+  }
+  /**
+   * Get the channel load around the next hop
+   * \returns the busy fraction
+   */
+  float GetChannelLoad () const
+  {
+    return m_channelLoad;
+  }
+  /**
+   * Set the predicted lifetime of the link to the next hop
+   * \param lt the time before the link breaks
+   */
+  void SetLinkLifetime (Time lt)
+  {
+    m_linkBreak = Simulator::Now () + std::min (lt, Simulator::GetMaximumSimulationTime () - Simulator::Now ());
+  }
+  /**
+   * Get the predicted lifetime of the link to the next hop
+   * \returns the time before the link breaks
+   */
+  Time GetLinkLifetime () const
+  {
+    return m_linkBreak - Simulator::Now ();
+  }
+  /**
+   * Set the predicted time before a node of the path is depleted
+   * \param pathLifetime the shortest predicted lifetime of the next hop and the nodes of its route, in seconds
+   */
+  void SetPathLifetime (float pathLifetime)
+  {
+    m_pathLifetime = pathLifetime;
+  }
+  /**
+   * Get the predicted time before a node of the path is depleted
+   * \returns the path lifetime, in seconds
+   */
+  float GetPathLifetime () const
+  {
+    return m_pathLifetime;
+  }
 
 
   /// RREP_ACK timer
@@ -294,6 +408,16 @@ private:
    */
 float m_cumEnergy;
 float m_minSnr;
+  /// Expected number of transmissions to the sink
+  float m_pathEtx;
+  /// Airtime a frame takes to reach the sink, in microseconds
+  float m_pathAirtime;
+  /// Busy fraction of the channel around the next hop
+  float m_channelLoad;
+  /// Predicted break of the link to the next hop
+  Time m_linkBreak;
+  /// Predicted time before a node of the path is depleted, in seconds
+  float m_pathLifetime;
   Ptr<Ipv4Route> m_ipv4Route;
   /// Output interface address
   Ipv4InterfaceAddress m_iface;
@@ -487,6 +611,22 @@ public:
   {
     return m_lifeTime - Simulator::Now ();
   }
+  /**
+   * Set the relays between the next hop and the destination (non-storing mode)
+   * \param path the relays, the parent of the destination first
+   */
+  void SetPath (std::vector<Ipv4Address> const & path)
+  {
+    m_path = path;
+  }
+  /**
+   * Get the relays between the next hop and the destination
+   * \returns the relays, the parent of the destination first; empty if the next hop is its parent or the destination
+   */
+  std::vector<Ipv4Address> const & GetPath () const
+  {
+    return m_path;
+  }
 
   /// RREP_ACK timer
   Timer m_ackTimer;
@@ -529,6 +669,8 @@ private:
   Ptr<Ipv4Route> m_ipv4Route;
   /// Output interface address
   Ipv4InterfaceAddress m_iface;
+  /// Relays between the next hop and the destination (non-storing mode)
+  std::vector<Ipv4Address> m_path;
 };
 
 
@@ -561,11 +703,11 @@ public:
    */
   bool AddRoute (RoutingTableEntryUp & r);
   /**
-   * Delete routing table entry with destination address dst, if it exists.
-   * \param dst destination address
+   * Delete the routing table entry through the parent nextHop, if it exists.
+   * \param nextHop next hop (parent) address
    * \return true on success
    */
-  bool DeleteRoute (Ipv4Address dst);
+  bool DeleteRoute (Ipv4Address nextHop);
 
 
 
@@ -575,6 +717,44 @@ uint32_t GetMinHops ();   // DMS
   bool LookupBestRoute (RoutingTableEntryUp & rt);   // DMS
    bool GetNextNode (Ipv4Address & NextNodeAdr);  // DMS//get the IP adresse of the next node to keep the sink - DMS added by dms
 
+  /**
+   * Keep a route to the sink rt.GetDestination () through rt.GetNextHop (), learnt from a
+   * Hello record. These routes take over when the routes in use all break.
+   * As for the Hellos of the best route, a route with the newest sequence number
+   * of the sink must not have more hops than the others, or it may come from a
+   * node below this one.
+   * \param rt routing table entry
+   * \return false if the route was ignored
+   */
+  bool AddSinkRoute (RoutingTableEntryUp & rt);
+  /**
+   * Lookup the best route to a given sink
+   * \param sink the sink address
+   * \param rt the best entry, if exists
+   * \return true on success
+   */
+  bool LookupSinkRoute (Ipv4Address sink, RoutingTableEntryUp & rt);
+  /**
+   * Get the sinks this node has a route to
+   * \param sinks the sink addresses
+   */
+  void GetSinks (std::set<Ipv4Address> & sinks);
+  /**
+   * Get the valid routes of the sink in use, one per parent
+   * \param parents the routes, keyed by parent (next hop)
+   */
+  void GetParents (std::map<Ipv4Address, RoutingTableEntryUp> & parents);
+  /**
+   * Set the parent assigned by the server, used in CENTRALIZED_MODE while it is a valid next hop
+   * \param parent the parent address
+   * \param lifetime how long the assignment is valid
+   */
+  void SetAssignedParent (Ipv4Address parent, Time lifetime)
+  {
+    m_assignedParent = parent;
+    m_assignedParentExpiry = Simulator::Now () + lifetime;
+  }
+
 
   /**
    * Lookup routing table entry with destination address dst
@@ -603,8 +783,17 @@ bool UpdateLifeTimeEntry (RoutingTableEntryUp & rt, Time lt) ; //ADDED BY DMS
   void Clear ()
   {
     m_ipv4AddressEntry.clear ();
+    m_sinkEntries.clear ();
+    m_hasBackup = false;
+    m_promoted = false;
+    m_parentLost = false;
+    m_outage = false;
+    m_sinkLoads.clear ();
   }
-  /// Delete all outdated entries 
+  /**
+   * Delete all outdated entries; if the parent was lost, promote the backup
+   * parent; if no route is left, take over the routes to the best other sink
+   */
   void Purge ();
 
   /**
@@ -623,6 +812,105 @@ bool UpdateLifeTimeEntry (RoutingTableEntryUp & rt, Time lt) ; //ADDED BY DMS
   {
     return m_routingMode;
   }
+  /**
+   * Set the weights of the composite metric. Each term is normalized by the best
+   * candidate: SNR, cumulative energy and lifetime of the route, and fewest hops over hops.
+   * \param snr the SNR weight
+   * \param energy the energy weight
+   * \param hops the hop count weight
+   * \param lifetime the lifetime weight
+   */
+  void SetMetricWeights (double snr, double energy, double hops, double lifetime)
+  {
+    m_snrWeight = snr;
+    m_energyWeight = energy;
+    m_hopWeight = hops;
+    m_lifetimeWeight = lifetime;
+  }
+  /**
+   * \param hysteresis the relative margin by which a candidate must beat the
+   * current parent to replace it in COMPOSITE_MODE
+   */
+  void SetParentHysteresis (double hysteresis)
+  {
+    m_parentHysteresis = hysteresis;
+  }
+  /**
+   * Set the link lifetime beyond which two parents are equal in the link lifetime mode
+   * \param horizon the lifetime
+   */
+  void SetLinkLifetimeHorizon (Time horizon)
+  {
+    m_linkLifetimeHorizon = horizon;
+  }
+  /**
+   * Make the best route go to the least loaded sink
+   * \param enable whether the load of the sinks is taken into account
+   * \param hysteresis relative margin by which another sink must be less loaded than the current one
+   */
+  void SetSinkLoadBalancing (bool enable, double hysteresis)
+  {
+    m_sinkLoadBalancing = enable;
+    m_sinkLoadHysteresis = hysteresis;
+  }
+  /**
+   * \param subtreeSize the number of nodes that reach the sink through this node, itself included
+   */
+  void SetSubtreeSize (uint16_t subtreeSize)
+  {
+    m_subtreeSize = subtreeSize;
+  }
+  /**
+   * Record the load a sink advertised in its Hellos
+   * \param sink the sink
+   * \param seqNo the sequence number of its Hello
+   * \param subtreeSize the number of nodes it serves
+   * \param uplinkLoad the utilisation of its uplink, in 255ths
+   */
+  void SetSinkLoad (Ipv4Address sink, uint32_t seqNo, uint16_t subtreeSize, uint8_t uplinkLoad);
+  /**
+   * Get the load of a sink
+   * \param sink the sink
+   * \param subtreeSize the number of nodes it serves
+   * \param uplinkLoad the utilisation of its uplink, in 255ths
+   * \returns false if the sink did not advertise its load
+   */
+  bool GetSinkLoad (Ipv4Address sink, uint16_t & subtreeSize, uint8_t & uplinkLoad) const;
+  /**
+   * Callback called when the best route goes through another parent, with the old and the new parent
+   * \param cb the callback
+   */
+  void SetParentChangeCallback (Callback<void, Ipv4Address, Ipv4Address> cb)
+  {
+    m_parentChangeCallback = cb;
+  }
+  /**
+   * \param enable whether a backup parent is kept, to replace the parent as soon as it is lost
+   */
+  void SetBackupParent (bool enable)
+  {
+    m_enableBackup = enable;
+    m_hasBackup = false;
+  }
+  /**
+   * Get the backup parent
+   * \param rt the route through the backup parent
+   * \return false if there is none
+   */
+  bool LookupBackupRoute (RoutingTableEntryUp & rt) const
+  {
+    rt = m_backup;
+    return m_hasBackup;
+  }
+  /**
+   * Callback called when the node has a route again after losing its parent,
+   * with the time it stayed without one (zero if another route was at hand)
+   * \param cb the callback
+   */
+  void SetOutageCallback (Callback<void, Time> cb)
+  {
+    m_outageCallback = cb;
+  }
 
    /**
    * Print routing table
@@ -635,17 +923,285 @@ bool UpdateLifeTimeEntry (RoutingTableEntryUp & rt, Time lt) ; //ADDED BY DMS
 private:
   /// The routing table
   std::map<Ipv4Address, RoutingTableEntryUp> m_ipv4AddressEntry;
+  /// The routes to every known sink: sink -> (next hop -> entry)
+  std::map<Ipv4Address, std::map<Ipv4Address, RoutingTableEntryUp> > m_sinkEntries;
+  /**
+   * Select the best entry of a table according to the routing mode
+   * \param table the candidate entries
+   * \param rt the best entry
+   * \return false if the table is empty
+   */
+  bool SelectBestRoute (std::map<Ipv4Address, RoutingTableEntryUp> const & table, RoutingTableEntryUp & rt) const;
+  /**
+   * Rank the candidates that cannot lead into a loop, and keep the best one
+   * as the backup of the best route. A candidate must lead to the same sink,
+   * through another neighbor, with no more hops than the best route (the
+   * neighbor is not below this node) and a sequence number at most one Hello
+   * round behind.
+   * \param candidates the candidate entries
+   */
+  void UpdateBackup (std::map<Ipv4Address, RoutingTableEntryUp> const & candidates);
+  /**
+   * Keep the routes to a sink that cannot lead into a loop: those with the
+   * newest sequence number of the sink and, among them, the fewest hops.
+   * \param candidates the routes to one sink
+   * \returns the loop-free routes
+   */
+  std::map<Ipv4Address, RoutingTableEntryUp> LoopFreeCandidates (std::map<Ipv4Address, RoutingTableEntryUp> const & candidates) const;
+  /**
+   * Pick the sink the best route should go to: the one that would serve the
+   * fewest nodes, stretched by the utilisation of its uplink, once this node
+   * and its subtree join it. The current sink is kept unless another one is
+   * less loaded by the hysteresis margin.
+   * \param sink the sink
+   * \returns false if no sink this node has a route to advertised its load
+   */
+  bool SelectSink (Ipv4Address & sink) const;
  
   /**
    * const version of Purge, for use by Print() method
    * \param table the routing table entry to purge
    */
   RoutingMode m_routingMode; //DMS
+  double m_snrWeight;             ///< Weight of the SNR in the composite metric
+  double m_energyWeight;          ///< Weight of the cumulative energy in the composite metric
+  double m_hopWeight;             ///< Weight of the hop count in the composite metric
+  double m_lifetimeWeight;        ///< Weight of the route lifetime in the composite metric
+  double m_parentHysteresis;      ///< Margin a candidate must have over the current parent
+  Time m_linkLifetimeHorizon;     ///< Link lifetime beyond which parents are equal
+  Ipv4Address m_currentParent;    ///< Parent of the last best route
+  Callback<void, Ipv4Address, Ipv4Address> m_parentChangeCallback;  ///< parent change callback
+  bool m_enableBackup;            ///< Whether a backup parent is kept
+  bool m_hasBackup;               ///< Whether m_backup holds a backup parent
+  RoutingTableEntryUp m_backup;   ///< Route through the backup parent
+  bool m_promoted;                ///< Whether the backup parent replaced the lost parent, until the next route is added
+  Ipv4Address m_promotedParent;   ///< The promoted backup parent
+  bool m_parentLost;              ///< The entry of the parent was just removed
+  bool m_outage;                  ///< No route since the parent was lost
+  Time m_outageStart;             ///< When the parent was lost
+  Callback<void, Time> m_outageCallback;  ///< outage callback
+  /// Load a sink advertised
+  struct SinkLoad
+  {
+    uint32_t seqNo;         ///< Sequence number of the Hello of the sink
+    uint16_t subtreeSize;   ///< Number of nodes the sink serves
+    uint8_t uplinkLoad;     ///< Utilisation of the uplink of the sink, in 255ths
+  };
+  std::map<Ipv4Address, SinkLoad> m_sinkLoads;  ///< Load of each sink
+  bool m_sinkLoadBalancing;       ///< Whether the best route goes to the least loaded sink
+  double m_sinkLoadHysteresis;    ///< Margin another sink must have over the current one
+  uint16_t m_subtreeSize;         ///< Nodes that reach the sink through this node, itself included
+  Ipv4Address m_currentSink;      ///< Sink of the last best route
+  Ipv4Address m_assignedParent;   ///< Parent assigned by the server
+  Time m_assignedParentExpiry;    ///< End of validity of the assigned parent
   void Purge (std::map<Ipv4Address, RoutingTableEntryUp> &table) const;
 };
 
 // end DMS routing table2   --------------------------------------------------------
 
+/**
+ * \ingroup dmsrp
+ * \brief The downlink table of the server
+ *
+ * The server may hear the advertise of a destination through several sinks.
+ * Instead of one route per destination it keeps a small set of candidate
+ * entries, one per sink (the next hop of the entry), and selects one of them
+ * at lookup time. Expired candidates are skipped by the selection, so the
+ * traffic moves to the next sink as soon as the entry of a sink expires.
+ *
+ * The entries are stored in one shard per sink, and an index gives the sinks
+ * a destination was heard through. A sink is alive while its SrvAdvertise
+ * keep arriving; when it falls silent for the dead interval, or when it is
+ * invalidated, its whole shard is skipped by a single check and the
+ * destinations behind it move to their other candidate sinks.
+ */
+class RoutingTableServer
+{
+public:
+  /// constructor
+  RoutingTableServer ();
+
+  /**
+   * Add or refresh the candidate entry of destination rt.GetDestination () through sink rt.GetNextHop ().
+   * When the destination already has the maximum number of candidates, the stalest one is replaced.
+   * \param rt routing table entry
+   * \return false if the entry is staler than all the candidates of a full set
+   */
+  bool AddRoute (RoutingTableEntryDown & rt);
+  /**
+   * Delete the candidate entry of destination dst through sink
+   * \param dst destination address
+   * \param sink the sink address
+   * \return true on success
+   */
+  bool DeleteRoute (Ipv4Address dst, Ipv4Address sink);
+  /**
+   * Delete all the candidate entries of destination dst
+   * \param dst destination address
+   * \return true on success
+   */
+  bool DeleteRoute (Ipv4Address dst);
+  /**
+   * Select the entry of destination dst according to the sink selection policy
+   * \param dst destination address
+   * \param rt the selected entry, if any
+   * \return true on success
+   */
+  bool LookupRoute (Ipv4Address dst, RoutingTableEntryDown & rt) const;
+  /**
+   * Lookup the candidate entry of destination dst through sink
+   * \param dst destination address
+   * \param sink the sink address
+   * \param rt the entry, if exists
+   * \return true on success
+   */
+  bool LookupCandidate (Ipv4Address dst, Ipv4Address sink, RoutingTableEntryDown & rt) const;
+  /**
+   * \param dst destination address
+   * \returns the number of valid candidate sinks of destination dst
+   */
+  uint32_t GetCandidateCount (Ipv4Address dst) const;
+  /**
+   * Record that a message of sink arrived: the sink is alive.
+   * If the sink had been invalidated, the entries of its shard are dropped.
+   * \param sink the sink address
+   * \param iface the interface the sink is reached through
+   */
+  void NotifySinkAlive (Ipv4Address sink, Ipv4InterfaceAddress iface);
+  /**
+   * Declare sink dead: all the destinations behind it move to their other candidate sinks
+   * \param sink the sink address
+   * \return false if the sink is unknown
+   */
+  bool InvalidateSink (Ipv4Address sink);
+  /**
+   * \param sink the sink address
+   * \returns true if sink is known and alive
+   */
+  bool IsSinkAlive (Ipv4Address sink) const;
+  /**
+   * Account a downlink packet sent through sink, for the LEAST_LOADED policy
+   * \param sink the sink address
+   */
+  void NotifyForwarded (Ipv4Address sink);
+  /**
+   * \param sink the sink address
+   * \returns the recent downlink load of sink, in packets (decayed with the load half life)
+   */
+  double GetSinkLoad (Ipv4Address sink) const;
+  /**
+   * Invalidate the sinks reached through interface iface
+   * \param iface the interface IP address
+   */
+  void DeleteAllRoutesFromInterface (Ipv4InterfaceAddress iface);
+  /// Delete all entries from routing table
+  void Clear ();
+  /// Delete all outdated entries and the shards of the dead sinks
+  void Purge ();
+  /**
+   * Print routing table
+   * \param stream the output stream
+   */
+  void Print (Ptr<OutputStreamWrapper> stream) const;
+
+  /**
+   * Set the sink selection policy
+   * \param selection the policy
+   */
+  void SetSinkSelection (SinkSelection selection)
+  {
+    m_sinkSelection = selection;
+  }
+  /**
+   * Get the sink selection policy
+   * \returns the policy
+   */
+  SinkSelection GetSinkSelection () const
+  {
+    return m_sinkSelection;
+  }
+  /**
+   * Set the maximum number of candidate sinks per destination
+   * \param n the maximum number
+   */
+  void SetMaxCandidates (uint32_t n)
+  {
+    m_maxCandidates = n;
+  }
+  /**
+   * Set the half life of the sink load
+   * \param t the half life
+   */
+  void SetLoadHalfLife (Time t)
+  {
+    m_loadHalfLife = t;
+  }
+  /**
+   * Set the time without any message after which a sink is dead (zero: never)
+   * \param t the dead interval
+   */
+  void SetSinkDeadInterval (Time t)
+  {
+    m_sinkDeadInterval = t;
+  }
+
+private:
+  /// The entries learned through one sink
+  struct Shard
+  {
+    bool m_alive;                   ///< false once the sink has been invalidated
+    Time m_lastSeen;                ///< arrival time of the last message of the sink
+    Ipv4InterfaceAddress m_iface;   ///< interface the sink is reached through
+    std::map<Ipv4Address, RoutingTableEntryDown> m_entries;  ///< destination -> entry
+  };
+  /// Shards: sink -> entries
+  std::map<Ipv4Address, Shard> m_shards;
+  /// Index: destination -> sinks it was heard through
+  std::map<Ipv4Address, std::set<Ipv4Address> > m_index;
+  /// Recent downlink load of a sink
+  struct SinkLoad
+  {
+    double m_load;      ///< packets, decayed
+    Time m_lastUpdate;  ///< time of the last decay
+  };
+  /// Recent downlink load per sink
+  std::map<Ipv4Address, SinkLoad> m_sinkLoad;
+  /// Sink selection policy
+  SinkSelection m_sinkSelection;
+  /// Maximum number of candidate sinks per destination
+  uint32_t m_maxCandidates;
+  /// Half life of the sink load
+  Time m_loadHalfLife;
+  /// Time without any message after which a sink is dead
+  Time m_sinkDeadInterval;
+
+  /**
+   * \param shard the shard of a sink
+   * \returns true if the sink is alive
+   */
+  bool IsAlive (Shard const & shard) const;
+  /**
+   * Gather the valid candidate entries of dst: not expired, through a sink alive
+   * \param dst destination address
+   * \param candidates sink -> entry
+   */
+  void GetCandidates (Ipv4Address dst, std::map<Ipv4Address, RoutingTableEntryDown> & candidates) const;
+  /**
+   * \param a candidate entry
+   * \param b candidate entry
+   * \returns true if a was learned from a newer advertise than b
+   */
+  static bool IsFresher (RoutingTableEntryDown const & a, RoutingTableEntryDown const & b);
+  /**
+   * Select the entry of a set of candidates according to the sink selection policy
+   * \param candidates the candidate entries of a destination, none expired
+   * \param rt the selected entry
+   * \return false if there is no candidate
+   */
+  bool SelectSink (std::map<Ipv4Address, RoutingTableEntryDown> const & candidates, RoutingTableEntryDown & rt) const;
+};
+
+
 
 
 
@@ -695,6 +1251,23 @@ public:
 
   bool UpdateLifeTimeEntry (RoutingTableEntryDown & rt, Time lt) ;  // added by DMS
 
+  /**
+   * Lookup routing entries going down through next hop nextHop
+   * \param nextHop the next hop IP address
+   * \param unreachable the unreachable destinations and their sequence numbers
+   */
+  void GetListOfDestinationWithNextHop (Ipv4Address nextHop, std::map<Ipv4Address, uint32_t> & unreachable);
+  /**
+   * Lookup the neighbors used as next hop by the routing entries going down (the children of this node)
+   * \param children the next hops, loopback and broadcast routes excluded
+   */
+  void GetChildren (std::set<Ipv4Address> & children);
+  /**
+   * Lookup the destinations of the valid routing entries (the subtree of this node)
+   * \param destinations the destinations, loopback and broadcast routes excluded
+   */
+  void GetDestinations (std::set<Ipv4Address> & destinations);
+
   /**
    * Delete all route from interface with address iface
    * \param iface the interface IP address
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-server-set.h"
+#include "ns3/log.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpServerSet");
+
+namespace dmsrp {
+
+ServerSet::ServerSet (Time deadInterval)
+  : m_deadInterval (deadInterval)
+{
+}
+
+void
+ServerSet::Add (Ipv4Address server)
+{
+  NS_LOG_FUNCTION (this << server);
+  Server s;
+  s.m_lastReply = Simulator::Now ();
+  s.m_alive = true;
+  s.m_overloaded = false;
+  m_servers[server] = s;
+}
+
+bool
+ServerSet::Contains (Ipv4Address server) const
+{
+  return m_servers.find (server) != m_servers.end ();
+}
+
+void
+ServerSet::GetServers (std::vector<Ipv4Address> & servers) const
+{
+  servers.clear ();
+  for (std::map<Ipv4Address, Server>::const_iterator i = m_servers.begin (); i != m_servers.end (); ++i)
+    {
+      servers.push_back (i->first);
+    }
+}
+
+void
+ServerSet::GetAlive (std::vector<Ipv4Address> & servers) const
+{
+  servers.clear ();
+  for (std::map<Ipv4Address, Server>::const_iterator i = m_servers.begin (); i != m_servers.end (); ++i)
+    {
+      if (i->second.m_alive)
+        {
+          servers.push_back (i->first);
+        }
+    }
+}
+
+bool
+ServerSet::NotifyReply (Ipv4Address server, bool overloaded)
+{
+  NS_LOG_FUNCTION (this << server << overloaded);
+  std::map<Ipv4Address, Server>::iterator i = m_servers.find (server);
+  if (i == m_servers.end ())
+    {
+      return false;
+    }
+  bool revived = !i->second.m_alive;
+  i->second.m_lastReply = Simulator::Now ();
+  i->second.m_alive = true;
+  i->second.m_overloaded = overloaded;
+  return revived;
+}
+
+void
+ServerSet::Refresh (std::vector<Ipv4Address> & died)
+{
+  died.clear ();
+  for (std::map<Ipv4Address, Server>::iterator i = m_servers.begin (); i != m_servers.end (); ++i)
+    {
+      if (i->second.m_alive && Simulator::Now () - i->second.m_lastReply > m_deadInterval)
+        {
+          NS_LOG_LOGIC ("Server " << i->first << " silent since " << i->second.m_lastReply.As (Time::S));
+          i->second.m_alive = false;
+          died.push_back (i->first);
+        }
+    }
+}
+
+bool
+ServerSet::Select (uint32_t key, Ipv4Address & server) const
+{
+  bool found = false;
+  bool foundOverloaded = false;
+  uint32_t best = 0;
+  for (std::map<Ipv4Address, Server>::const_iterator i = m_servers.begin (); i != m_servers.end (); ++i)
+    {
+      if (!i->second.m_alive)
+        {
+          continue;
+        }
+      uint32_t score = Score (key, i->first);
+      // a server with room beats an overloaded one whatever the scores
+      if (!found || (foundOverloaded && !i->second.m_overloaded)
+          || (foundOverloaded == i->second.m_overloaded && score > best))
+        {
+          found = true;
+          foundOverloaded = i->second.m_overloaded;
+          best = score;
+          server = i->first;
+        }
+    }
+  return found;
+}
+
+uint32_t
+ServerSet::Score (uint32_t key, Ipv4Address server)
+{
+  // integer mix of the pair (32-bit finalizer of MurmurHash3)
+  uint32_t h = key ^ (server.Get () * 0x9e3779b1);
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
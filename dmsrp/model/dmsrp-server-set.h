@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPSERVERSET_H
+#define DMSRPSERVERSET_H
+
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief The servers of a sink, with their health
+ *
+ * A server is alive while it answered a probe within the dead interval, and is
+ * overloaded when its last reply said so. A flow is mapped on the alive servers by
+ * rendezvous hashing: each server scores the flow key and the best score wins, so
+ * losing a server moves only the flows it had, and getting it back moves them back.
+ * Overloaded servers are only used when every alive server is overloaded.
+ */
+class ServerSet
+{
+public:
+  /**
+   * constructor
+   * \param deadInterval time without reply after which a server is dead
+   */
+  ServerSet (Time deadInterval = Seconds (3));
+
+  /**
+   * Add a server, alive until it fails to answer
+   * \param server the server address
+   */
+  void Add (Ipv4Address server);
+  /**
+   * \param server the server address
+   * \returns true if the server belongs to the set
+   */
+  bool Contains (Ipv4Address server) const;
+  /**
+   * \returns the number of servers, alive or not
+   */
+  uint32_t GetSize () const
+  {
+    return m_servers.size ();
+  }
+  /**
+   * \param servers the addresses of all the servers
+   */
+  void GetServers (std::vector<Ipv4Address> & servers) const;
+  /**
+   * \param servers the addresses of the alive servers
+   */
+  void GetAlive (std::vector<Ipv4Address> & servers) const;
+  /**
+   * Record a probe reply
+   * \param server the server which replied
+   * \param overloaded whether the server said it is above its capacity
+   * \returns true if the server was dead
+   */
+  bool NotifyReply (Ipv4Address server, bool overloaded);
+  /**
+   * Mark dead the servers silent for longer than the dead interval
+   * \param died the servers which died since the last call
+   */
+  void Refresh (std::vector<Ipv4Address> & died);
+  /**
+   * Map a flow on a server
+   * \param key the flow key
+   * \param server the selected server
+   * \returns false if no server is alive
+   */
+  bool Select (uint32_t key, Ipv4Address & server) const;
+  /**
+   * \param t time without reply after which a server is dead
+   */
+  void SetDeadInterval (Time t)
+  {
+    m_deadInterval = t;
+  }
+  /// Delete every server
+  void Clear ()
+  {
+    m_servers.clear ();
+  }
+
+private:
+  /// Health of a server
+  struct Server
+  {
+    Time m_lastReply;   ///< last probe reply, or the time the server was added
+    bool m_alive;       ///< answered within the dead interval
+    bool m_overloaded;  ///< said so in its last reply
+  };
+  /// Score of a server for a flow key
+  static uint32_t Score (uint32_t key, Ipv4Address server);
+  /// Servers: address -> health
+  std::map<Ipv4Address, Server> m_servers;
+  /// Time without reply after which a server is dead
+  Time m_deadInterval;
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPSERVERSET_H */
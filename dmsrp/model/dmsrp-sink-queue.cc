@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-sink-queue.h"
+#include "ns3/log.h"
+#include <cmath>
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpSinkQueue");
+
+namespace dmsrp {
+
+SinkQueue::SinkQueue ()
+  : m_size (0),
+    m_limit (1000),
+    m_quantum (1500),
+    m_target (MilliSeconds (5)),
+    m_interval (MilliSeconds (100))
+{
+}
+
+void
+SinkQueue::Enqueue (Ipv4Address origin, Item const & item)
+{
+  NS_LOG_FUNCTION (this << origin << item.m_packet->GetSize ());
+  std::map<Ipv4Address, Flow>::iterator i = m_flows.find (origin);
+  if (i == m_flows.end ())
+    {
+      Expire ();
+      Flow flow;
+      flow.m_bytes = 0;
+      flow.m_deficit = m_quantum;
+      flow.m_dropping = false;
+      flow.m_count = 0;
+      flow.m_lastCount = 0;
+      flow.m_firstAboveTime = Seconds (0);
+      flow.m_dropNext = Seconds (0);
+      flow.m_idleSince = Seconds (0);
+      i = m_flows.insert (std::make_pair (origin, flow)).first;
+    }
+  if (i->second.m_items.empty ())
+    {
+      // back in the round, with the CoDel state it left with
+      i->second.m_deficit = m_quantum;
+      m_active.push_back (origin);
+    }
+  i->second.m_items.push_back (item);
+  i->second.m_bytes += item.m_packet->GetSize ();
+  m_size++;
+
+  if (m_size > m_limit)
+    {
+      // full: the longest flow pays
+      std::map<Ipv4Address, Flow>::iterator fattest = m_flows.begin ();
+      for (std::map<Ipv4Address, Flow>::iterator j = m_flows.begin (); j != m_flows.end (); ++j)
+        {
+          if (j->second.m_bytes > fattest->second.m_bytes)
+            {
+              fattest = j;
+            }
+        }
+      Drop (fattest->first, Pop (fattest->second));
+      if (fattest->second.m_items.empty ())
+        {
+          m_active.remove (fattest->first);
+          fattest->second.m_idleSince = Simulator::Now ();
+        }
+    }
+}
+
+bool
+SinkQueue::Dequeue (Item & item)
+{
+  while (!m_active.empty ())
+    {
+      Ipv4Address origin = m_active.front ();
+      std::map<Ipv4Address, Flow>::iterator i = m_flows.find (origin);
+      NS_ASSERT (i != m_flows.end ());
+      Flow & flow = i->second;
+      if (flow.m_deficit <= 0)
+        {
+          flow.m_deficit += m_quantum;
+          m_active.pop_front ();
+          m_active.push_back (origin);
+          continue;
+        }
+      bool found = DequeueFromFlow (origin, flow, item);
+      if (found)
+        {
+          flow.m_deficit -= item.m_packet->GetSize ();
+        }
+      if (flow.m_items.empty ())
+        {
+          m_active.pop_front ();
+          flow.m_idleSince = Simulator::Now ();
+        }
+      if (found)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+SinkQueue::Clear ()
+{
+  m_flows.clear ();
+  m_active.clear ();
+  m_size = 0;
+}
+
+void
+SinkQueue::Expire ()
+{
+  // past this idle time, a flow would not reuse its drop rate anyway
+  Time timeout = m_interval * 16;
+  for (std::map<Ipv4Address, Flow>::iterator i = m_flows.begin (); i != m_flows.end (); )
+    {
+      if (i->second.m_items.empty () && Simulator::Now () - i->second.m_idleSince > timeout)
+        {
+          m_flows.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+SinkQueue::Item
+SinkQueue::Pop (Flow & flow)
+{
+  Item item = flow.m_items.front ();
+  flow.m_items.pop_front ();
+  flow.m_bytes -= item.m_packet->GetSize ();
+  m_size--;
+  return item;
+}
+
+bool
+SinkQueue::ShouldDrop (Flow & flow, Item const & item)
+{
+  Time now = Simulator::Now ();
+  if (now - item.m_enqueued < m_target || flow.m_bytes <= m_quantum)
+    {
+      // below target, or less than a packet left behind it: no standing queue
+      flow.m_firstAboveTime = Seconds (0);
+      return false;
+    }
+  if (flow.m_firstAboveTime == Seconds (0))
+    {
+      flow.m_firstAboveTime = now + m_interval;
+      return false;
+    }
+  return now >= flow.m_firstAboveTime;
+}
+
+bool
+SinkQueue::DequeueFromFlow (Ipv4Address origin, Flow & flow, Item & item)
+{
+  if (flow.m_items.empty ())
+    {
+      return false;
+    }
+  Time now = Simulator::Now ();
+  item = Pop (flow);
+  bool okToDrop = ShouldDrop (flow, item);
+  if (flow.m_dropping)
+    {
+      if (!okToDrop)
+        {
+          flow.m_dropping = false;
+        }
+      while (flow.m_dropping && now >= flow.m_dropNext)
+        {
+          Drop (origin, item);
+          flow.m_count++;
+          if (flow.m_items.empty ())
+            {
+              flow.m_dropping = false;
+              return false;
+            }
+          item = Pop (flow);
+          if (!ShouldDrop (flow, item))
+            {
+              flow.m_dropping = false;
+            }
+          else
+            {
+              flow.m_dropNext = ControlLaw (flow.m_dropNext, flow.m_count);
+            }
+        }
+    }
+  else if (okToDrop)
+    {
+      Drop (origin, item);
+      if (flow.m_items.empty ())
+        {
+          return false;
+        }
+      item = Pop (flow);
+      ShouldDrop (flow, item);
+      flow.m_dropping = true;
+      // start again near the drop rate that controlled the queue last time
+      uint32_t delta = flow.m_count - flow.m_lastCount;
+      flow.m_count = (delta > 1 && now - flow.m_dropNext < m_interval * 16) ? delta : 1;
+      flow.m_dropNext = ControlLaw (now, flow.m_count);
+      flow.m_lastCount = flow.m_count;
+    }
+  return true;
+}
+
+void
+SinkQueue::Drop (Ipv4Address origin, Item const & item)
+{
+  NS_LOG_LOGIC ("Drop packet " << item.m_packet->GetUid () << " of " << origin);
+  if (!m_dropCallback.IsNull ())
+    {
+      m_dropCallback (origin, Simulator::Now () - item.m_enqueued);
+    }
+}
+
+Time
+SinkQueue::ControlLaw (Time t, uint32_t count) const
+{
+  return t + Seconds (m_interval.GetSeconds () / std::sqrt ((double) count));
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
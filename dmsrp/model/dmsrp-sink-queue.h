@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPSINKQUEUE_H
+#define DMSRPSINKQUEUE_H
+
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/packet.h"
+#include "ns3/callback.h"
+#include <list>
+#include <map>
+#include <deque>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Queue of the packets a sink tunnels to the server
+ *
+ * The packets are kept in one flow per origin, served by deficit round robin so
+ * that a busy branch cannot starve the others. Each flow runs CoDel: once the
+ * sojourn time of its packets stays above Target for Interval, packets are dropped
+ * at dequeue, more and more often, until it comes back below. The CoDel state of
+ * an origin outlives its packets, so that a bursty origin resumes near the drop
+ * rate it left with; it is forgotten after 16 intervals without packets. When the
+ * queue is full, the head of the longest flow is dropped. The queue does not pace itself;
+ * the routing protocol dequeues at the rate of the uplink.
+ */
+class SinkQueue
+{
+public:
+  /// A tunnelled packet waiting for the uplink
+  struct Item
+  {
+    Ptr<Ipv4Route> m_route;                                   ///< route to the server
+    Ptr<Packet> m_packet;                                     ///< packet, inner IP header included
+    Ipv4Header m_header;                                      ///< tunnel IP header
+    Ipv4RoutingProtocol::UnicastForwardCallback m_ucb;        ///< forward callback
+    Time m_enqueued;                                          ///< time of arrival in the queue
+  };
+
+  /// constructor
+  SinkQueue ();
+
+  /**
+   * Add a packet
+   * \param origin the origin of the packet (its flow)
+   * \param item the packet
+   */
+  void Enqueue (Ipv4Address origin, Item const & item);
+  /**
+   * Take the next packet to send, dropping the ones CoDel rejects on the way
+   * \param item the packet
+   * \returns false if the queue is empty
+   */
+  bool Dequeue (Item & item);
+  /**
+   * \returns the number of packets in the queue
+   */
+  uint32_t GetSize () const
+  {
+    return m_size;
+  }
+  /**
+   * \returns true if no packet is queued
+   */
+  bool IsEmpty () const
+  {
+    return m_size == 0;
+  }
+  /// Drop every packet without reporting it
+  void Clear ();
+  /**
+   * \param target the acceptable sojourn time
+   * \param interval the time the sojourn time may stay above target before dropping
+   */
+  void SetCodel (Time target, Time interval)
+  {
+    m_target = target;
+    m_interval = interval;
+  }
+  /// \param limit the maximum number of packets in the queue
+  void SetLimit (uint32_t limit)
+  {
+    m_limit = limit;
+  }
+  /// \param quantum the bytes a flow may send per round
+  void SetQuantum (uint32_t quantum)
+  {
+    m_quantum = quantum;
+  }
+  /**
+   * Callback called for each dropped packet, with its origin and its sojourn time
+   * \param cb the callback
+   */
+  void SetDropCallback (Callback<void, Ipv4Address, Time> cb)
+  {
+    m_dropCallback = cb;
+  }
+
+private:
+  /// Packets of one origin and their CoDel state
+  struct Flow
+  {
+    std::deque<Item> m_items;     ///< packets
+    uint32_t m_bytes;             ///< bytes queued
+    int32_t m_deficit;            ///< bytes the flow may still send in this round
+    bool m_dropping;              ///< CoDel dropping state
+    uint32_t m_count;             ///< drops since entering the dropping state
+    uint32_t m_lastCount;         ///< m_count when the dropping state was last left
+    Time m_firstAboveTime;        ///< when the sojourn time will have been above target for an interval (0: below)
+    Time m_dropNext;              ///< next drop in the dropping state
+    Time m_idleSince;             ///< when the flow ran out of packets
+  };
+
+  /// Forget the CoDel state of the flows idle for too long
+  void Expire ();
+  /**
+   * Remove the head of a flow
+   * \param flow the flow
+   * \returns the head
+   */
+  Item Pop (Flow & flow);
+  /**
+   * CoDel: check the sojourn time of a packet just taken from a flow
+   * \returns true if the packet may be dropped
+   */
+  bool ShouldDrop (Flow & flow, Item const & item);
+  /**
+   * CoDel dequeue from one flow
+   * \returns false if every packet of the flow was dropped
+   */
+  bool DequeueFromFlow (Ipv4Address origin, Flow & flow, Item & item);
+  /// Report a dropped packet
+  void Drop (Ipv4Address origin, Item const & item);
+  /// \returns the next drop time of the CoDel control law
+  Time ControlLaw (Time t, uint32_t count) const;
+
+  std::map<Ipv4Address, Flow> m_flows;  ///< flows, with packets or recently idle: origin -> flow
+  std::list<Ipv4Address> m_active;      ///< round robin order of the flows with packets
+  uint32_t m_size;                      ///< packets queued
+  uint32_t m_limit;                     ///< maximum number of packets
+  uint32_t m_quantum;                   ///< bytes per flow and round
+  Time m_target;                        ///< CoDel target
+  Time m_interval;                      ///< CoDel interval
+  Callback<void, Ipv4Address, Time> m_dropCallback;  ///< drop callback
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPSINKQUEUE_H */
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+
+#include "dmsrp-topology.h"
+#include "ns3/log.h"
+#include <limits>
+#include <queue>
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmsrpTopology");
+
+namespace dmsrp {
+
+TopologyDatabase::TopologyDatabase ()
+{
+}
+
+void
+TopologyDatabase::AddSink (Ipv4Address sink, Time lifetime)
+{
+  NS_LOG_FUNCTION (this << sink);
+  m_sinks[sink] = Simulator::Now () + lifetime;
+}
+
+void
+TopologyDatabase::Update (Ipv4Address node, TopologyReport const & report, Time lifetime)
+{
+  NS_LOG_FUNCTION (this << node);
+  Node & n = m_nodes[node];
+  n.m_energy = report.GetEnergy ();
+  n.m_parents.clear ();
+  for (uint8_t i = 0; i < report.GetLinkCount (); ++i)
+    {
+      n.m_parents.push_back (report.GetParent (i));
+    }
+  n.m_expire = Simulator::Now () + lifetime;
+}
+
+uint32_t
+TopologyDatabase::GetNodeCount ()
+{
+  Purge ();
+  return m_nodes.size ();
+}
+
+void
+TopologyDatabase::Purge ()
+{
+  for (std::map<Ipv4Address, Node>::iterator i = m_nodes.begin (); i != m_nodes.end (); )
+    {
+      if (i->second.m_expire < Simulator::Now ())
+        {
+          m_nodes.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  for (std::map<Ipv4Address, Time>::iterator i = m_sinks.begin (); i != m_sinks.end (); )
+    {
+      if (i->second < Simulator::Now ())
+        {
+          m_sinks.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+TopologyDatabase::Clear ()
+{
+  m_nodes.clear ();
+  m_sinks.clear ();
+}
+
+void
+TopologyDatabase::ComputeParents (std::map<Ipv4Address, Ipv4Address> & parents)
+{
+  NS_LOG_FUNCTION (this);
+  Purge ();
+  parents.clear ();
+
+  // the reports give child -> parent links, the search goes from the sinks down
+  std::map<Ipv4Address, std::vector<Ipv4Address> > children;
+  for (std::map<Ipv4Address, Node>::const_iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+    {
+      for (std::vector<Ipv4Address>::const_iterator j = i->second.m_parents.begin (); j != i->second.m_parents.end (); ++j)
+        {
+          children[*j].push_back (i->first);
+        }
+    }
+
+  // widest path: the label of a node is the lowest residual energy on its path to a sink
+  // and the hop count of this path, stored negated: the larger label is the better one
+  typedef std::pair<float, int> Label;
+  typedef std::pair<Label, Ipv4Address> QueueItem;
+  std::map<Ipv4Address, Label> best;
+  std::priority_queue<QueueItem> queue;
+  for (std::map<Ipv4Address, Time>::const_iterator i = m_sinks.begin (); i != m_sinks.end (); ++i)
+    {
+      Label label (std::numeric_limits<float>::max (), 0);
+      best[i->first] = label;
+      queue.push (QueueItem (label, i->first));
+    }
+  while (!queue.empty ())
+    {
+      QueueItem item = queue.top ();
+      queue.pop ();
+      if (best[item.second] != item.first)
+        {
+          continue;  // outdated
+        }
+      std::map<Ipv4Address, std::vector<Ipv4Address> >::const_iterator c = children.find (item.second);
+      if (c == children.end ())
+        {
+          continue;
+        }
+      for (std::vector<Ipv4Address>::const_iterator j = c->second.begin (); j != c->second.end (); ++j)
+        {
+          if (m_sinks.find (*j) != m_sinks.end ())
+            {
+              continue;
+            }
+          Label label (std::min (item.first.first, m_nodes[*j].m_energy), item.first.second - 1);
+          std::map<Ipv4Address, Label>::iterator known = best.find (*j);
+          if (known == best.end () || known->second < label)
+            {
+              best[*j] = label;
+              parents[*j] = item.second;
+              queue.push (QueueItem (label, *j));
+            }
+        }
+    }
+  NS_LOG_LOGIC ("Parents computed for " << parents.size () << " nodes out of " << m_nodes.size ());
+}
+
+}  // namespace dmsrp
+}  // namespace ns3
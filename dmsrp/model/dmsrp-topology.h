@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2023
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ *
+ * Authors: Mohamed Skander DAAS <daas.skander@umc.edu.dz>
+ */
+#ifndef DMSRPTOPOLOGY_H
+#define DMSRPTOPOLOGY_H
+
+#include "dmsrp-packet.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-address.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace dmsrp {
+
+/**
+ * \ingroup dmsrp
+ * \brief Topology of the wireless network, built by the server from the topology reports
+ *
+ * Every node reports its residual energy and its parents; the sinks are the roots.
+ * From this graph the server computes, for every node, the parent that maximizes the
+ * lowest residual energy met on the way to a sink (widest path), fewer hops breaking
+ * the ties. The resulting tree spares the nodes that are about to deplete, which the
+ * greedy choice of each node cannot do.
+ */
+class TopologyDatabase
+{
+public:
+  /// constructor
+  TopologyDatabase ();
+
+  /**
+   * Add or refresh a sink (a root of the graph)
+   * \param sink the wireless address of the sink
+   * \param lifetime how long the sink is kept without refresh
+   */
+  void AddSink (Ipv4Address sink, Time lifetime);
+  /**
+   * Add or replace the report of a node
+   * \param node the node address
+   * \param report the topology report of the node
+   * \param lifetime how long the report is kept without refresh
+   */
+  void Update (Ipv4Address node, TopologyReport const & report, Time lifetime);
+  /**
+   * Compute the parent of every node reachable from a sink
+   * \param parents node -> assigned parent
+   */
+  void ComputeParents (std::map<Ipv4Address, Ipv4Address> & parents);
+  /**
+   * \returns the number of nodes with a valid report
+   */
+  uint32_t GetNodeCount ();
+  /// Delete the outdated reports and sinks
+  void Purge ();
+  /// Delete everything
+  void Clear ();
+
+private:
+  /// What a node reported
+  struct Node
+  {
+    float m_energy;                     ///< residual energy
+    std::vector<Ipv4Address> m_parents; ///< parents of the node
+    Time m_expire;                      ///< end of validity of the report
+  };
+  /// Reports: node -> report
+  std::map<Ipv4Address, Node> m_nodes;
+  /// Sinks: sink -> end of validity
+  std::map<Ipv4Address, Time> m_sinks;
+};
+
+}  // namespace dmsrp
+}  // namespace ns3
+
+#endif /* DMSRPTOPOLOGY_H */
@@ -5,6 +5,8 @@
 
 // An essential include is test.h
 #include "ns3/test.h"
+#include "ns3/packet.h"
+#include <cmath>
 
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
@@ -46,6 +48,1399 @@ DmsrpTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Check that a RERR survives serialization and that destinations are
+// handed back one by one
+class DmsrpRerrHeaderTestCase : public TestCase
+{
+public:
+  DmsrpRerrHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpRerrHeaderTestCase::DmsrpRerrHeaderTestCase ()
+  : TestCase ("Dmsrp RERR header serialization")
+{
+}
+
+void
+DmsrpRerrHeaderTestCase::DoRun (void)
+{
+  dmsrp::RerrHeader h;
+  NS_TEST_EXPECT_MSG_EQ (h.GetDestCount (), 0, "New RERR is empty");
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 3, "Empty RERR size");
+  NS_TEST_EXPECT_MSG_EQ (h.AddUnDestination (Ipv4Address ("10.1.0.7"), 12), true, "Add first destination");
+  NS_TEST_EXPECT_MSG_EQ (h.AddUnDestination (Ipv4Address ("10.1.0.9"), 0), true, "Add second destination");
+  NS_TEST_EXPECT_MSG_EQ (h.AddUnDestination (Ipv4Address ("10.1.0.7"), 12), true, "Duplicates are ignored");
+  NS_TEST_EXPECT_MSG_EQ (h.GetDestCount (), 2, "Two destinations");
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 19, "RERR size with two destinations");
+
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h);
+  dmsrp::RerrHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19, "RERR is correctly deserialized");
+  NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+
+  std::pair<Ipv4Address, uint32_t> un;
+  NS_TEST_EXPECT_MSG_EQ (h2.RemoveUnDestination (un), true, "Remove first destination");
+  NS_TEST_EXPECT_MSG_EQ (un.first, Ipv4Address ("10.1.0.7"), "First destination address");
+  NS_TEST_EXPECT_MSG_EQ (un.second, 12, "First destination sequence number");
+  NS_TEST_EXPECT_MSG_EQ (h2.RemoveUnDestination (un), true, "Remove second destination");
+  NS_TEST_EXPECT_MSG_EQ (h2.RemoveUnDestination (un), false, "No destination left");
+}
+
+// Check that both piggybacked records survive serialization
+class DmsrpPiggybackHeaderTestCase : public TestCase
+{
+public:
+  DmsrpPiggybackHeaderTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpPiggybackHeaderTestCase::DmsrpPiggybackHeaderTestCase ()
+  : TestCase ("Dmsrp piggyback option serialization")
+{
+}
+
+void
+DmsrpPiggybackHeaderTestCase::DoRun (void)
+{
+  dmsrp::PiggybackHeader h (17, Ipv4Address ("10.1.0.4"));
+  h.SetAdvertise (dmsrp::AdvertiseHeader (2, 0, Ipv4Address ("10.1.0.8"), 42));
+  NS_TEST_EXPECT_MSG_EQ (h.HasAdvertise (), true, "Advertise record is carried");
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 12, "Option size with an advertise record");
+
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h);
+  dmsrp::PiggybackHeader h2;
+  NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h2), 12, "Option is correctly deserialized");
+  NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetNextHeader (), 17, "Next header");
+  dmsrp::AdvertiseHeader advertise = h2.GetAdvertise (Ipv4Address ("10.1.0.8"));
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) advertise.GetHopCount (), 2, "Advertise hop count");
+  NS_TEST_EXPECT_MSG_EQ (advertise.GetOriginSeqno (), 42, "Advertise sequence number");
+
+  h.SetHello (dmsrp::HelloHeader (3, 0, 5.5, 12.25, Ipv4Address ("10.1.0.2"), 7));
+  NS_TEST_EXPECT_MSG_EQ (h.HasAdvertise (), false, "Only one record is carried");
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 24, "Option size with a Hello record");
+  p->AddHeader (h);
+  NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h2), 24, "Option is correctly deserialized");
+  NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+  dmsrp::HelloHeader hello = h2.GetHello ();
+  NS_TEST_EXPECT_MSG_EQ (hello.GetOrigin (), Ipv4Address ("10.1.0.2"), "Hello sink");
+  NS_TEST_EXPECT_MSG_EQ (hello.GetMinSnr (), 12.25, "Hello min snr");
+}
+
+// Check that a Hello carries the routes to the other sinks
+class DmsrpMultiSinkHelloTestCase : public TestCase
+{
+public:
+  DmsrpMultiSinkHelloTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpMultiSinkHelloTestCase::DmsrpMultiSinkHelloTestCase ()
+  : TestCase ("Dmsrp multi-sink Hello serialization")
+{
+}
+
+void
+DmsrpMultiSinkHelloTestCase::DoRun (void)
+{
+  dmsrp::HelloHeader h (1, 0, 10.0, 20.0, Ipv4Address ("10.1.0.2"), 5);
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 19, "Hello size without other sinks");
+  NS_TEST_EXPECT_MSG_EQ (h.AddSinkRecord (dmsrp::HelloHeader (3, 0, 8.0, 15.5, Ipv4Address ("10.1.0.3"), 9)), true, "Add second sink");
+  NS_TEST_EXPECT_MSG_EQ (h.AddSinkRecord (dmsrp::HelloHeader (2, 0, 8.0, 15.5, Ipv4Address ("10.1.0.3"), 9)), false, "A sink is described once");
+  NS_TEST_EXPECT_MSG_EQ (h.AddSinkRecord (dmsrp::HelloHeader (2, 0, 8.0, 15.5, Ipv4Address ("10.1.0.2"), 9)), false, "The sink in use is not repeated");
+  NS_TEST_EXPECT_MSG_EQ (h.GetSinkCount (), 1, "One other sink");
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 36, "Hello size with one other sink");
+
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h);
+  dmsrp::HelloHeader h2;
+  NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h2), 36, "Hello is correctly deserialized");
+  NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+  dmsrp::HelloHeader record = h2.GetSinkRecord (0);
+  NS_TEST_EXPECT_MSG_EQ (record.GetOrigin (), Ipv4Address ("10.1.0.3"), "Other sink address");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) record.GetHopCount (), 3, "Other sink hop count");
+  NS_TEST_EXPECT_MSG_EQ (record.GetOriginSeqno (), 9, "Other sink sequence number");
+
+  // a child re-advertising the route of this node has one more hop
+  Ipv4Address sink ("10.1.0.3");
+  dmsrp::RoutingTableUp table;
+  dmsrp::RoutingTableEntryUp viaParent (0, sink, 9, Ipv4InterfaceAddress (), 4, Ipv4Address ("10.1.0.4"), Seconds (10));
+  dmsrp::RoutingTableEntryUp viaChild (0, sink, 9, Ipv4InterfaceAddress (), 5, Ipv4Address ("10.1.0.5"), Seconds (10));
+  dmsrp::RoutingTableEntryUp fresher (0, sink, 10, Ipv4InterfaceAddress (), 6, Ipv4Address ("10.1.0.6"), Seconds (10));
+  NS_TEST_EXPECT_MSG_EQ (table.AddSinkRoute (viaParent), true, "First route to the sink");
+  NS_TEST_EXPECT_MSG_EQ (table.AddSinkRoute (viaChild), false, "More hops at the same sequence number");
+  NS_TEST_EXPECT_MSG_EQ (table.AddSinkRoute (fresher), true, "Newer sequence number");
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupSinkRoute (sink, rt), true, "Route to the sink");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), Ipv4Address ("10.1.0.6"), "The older routes are dropped");
+}
+
+// Check the selection of the downlink sink among the candidates kept by the server
+class DmsrpServerSinkSelectionTestCase : public TestCase
+{
+public:
+  DmsrpServerSinkSelectionTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpServerSinkSelectionTestCase::DmsrpServerSinkSelectionTestCase ()
+  : TestCase ("Dmsrp server sink selection")
+{
+}
+
+void
+DmsrpServerSinkSelectionTestCase::DoRun (void)
+{
+  Ipv4Address dst ("10.1.0.9");
+  Ipv4Address sinkA ("10.2.0.1");
+  Ipv4Address sinkB ("10.2.0.2");
+  Ipv4Address sinkC ("10.2.0.3");
+  dmsrp::RoutingTableServer table;
+  dmsrp::RoutingTableEntryDown a (0, dst, 5, Ipv4InterfaceAddress (), 3, sinkA, Seconds (10));
+  dmsrp::RoutingTableEntryDown b (0, dst, 4, Ipv4InterfaceAddress (), 2, sinkB, Seconds (10));
+  dmsrp::RoutingTableEntryDown c (0, dst, 6, Ipv4InterfaceAddress (), 4, sinkC, Seconds (10));
+  table.SetMaxCandidates (2);
+  NS_TEST_EXPECT_MSG_EQ (table.AddRoute (a), true, "First candidate");
+  NS_TEST_EXPECT_MSG_EQ (table.AddRoute (b), true, "Second candidate");
+  NS_TEST_EXPECT_MSG_EQ (table.AddRoute (c), true, "Fresher candidate replaces the stalest one");
+  NS_TEST_EXPECT_MSG_EQ (table.GetCandidateCount (dst), 2, "Candidate set is bounded");
+  NS_TEST_EXPECT_MSG_EQ (table.AddRoute (b), false, "Staler candidate rejected from a full set");
+  table.SetMaxCandidates (4);
+  table.AddRoute (b);
+
+  dmsrp::RoutingTableEntryDown rt;
+  table.SetSinkSelection (dmsrp::FEWEST_HOPS);
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRoute (dst, rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), sinkB, "Fewest hops");
+  table.SetSinkSelection (dmsrp::FRESHEST);
+  table.LookupRoute (dst, rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), sinkC, "Freshest");
+  table.SetSinkSelection (dmsrp::LEAST_LOADED);
+  table.NotifyForwarded (sinkB);
+  table.NotifyForwarded (sinkC);
+  table.NotifyForwarded (sinkC);
+  table.LookupRoute (dst, rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), sinkA, "Least loaded");
+
+  table.SetSinkSelection (dmsrp::FEWEST_HOPS);
+  NS_TEST_EXPECT_MSG_EQ (table.DeleteRoute (dst, sinkB), true, "Candidate removed");
+  table.LookupRoute (dst, rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), sinkA, "Next sink takes over");
+}
+
+// Check that the failure of a sink moves its destinations to the other sinks at once
+class DmsrpServerSinkFailureTestCase : public TestCase
+{
+public:
+  DmsrpServerSinkFailureTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpServerSinkFailureTestCase::DmsrpServerSinkFailureTestCase ()
+  : TestCase ("Dmsrp server sink failure")
+{
+}
+
+void
+DmsrpServerSinkFailureTestCase::DoRun (void)
+{
+  Ipv4Address dst1 ("10.1.0.9");
+  Ipv4Address dst2 ("10.1.0.10");
+  Ipv4Address sinkA ("10.2.0.1");
+  Ipv4Address sinkB ("10.2.0.2");
+  dmsrp::RoutingTableServer table;
+  dmsrp::RoutingTableEntryDown a1 (0, dst1, 5, Ipv4InterfaceAddress (), 3, sinkA, Seconds (10));
+  dmsrp::RoutingTableEntryDown b1 (0, dst1, 5, Ipv4InterfaceAddress (), 2, sinkB, Seconds (10));
+  dmsrp::RoutingTableEntryDown b2 (0, dst2, 7, Ipv4InterfaceAddress (), 1, sinkB, Seconds (10));
+  table.AddRoute (a1);
+  table.AddRoute (b1);
+  table.AddRoute (b2);
+
+  dmsrp::RoutingTableEntryDown rt;
+  table.LookupRoute (dst1, rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), sinkB, "Closest sink");
+  NS_TEST_EXPECT_MSG_EQ (table.InvalidateSink (sinkB), true, "Sink invalidated");
+  NS_TEST_EXPECT_MSG_EQ (table.IsSinkAlive (sinkB), false, "Sink is dead");
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRoute (dst1, rt), true, "Other sink still valid");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), sinkA, "Destination moved to the other sink");
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRoute (dst2, rt), false, "No route through the dead sink");
+
+  table.NotifySinkAlive (sinkB, Ipv4InterfaceAddress ());
+  NS_TEST_EXPECT_MSG_EQ (table.IsSinkAlive (sinkB), true, "Sink is back");
+  NS_TEST_EXPECT_MSG_EQ (table.GetCandidateCount (dst1), 1, "Entries of the dead sink are not trusted again");
+  table.AddRoute (b2);
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRoute (dst2, rt), true, "Shard refilled by a new advertise");
+}
+
+// Check the topology report of the advertises and the parents computed by the server
+class DmsrpTopologyTestCase : public TestCase
+{
+public:
+  DmsrpTopologyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpTopologyTestCase::DmsrpTopologyTestCase ()
+  : TestCase ("Dmsrp topology report and centralized parent computation")
+{
+}
+
+void
+DmsrpTopologyTestCase::DoRun (void)
+{
+  Ipv4Address s ("10.1.0.1");
+  Ipv4Address a ("10.1.0.2");
+  Ipv4Address b ("10.1.0.3");
+  Ipv4Address c ("10.1.0.4");
+  Ipv4Address d ("10.1.0.5");
+  Ipv4Address e ("10.1.0.6");
+
+  dmsrp::TopologyReport report;
+  report.SetEnergy (5.5);
+  NS_TEST_EXPECT_MSG_EQ (report.AddLink (a, 20.0), true, "First parent");
+  NS_TEST_EXPECT_MSG_EQ (report.AddLink (b, 12.5), true, "Second parent");
+  NS_TEST_EXPECT_MSG_EQ (report.AddLink (a, 20.0), false, "A parent is listed once");
+  dmsrp::AdvertiseHeader h (0, 0, c, 7);
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 11, "Advertise size without report");
+  h.SetReport (report);
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 31, "Advertise size with two parents");
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h);
+  dmsrp::AdvertiseHeader h2;
+  NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h2), 31, "Advertise is correctly deserialized");
+  NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetReport ().GetParent (1), b, "Second parent address");
+
+  dmsrp::TopologyDatabase topology;
+  topology.AddSink (s, Seconds (10));
+  dmsrp::TopologyReport r;
+  r.SetEnergy (10);
+  r.AddLink (s, 20);
+  topology.Update (a, r, Seconds (10));
+  r.SetEnergy (2);
+  topology.Update (b, r, Seconds (10));
+  r.Clear ();
+  r.SetEnergy (5);
+  r.AddLink (a, 20);
+  r.AddLink (b, 20);
+  topology.Update (c, r, Seconds (10));
+  r.Clear ();
+  r.SetEnergy (8);
+  r.AddLink (c, 20);
+  r.AddLink (b, 20);
+  topology.Update (d, r, Seconds (10));
+  r.Clear ();
+  r.SetEnergy (9);
+  r.AddLink (a, 20);
+  r.AddLink (s, 20);
+  topology.Update (e, r, Seconds (10));
+
+  std::map<Ipv4Address, Ipv4Address> parents;
+  topology.ComputeParents (parents);
+  NS_TEST_EXPECT_MSG_EQ (parents.size (), 5, "Every node gets a parent");
+  NS_TEST_EXPECT_MSG_EQ (parents[c], a, "The node low on energy is avoided");
+  NS_TEST_EXPECT_MSG_EQ (parents[d], c, "Widest path over two hops");
+  NS_TEST_EXPECT_MSG_EQ (parents[e], s, "Fewer hops break the ties");
+}
+
+// Check the path recorded in the advertises and the source route that follows it down
+class DmsrpSourceRouteTestCase : public TestCase
+{
+public:
+  DmsrpSourceRouteTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpSourceRouteTestCase::DmsrpSourceRouteTestCase ()
+  : TestCase ("Dmsrp advertise path and source route option")
+{
+}
+
+void
+DmsrpSourceRouteTestCase::DoRun (void)
+{
+  Ipv4Address p1 ("10.1.0.2");
+  Ipv4Address p2 ("10.1.0.3");
+  Ipv4Address p3 ("10.1.0.4");
+
+  dmsrp::AdvertiseHeader h (0, 0, Ipv4Address ("10.1.0.9"), 3);
+  h.AddRelay (p1);
+  h.AddRelay (p2);
+  h.AddRelay (p3);
+  NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 23, "Advertise size with a path of three relays");
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h);
+  dmsrp::AdvertiseHeader h2;
+  NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (h2), 23, "Advertise is correctly deserialized");
+  NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetPath ().size (), 3, "Path length");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetPath ().front (), p1, "The parent of the origin comes first");
+
+  // the sink sends to p3 and lists the other relays from the top down
+  dmsrp::SourceRouteHeader sr (17);
+  sr.AddRelay (p2);
+  sr.AddRelay (p1);
+  NS_TEST_EXPECT_MSG_EQ (sr.GetSerializedSize (), 12, "Source route size");
+  Ipv4Address relay;
+  std::vector<Ipv4Address> visited;
+  while (true)
+    {
+      p = Create<Packet> ();
+      p->AddHeader (sr);
+      dmsrp::SourceRouteHeader sr2;
+      NS_TEST_EXPECT_MSG_EQ (p->RemoveHeader (sr2), 12, "Source route is correctly deserialized");
+      NS_TEST_EXPECT_MSG_EQ (sr2, sr, "Round trip serialization works");
+      if (!sr2.NextRelay (relay))
+        {
+          break;
+        }
+      visited.push_back (relay);
+      sr = sr2;
+    }
+  NS_TEST_EXPECT_MSG_EQ (visited.size (), 2, "Every relay is visited once");
+  NS_TEST_EXPECT_MSG_EQ (visited[0], p2, "First relay");
+  NS_TEST_EXPECT_MSG_EQ (visited[1], p1, "Last relay");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) sr.GetSegmentsLeft (), 0, "No segment left at the parent of the destination");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) sr.GetNextHeader (), 17, "Next header is kept");
+}
+
+// Check the descendant filters of the Bloom downlink mode
+class DmsrpBloomFilterTestCase : public TestCase
+{
+public:
+  DmsrpBloomFilterTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpBloomFilterTestCase::DmsrpBloomFilterTestCase ()
+  : TestCase ("Dmsrp descendant Bloom filters")
+{
+}
+
+void
+DmsrpBloomFilterTestCase::DoRun (void)
+{
+  dmsrp::CountingBloomFilter filter (64, 3);
+  Ipv4Address a ("10.1.0.7");
+  Ipv4Address b ("10.1.0.8");
+  filter.Add (a);
+  filter.Add (b);
+  NS_TEST_EXPECT_MSG_EQ (filter.Contains (a), true, "No false negative");
+  filter.Remove (a);
+  NS_TEST_EXPECT_MSG_EQ (filter.Contains (b), true, "Removing an address keeps the others");
+  filter.Remove (b);
+  NS_TEST_EXPECT_MSG_EQ (filter.IsEmpty (), true, "Every address removed");
+  NS_TEST_EXPECT_MSG_EQ (filter.Contains (a), false, "A removed address is gone");
+
+  dmsrp::DescendantFilters filters (Seconds (6));
+  filters.SetFilterSize (256, 3);
+  Ipv4InterfaceAddress iface (Ipv4Address ("10.1.0.1"), Ipv4Mask ("255.255.0.0"));
+  Ipv4Address c1 ("10.1.0.2");
+  Ipv4Address c2 ("10.1.0.3");
+  filters.Update (c1, iface, c1);
+  filters.Update (c1, iface, a);
+  filters.Update (c2, iface, c2);
+  NS_TEST_EXPECT_MSG_EQ (filters.GetChildCount (), 2, "Two children");
+  Ipv4Address child;
+  Ipv4InterfaceAddress out;
+  NS_TEST_EXPECT_MSG_EQ (filters.Lookup (a, child, out), 1, "One filter holds the descendant");
+  NS_TEST_EXPECT_MSG_EQ (child, c1, "Descendant reached through the first child");
+  NS_TEST_EXPECT_MSG_EQ (filters.Lookup (a, child, out, c1), 0, "The excluded child is not selected");
+  filters.Update (c2, iface, a);
+  NS_TEST_EXPECT_MSG_EQ (filters.Lookup (a, child, out), 1, "The descendant moved");
+  NS_TEST_EXPECT_MSG_EQ (child, c2, "Descendant now reached through the second child");
+  NS_TEST_EXPECT_MSG_EQ (filters.Lookup (c1, child, out), 1, "The first child is still reachable");
+  filters.DeleteChild (c1);
+  NS_TEST_EXPECT_MSG_EQ (filters.GetChildCount (), 1, "Lost child forgotten");
+}
+
+// Check the per-origin rounds and the overflow of the sink uplink queue
+class DmsrpSinkQueueTestCase : public TestCase
+{
+public:
+  DmsrpSinkQueueTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Dropped (Ipv4Address origin, Time sojourn);
+  Ipv4Address m_dropped;
+  uint32_t m_drops;
+};
+
+DmsrpSinkQueueTestCase::DmsrpSinkQueueTestCase ()
+  : TestCase ("Dmsrp sink uplink queue"),
+    m_drops (0)
+{
+}
+
+void
+DmsrpSinkQueueTestCase::Dropped (Ipv4Address origin, Time)
+{
+  m_dropped = origin;
+  m_drops++;
+}
+
+void
+DmsrpSinkQueueTestCase::DoRun (void)
+{
+  dmsrp::SinkQueue queue;
+  queue.SetQuantum (1000);
+  queue.SetLimit (3);
+  queue.SetDropCallback (MakeCallback (&DmsrpSinkQueueTestCase::Dropped, this));
+  Ipv4Address a ("10.1.0.7");
+  Ipv4Address b ("10.1.0.8");
+  dmsrp::SinkQueue::Item item;
+  for (uint32_t i = 1; i <= 3; ++i)
+    {
+      item.m_packet = Create<Packet> (1000);
+      item.m_header.SetIdentification (i);
+      queue.Enqueue (a, item);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_drops, 0, "Room for three packets");
+  item.m_packet = Create<Packet> (1000);
+  item.m_header.SetIdentification (10);
+  queue.Enqueue (b, item);
+  NS_TEST_EXPECT_MSG_EQ (m_drops, 1, "Queue full");
+  NS_TEST_EXPECT_MSG_EQ (m_dropped, a, "The longest flow pays");
+  NS_TEST_EXPECT_MSG_EQ (queue.GetSize (), 3, "Limit kept");
+
+  uint16_t order[3] = { 2, 10, 3 };
+  for (uint32_t i = 0; i < 3; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (queue.Dequeue (item), true, "Packet left");
+      NS_TEST_EXPECT_MSG_EQ (item.m_header.GetIdentification (), order[i], "One packet per origin and round");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue.IsEmpty (), true, "Queue drained");
+  NS_TEST_EXPECT_MSG_EQ (queue.Dequeue (item), false, "Nothing left");
+}
+
+// Check the CoDel drop spacing of a flow of the sink uplink queue, across an idle gap
+class DmsrpSinkQueueCodelTestCase : public TestCase
+{
+public:
+  DmsrpSinkQueueCodelTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// A packet of the flow arrives
+  void Arrive ();
+  /// The uplink takes a packet
+  void Serve ();
+  /// A packet is dropped
+  void Dropped (Ipv4Address origin, Time sojourn);
+  dmsrp::SinkQueue m_queue;       ///< the queue
+  std::vector<Time> m_drops;      ///< drop times
+};
+
+DmsrpSinkQueueCodelTestCase::DmsrpSinkQueueCodelTestCase ()
+  : TestCase ("Dmsrp sink uplink queue CoDel drop spacing")
+{
+}
+
+void
+DmsrpSinkQueueCodelTestCase::Arrive ()
+{
+  dmsrp::SinkQueue::Item item;
+  item.m_packet = Create<Packet> (1000);
+  item.m_enqueued = Simulator::Now ();
+  m_queue.Enqueue (Ipv4Address ("10.1.0.7"), item);
+}
+
+void
+DmsrpSinkQueueCodelTestCase::Serve ()
+{
+  dmsrp::SinkQueue::Item item;
+  m_queue.Dequeue (item);
+}
+
+void
+DmsrpSinkQueueCodelTestCase::Dropped (Ipv4Address, Time)
+{
+  m_drops.push_back (Simulator::Now ());
+}
+
+void
+DmsrpSinkQueueCodelTestCase::DoRun (void)
+{
+  Time interval = MilliSeconds (100);
+  m_queue.SetCodel (MilliSeconds (5), interval);
+  m_queue.SetDropCallback (MakeCallback (&DmsrpSinkQueueCodelTestCase::Dropped, this));
+  // twice the uplink rate for 250 ms, an idle gap, then again from 600 ms
+  for (uint32_t i = 0; i < 500; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (500 * i), &DmsrpSinkQueueCodelTestCase::Arrive, this);
+      Simulator::Schedule (MicroSeconds (600000 + 500 * i), &DmsrpSinkQueueCodelTestCase::Arrive, this);
+    }
+  for (uint32_t i = 0; i < 1200; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (250 + 1000 * i), &DmsrpSinkQueueCodelTestCase::Serve, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  // the drops of the first dropping state come interval / sqrt (count) apart
+  uint32_t k = 0;
+  for (; k + 1 < m_drops.size () && m_drops[k + 1] - m_drops[k] < interval * 2; ++k)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL ((m_drops[k + 1] - m_drops[k]).GetSeconds (), interval.GetSeconds () / std::sqrt (k + 1.0), 0.001,
+                                 "Drop spacing");
+    }
+  NS_TEST_ASSERT_MSG_GT (k, 2, "The first dropping state drops several packets");
+  NS_TEST_ASSERT_MSG_LT (k + 3, m_drops.size (), "The flow drops again after it emptied");
+  // the flow emptied, then resumed the spacing of the drops it left with
+  for (uint32_t j = 0; j < 2; ++j)
+    {
+      Time spacing = m_drops[k + 2 + j] - m_drops[k + 1 + j];
+      NS_TEST_EXPECT_MSG_EQ_TOL (spacing.GetSeconds (), interval.GetSeconds () / std::sqrt (k + j + 0.0), 0.001,
+                                 "Drop spacing after the idle gap");
+    }
+}
+
+// Check the mapping of the flows on the servers of a sink
+class DmsrpServerSetTestCase : public TestCase
+{
+public:
+  DmsrpServerSetTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpServerSetTestCase::DmsrpServerSetTestCase ()
+  : TestCase ("Dmsrp servers of a sink")
+{
+}
+
+void
+DmsrpServerSetTestCase::DoRun (void)
+{
+  dmsrp::ServerSet servers;
+  Ipv4Address a ("41.110.0.1");
+  Ipv4Address b ("41.110.0.2");
+  Ipv4Address c ("41.110.0.3");
+  servers.Add (a);
+  servers.Add (b);
+  servers.Add (c);
+  NS_TEST_EXPECT_MSG_EQ (servers.GetSize (), 3, "Three servers");
+  NS_TEST_EXPECT_MSG_EQ (servers.Contains (b), true, "Known server");
+  NS_TEST_EXPECT_MSG_EQ (servers.Contains (Ipv4Address ("41.110.0.4")), false, "Unknown server");
+
+  std::map<Ipv4Address, uint32_t> flows;
+  std::vector<Ipv4Address> before (100);
+  for (uint32_t key = 0; key < 100; ++key)
+    {
+      NS_TEST_EXPECT_MSG_EQ (servers.Select (key, before[key]), true, "Every server alive");
+      flows[before[key]]++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (flows.size (), 3, "Flows spread on every server");
+
+  NS_TEST_EXPECT_MSG_EQ (servers.NotifyReply (b, true), false, "Server was alive");
+  for (uint32_t key = 0; key < 100; ++key)
+    {
+      Ipv4Address server;
+      servers.Select (key, server);
+      NS_TEST_EXPECT_MSG_NE (server, b, "Overloaded server avoided");
+      if (before[key] != b)
+        {
+          NS_TEST_EXPECT_MSG_EQ (server, before[key], "Flows of the other servers do not move");
+        }
+    }
+  servers.NotifyReply (a, true);
+  servers.NotifyReply (c, true);
+  for (uint32_t key = 0; key < 100; ++key)
+    {
+      Ipv4Address server;
+      servers.Select (key, server);
+      NS_TEST_EXPECT_MSG_EQ (server, before[key], "Every server overloaded: back to the plain mapping");
+    }
+}
+
+class DmsrpClusterTestCase : public TestCase
+{
+public:
+  DmsrpClusterTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpClusterTestCase::DmsrpClusterTestCase ()
+  : TestCase ("Dmsrp cluster summaries")
+{
+}
+
+void
+DmsrpClusterTestCase::DoRun (void)
+{
+  Ipv4Address head ("10.1.1.5");
+  Ipv4Address member ("10.1.1.9");
+  dmsrp::CountingBloomFilter filter (64, 3);
+  filter.Add (member);
+  std::vector<uint8_t> bits;
+  filter.GetBits (bits);
+
+  dmsrp::ClusterAdvertiseHeader h1 (head, 7, 2);
+  h1.SetSink (Ipv4Address ("10.1.1.1"));
+  h1.SetMembers (64, 3, bits);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::ClusterAdvertiseHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 24, "Summary of 64 cells");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+
+  dmsrp::HelloHeader hello;
+  hello.SetCluster (2.5, true);
+  p = Create<Packet> ();
+  p->AddHeader (hello);
+  dmsrp::HelloHeader hello2;
+  p->RemoveHeader (hello2);
+  NS_TEST_EXPECT_MSG_EQ (hello2.IsClusterHead (), true, "Cluster head flag");
+  NS_TEST_EXPECT_MSG_EQ (hello2.GetClusterScore (), 2.5, "Cluster score");
+
+  dmsrp::CountingBloomFilter members (h2.GetCellCount (), h2.GetHashCount ());
+  members.SetBits (h2.GetMembers ());
+  dmsrp::ClusterTable clusters;
+  dmsrp::RoutingTableEntryDown toHead (0, head, 7, Ipv4InterfaceAddress (), 3, Ipv4Address ("10.1.1.4"), Seconds (10));
+  NS_TEST_EXPECT_MSG_EQ (clusters.Update (head, 7, members, toHead, Seconds (10)), true, "New cluster");
+  NS_TEST_EXPECT_MSG_EQ (clusters.Update (head, 6, members, toHead, Seconds (10)), false, "Older summary");
+  NS_TEST_EXPECT_MSG_EQ (clusters.GetClusterCount (), 1, "One cluster");
+
+  dmsrp::RoutingTableEntryDown rt;
+  NS_TEST_EXPECT_MSG_EQ (clusters.Lookup (member, rt), true, "Member of the cluster");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetDestination (), member, "Route to the member");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), Ipv4Address ("10.1.1.4"), "Through the way to the head");
+  NS_TEST_EXPECT_MSG_EQ (clusters.Lookup (head, rt), true, "Head of the cluster");
+}
+
+class DmsrpAggregatorTestCase : public TestCase
+{
+public:
+  DmsrpAggregatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpAggregatorTestCase::DmsrpAggregatorTestCase ()
+  : TestCase ("Dmsrp uplink containers")
+{
+}
+
+void
+DmsrpAggregatorTestCase::DoRun (void)
+{
+  std::vector<dmsrp::Aggregator::Item> items;
+  for (uint32_t n = 0; n < 3; ++n)
+    {
+      dmsrp::Aggregator::Item item;
+      item.m_packet = Create<Packet> (64 + n);
+      item.m_header.SetSource (Ipv4Address (Ipv4Address ("10.1.1.10").Get () + n));
+      item.m_header.SetDestination (Ipv4Address ("41.110.0.1"));
+      item.m_header.SetProtocol (17);
+      item.m_header.SetTtl (64);
+      item.m_header.SetPayloadSize (64 + n);
+      items.push_back (item);
+    }
+  Ptr<Packet> container = dmsrp::Aggregator::Pack (items);
+  NS_TEST_EXPECT_MSG_EQ (container->GetSize (), 1 + 4 + 3 * 20 + 64 + 65 + 66, "Container size");
+
+  std::vector<dmsrp::Aggregator::Item> unpacked;
+  NS_TEST_EXPECT_MSG_EQ (dmsrp::Aggregator::Unpack (container, 64, unpacked), true, "Well formed container");
+  NS_TEST_EXPECT_MSG_EQ (unpacked.size (), 3, "Three packets");
+  for (uint32_t n = 0; n < unpacked.size (); ++n)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unpacked[n].m_header.GetSource (), items[n].m_header.GetSource (), "Origin kept");
+      NS_TEST_EXPECT_MSG_EQ (unpacked[n].m_header.GetDestination (), Ipv4Address ("41.110.0.1"), "Destination kept");
+      NS_TEST_EXPECT_MSG_EQ (unpacked[n].m_packet->GetSize (), 64 + n, "Payload kept");
+    }
+
+  Ptr<Packet> truncated = container->CreateFragment (0, container->GetSize () - 1);
+  unpacked.clear ();
+  NS_TEST_EXPECT_MSG_EQ (dmsrp::Aggregator::Unpack (truncated, 64, unpacked), false, "Truncated container");
+}
+
+// Check that the packets batched again at every hop of a loop still die
+class DmsrpAggregatorLoopTestCase : public TestCase
+{
+public:
+  DmsrpAggregatorLoopTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Forward callback of the aggregator
+   * \param route the route
+   * \param packet the container
+   * \param header its IP header
+   */
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet> packet, const Ipv4Header & header);
+  Ptr<const Packet> m_container;    ///< last container sent
+  Ipv4Header m_header;              ///< its IP header
+};
+
+DmsrpAggregatorLoopTestCase::DmsrpAggregatorLoopTestCase ()
+  : TestCase ("Dmsrp containers in a routing loop")
+{
+}
+
+void
+DmsrpAggregatorLoopTestCase::Forward (Ptr<Ipv4Route>, Ptr<const Packet> packet, const Ipv4Header & header)
+{
+  m_container = packet;
+  m_header = header;
+}
+
+void
+DmsrpAggregatorLoopTestCase::DoRun (void)
+{
+  dmsrp::Aggregator aggregator;
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetSource (Ipv4Address ("10.1.1.1"));
+  route->SetGateway (Ipv4Address ("10.1.1.2"));
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeCallback (&DmsrpAggregatorLoopTestCase::Forward, this);
+  std::vector<dmsrp::Aggregator::Item> items (2);
+  for (std::vector<dmsrp::Aggregator::Item>::iterator i = items.begin (); i != items.end (); ++i)
+    {
+      i->m_packet = Create<Packet> (32);
+      i->m_header.SetDestination (Ipv4Address ("41.110.0.1"));
+    }
+  items[0].m_header.SetTtl (64);
+  items[1].m_header.SetTtl (3);
+  uint32_t hops = 0;
+  while (true)
+    {
+      for (std::vector<dmsrp::Aggregator::Item>::iterator i = items.begin (); i != items.end (); ++i)
+        {
+          aggregator.Enqueue (route, i->m_packet, i->m_header, ucb);
+        }
+      aggregator.Flush ();
+      NS_TEST_ASSERT_MSG_NE (m_container, 0, "Container sent");
+      // the IP layer of the sender drops the container when its TTL runs out
+      if (m_header.GetTtl () <= 1 || hops > 64)
+        {
+          break;
+        }
+      Ipv4Header header = m_header;
+      header.SetTtl (header.GetTtl () - 1);
+      items.clear ();
+      NS_TEST_EXPECT_MSG_EQ (dmsrp::Aggregator::Unpack (m_container, header.GetTtl (), items), true, "Well formed container");
+      NS_TEST_EXPECT_MSG_EQ ((uint16_t) items[0].m_header.GetTtl (), (uint16_t) header.GetTtl (), "The hops of the container count");
+      m_container = 0;
+      hops++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (hops, 2, "The container dies with its packet of lowest TTL");
+  Simulator::Destroy ();
+}
+
+class DmsrpCompositeModeTestCase : public TestCase
+{
+public:
+  DmsrpCompositeModeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpCompositeModeTestCase::DmsrpCompositeModeTestCase ()
+  : TestCase ("Dmsrp composite parent selection")
+{
+}
+
+void
+DmsrpCompositeModeTestCase::DoRun (void)
+{
+  Ipv4Address sink ("10.1.1.1");
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::COMPOSITE_MODE);
+  table.SetMetricWeights (1, 0, 0, 0);
+  table.SetParentHysteresis (0.1);
+
+  dmsrp::RoutingTableEntryUp toA (0, sink, 1, Ipv4InterfaceAddress (), 2, a, Seconds (10), 5, 10);
+  dmsrp::RoutingTableEntryUp toB (0, sink, 1, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 10.5);
+  table.AddRoute (toA);
+  table.AddRoute (toB);
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Best SNR");
+
+  toA.SetMinSnr (11);
+  table.AddRoute (toA);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Candidate within the hysteresis margin");
+
+  toA.SetMinSnr (12);
+  table.AddRoute (toA);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), a, "Clearly better candidate");
+
+  // fewer hops outweigh a slightly better SNR
+  table.SetMetricWeights (0.5, 0, 0.5, 0);
+  toB.SetHop (1);
+  toB.SetMinSnr (11);
+  table.AddRoute (toB);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Closer parent");
+}
+
+class DmsrpLinkQualityTestCase : public TestCase
+{
+public:
+  DmsrpLinkQualityTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpLinkQualityTestCase::DmsrpLinkQualityTestCase ()
+  : TestCase ("Dmsrp link estimation")
+{
+}
+
+void
+DmsrpLinkQualityTestCase::DoRun (void)
+{
+  Ipv4Address neighbor ("10.1.1.2");
+  Ipv4Address self ("10.1.1.3");
+  dmsrp::Neighbors nb;
+  nb.SetLinkWindow (8);
+  nb.Update (neighbor, Seconds (10));
+  NS_TEST_EXPECT_MSG_EQ (nb.GetEtx (neighbor), 255, "No Hello counted yet");
+  nb.NotifyHello (neighbor, 1, Seconds (10));
+  nb.NotifyHello (neighbor, 2, Seconds (10));
+  nb.NotifyHello (neighbor, 2, Seconds (10));
+  nb.NotifyHello (neighbor, 4, Seconds (10));
+  nb.NotifyHello (neighbor, 5, Seconds (10));
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetEtx (neighbor), 1 / (0.8 * 0.8), 1e-6, "Symmetric link assumed");
+  nb.SetForwardReception (neighbor, 255);
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetEtx (neighbor), 1 / 0.8, 1e-6, "Both directions");
+  std::vector<std::pair<Ipv4Address, uint8_t> > receptions;
+  nb.GetReceptions (receptions);
+  NS_TEST_EXPECT_MSG_EQ (receptions.size (), 1, "One neighbor heard");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) receptions[0].second, 204, "Four Hellos out of five");
+
+  // the first Hello of an unknown neighbor opens the link and is counted
+  Ipv4Address newcomer ("10.1.1.4");
+  nb.NotifyHello (newcomer, 9, Seconds (10));
+  nb.SetForwardReception (newcomer, 255);
+  NS_TEST_EXPECT_MSG_EQ (nb.IsNeighbor (newcomer), true, "Neighbor added by its Hello");
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetEtx (newcomer), 1, 1e-6, "First Hello and its report counted");
+
+  dmsrp::HelloHeader h1 (1, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetLinkQuality (7, 2.5);
+  h1.AddLinkRecord (self, 128);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 8 + 5, "Hello with one link record");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  uint8_t reception = 0;
+  NS_TEST_EXPECT_MSG_EQ (h2.GetLinkRecord (self, reception), true, "Link record found");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) reception, 128, "Reception kept");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetLinkRecord (neighbor, reception), false, "No record for an unknown neighbor");
+}
+
+class DmsrpAirtimeTestCase : public TestCase
+{
+public:
+  DmsrpAirtimeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpAirtimeTestCase::DmsrpAirtimeTestCase ()
+  : TestCase ("Dmsrp airtime routing mode")
+{
+}
+
+void
+DmsrpAirtimeTestCase::DoRun (void)
+{
+  dmsrp::HelloHeader h1 (2, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetPathAirtime (850.5);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 4, "Hello with the path airtime");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetPathAirtime (), 850.5, "Path airtime kept");
+
+  // a slow direct link loses to two fast hops
+  Ipv4Address sink ("10.1.1.1");
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::AIRTIME_MODE);
+  dmsrp::RoutingTableEntryUp toA (0, sink, 1, Ipv4InterfaceAddress (), 1, a, Seconds (10), 5, 10);
+  toA.SetPathAirtime (8267);
+  dmsrp::RoutingTableEntryUp toB (0, sink, 1, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 10);
+  toB.SetPathAirtime (2 * 350);
+  table.AddRoute (toA);
+  table.AddRoute (toB);
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Least airtime");
+}
+
+class DmsrpChannelLoadTestCase : public TestCase
+{
+public:
+  DmsrpChannelLoadTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpChannelLoadTestCase::DmsrpChannelLoadTestCase ()
+  : TestCase ("Dmsrp channel load")
+{
+}
+
+void
+DmsrpChannelLoadTestCase::DoRun (void)
+{
+  dmsrp::ChannelLoad load;
+  load.SetSmoothing (0.5);
+  load.NotifyState (Seconds (0.2), Seconds (0.3), RX);
+  load.NotifyState (Seconds (0.6), Seconds (0.1), CCA_BUSY);
+  load.NotifyState (Seconds (0.7), Seconds (0.2), IDLE);
+  Simulator::Schedule (Seconds (1), &dmsrp::ChannelLoad::Sample, &load);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (load.GetLoad (), 0.4, 1e-9, "First sample taken as is");
+
+  // a transmission across the sample boundary only counts after it
+  Simulator::Schedule (Seconds (0.5), &dmsrp::ChannelLoad::NotifyState, &load, Seconds (0.9), Seconds (0.5), TX);
+  Simulator::Schedule (Seconds (1), &dmsrp::ChannelLoad::NotifyState, &load, Seconds (1.5), Seconds (0.5), RX);
+  Simulator::Schedule (Seconds (1), &dmsrp::ChannelLoad::Sample, &load);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (load.GetLoad (), 0.5 * 0.9 + 0.5 * 0.4, 1e-9, "Smoothed load");
+  Simulator::Destroy ();
+
+  dmsrp::HelloHeader h1 (1, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetChannelLoad (200);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 4, "Hello with the channel load");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+
+  // the closer parent loses in a busy neighborhood
+  Ipv4Address sink ("10.1.1.1");
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::CHANNEL_LOAD_MODE);
+  dmsrp::RoutingTableEntryUp toA (0, sink, 1, Ipv4InterfaceAddress (), 2, a, Seconds (10), 5, 10);
+  toA.SetChannelLoad (0.7);
+  dmsrp::RoutingTableEntryUp toB (0, sink, 1, Ipv4InterfaceAddress (), 3, b, Seconds (10), 5, 10);
+  toB.SetChannelLoad (0.2);
+  table.AddRoute (toA);
+  table.AddRoute (toB);
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Quieter parent");
+}
+
+class DmsrpLinkLifetimeTestCase : public TestCase
+{
+public:
+  DmsrpLinkLifetimeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpLinkLifetimeTestCase::DmsrpLinkLifetimeTestCase ()
+  : TestCase ("Dmsrp link lifetime prediction")
+{
+}
+
+void
+DmsrpLinkLifetimeTestCase::DoRun (void)
+{
+  Time lifetime = dmsrp::Neighbors::PredictLinkLifetime (Vector (0, 0, 0), Vector (10, 0, 0), Vector (0, 0, 0), Vector (0, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ_TOL (lifetime.GetSeconds (), 10, 1e-9, "Leaving a still node");
+  lifetime = dmsrp::Neighbors::PredictLinkLifetime (Vector (0, 0, 0), Vector (5, 0, 0), Vector (50, 0, 0), Vector (-5, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ_TOL (lifetime.GetSeconds (), 15, 1e-9, "Crossing nodes");
+  lifetime = dmsrp::Neighbors::PredictLinkLifetime (Vector (0, 0, 0), Vector (5, 5, 0), Vector (50, 0, 0), Vector (5, 5, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ (lifetime, Simulator::GetMaximumSimulationTime (), "Same velocity");
+  lifetime = dmsrp::Neighbors::PredictLinkLifetime (Vector (0, 0, 0), Vector (0, 0, 0), Vector (150, 0, 0), Vector (0, 0, 0), 100);
+  NS_TEST_EXPECT_MSG_EQ (lifetime, Seconds (0), "Out of range");
+
+  dmsrp::HelloHeader h1 (1, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetMobility (Vector (120.5, 80.25, 1.5), Vector (-3, 4, 0));
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 16, "Hello with the position and velocity");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetPosition ().y, 80.25, "Position kept");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetVelocity ().x, -3, "Velocity kept");
+
+  Ipv4Address sink ("10.1.1.1");
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::LINK_LIFETIME_MODE);
+  table.SetLinkLifetimeHorizon (Seconds (6));
+  dmsrp::RoutingTableEntryUp toA (0, sink, 1, Ipv4InterfaceAddress (), 1, a, Seconds (10), 5, 20);
+  toA.SetLinkLifetime (Seconds (2));
+  dmsrp::RoutingTableEntryUp toB (0, sink, 1, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 10);
+  toB.SetLinkLifetime (Seconds (30));
+  table.AddRoute (toA);
+  table.AddRoute (toB);
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Longer lasting link");
+
+  toA.SetLinkLifetime (Seconds (8));
+  table.AddRoute (toA);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), a, "Both beyond the horizon: best SNR");
+}
+
+class DmsrpRouteTimeoutTestCase : public TestCase
+{
+public:
+  DmsrpRouteTimeoutTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpRouteTimeoutTestCase::DmsrpRouteTimeoutTestCase ()
+  : TestCase ("Dmsrp route timeout in SRVADVERTISE")
+{
+}
+
+void
+DmsrpRouteTimeoutTestCase::DoRun (void)
+{
+  dmsrp::SrvAdvertiseHeader h1 (2, 0, Ipv4Address ("10.1.1.5"), Ipv4Address ("10.1.1.1"), 7);
+  NS_TEST_EXPECT_MSG_EQ (h1.GetRouteTimeout (), Seconds (0), "No timeout given");
+  h1.SetRouteTimeout (MilliSeconds (2340));
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::SrvAdvertiseHeader h2;
+  p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetRouteTimeout (), MilliSeconds (2400), "Rounded up to a tenth of a second");
+  h1.SetRouteTimeout (Seconds (40));
+  NS_TEST_EXPECT_MSG_EQ (h1.GetRouteTimeout (), MilliSeconds (25500), "Capped");
+}
+
+class DmsrpBackupParentTestCase : public TestCase
+{
+public:
+  DmsrpBackupParentTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Record an uplink outage
+   * \param outage the outage duration
+   */
+  void Outage (Time outage);
+  uint32_t m_outages;  ///< number of outages
+};
+
+DmsrpBackupParentTestCase::DmsrpBackupParentTestCase ()
+  : TestCase ("Dmsrp backup parent promotion"),
+    m_outages (0)
+{
+}
+
+void
+DmsrpBackupParentTestCase::Outage (Time outage)
+{
+  m_outages++;
+  NS_TEST_EXPECT_MSG_EQ (outage, Seconds (0), "Backup at hand");
+}
+
+void
+DmsrpBackupParentTestCase::DoRun (void)
+{
+  Ipv4Address sink ("10.1.1.1");
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  Ipv4Address c ("10.1.1.4");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::BASIC_MODE);
+  table.SetBackupParent (true);
+  table.SetOutageCallback (MakeCallback (&DmsrpBackupParentTestCase::Outage, this));
+  dmsrp::RoutingTableEntryUp toA (0, sink, 5, Ipv4InterfaceAddress (), 2, a, Seconds (10), 5, 20);
+  dmsrp::RoutingTableEntryUp toB (0, sink, 5, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 20);
+  dmsrp::RoutingTableEntryUp toC (0, sink, 5, Ipv4InterfaceAddress (), 4, c, Seconds (10), 5, 20);
+  table.AddRoute (toC);
+  table.AddRoute (toA);
+  table.AddRoute (toB);
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Last route in the basic mode");
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBackupRoute (rt), true, "Backup kept across the basic mode wipe");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), a, "Neighbor further from the sink rejected");
+
+  table.DeleteRoute (b);
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Backup promoted");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), a, "Backup parent");
+  NS_TEST_EXPECT_MSG_EQ (m_outages, 1, "Parent loss reported");
+
+  dmsrp::RoutingTableEntryUp fresh (0, sink, 7, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 20);
+  table.AddRoute (fresh);
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBackupRoute (rt), false, "Route two sequence numbers behind rejected");
+}
+
+class DmsrpTxPowerTestCase : public TestCase
+{
+public:
+  DmsrpTxPowerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpTxPowerTestCase::DmsrpTxPowerTestCase ()
+  : TestCase ("Dmsrp transmit power control")
+{
+}
+
+void
+DmsrpTxPowerTestCase::DoRun (void)
+{
+  dmsrp::HelloHeader h1 (1, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetTxPower (4.5);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 4, "Hello with the transmit power");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetTxPower (), 4.5, "Transmit power kept");
+
+  Ipv4Address neighbor ("10.1.1.2");
+  dmsrp::Neighbors nb;
+  nb.Update (neighbor, Seconds (10));
+  double txPower;
+  NS_TEST_EXPECT_MSG_EQ (nb.GetRequiredTxPower (neighbor, 13, txPower), false, "Transmit power not advertised");
+  nb.SetTxPower (neighbor, 7.5, 25);
+  NS_TEST_EXPECT_MSG_EQ (nb.GetRequiredTxPower (neighbor, 13, txPower), true, "Transmit power advertised");
+  NS_TEST_EXPECT_MSG_EQ_TOL (txPower, -4.5, 1e-9, "SNR margin of 12 dB saved");
+}
+
+class DmsrpPathLifetimeTestCase : public TestCase
+{
+public:
+  DmsrpPathLifetimeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpPathLifetimeTestCase::DmsrpPathLifetimeTestCase ()
+  : TestCase ("Dmsrp path lifetime mode")
+{
+}
+
+void
+DmsrpPathLifetimeTestCase::DoRun (void)
+{
+  dmsrp::EnergyMonitor monitor;
+  monitor.Sample ();
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetRemainingEnergy (), 0, "No energy source");
+  NS_TEST_EXPECT_MSG_EQ (monitor.GetLifetime (), Simulator::GetMaximumSimulationTime (), "Nothing drained");
+
+  dmsrp::HelloHeader h1 (1, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetPathLifetime (3600);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 4, "Hello with the path lifetime");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetPathLifetime (), 3600, "Path lifetime kept");
+
+  Ipv4Address sink ("10.1.1.1");
+  Ipv4Address a ("10.1.1.2");
+  Ipv4Address b ("10.1.1.3");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::PATH_LIFETIME_MODE);
+  dmsrp::RoutingTableEntryUp toA (0, sink, 1, Ipv4InterfaceAddress (), 1, a, Seconds (10), 5, 20);
+  toA.SetPathLifetime (600);
+  dmsrp::RoutingTableEntryUp toB (0, sink, 1, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 10);
+  toB.SetPathLifetime (3600);
+  table.AddRoute (toA);
+  table.AddRoute (toB);
+  dmsrp::RoutingTableEntryUp rt;
+  NS_TEST_EXPECT_MSG_EQ (table.LookupBestRoute (rt), true, "Route found");
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), b, "Longest lasting path");
+
+  toA.SetPathLifetime (3600);
+  table.AddRoute (toA);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), a, "Same lifetime: fewest hops");
+}
+
+class DmsrpSinkLoadTestCase : public TestCase
+{
+public:
+  DmsrpSinkLoadTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DmsrpSinkLoadTestCase::DmsrpSinkLoadTestCase ()
+  : TestCase ("Dmsrp sink load balancing")
+{
+}
+
+void
+DmsrpSinkLoadTestCase::DoRun (void)
+{
+  dmsrp::HelloHeader h1 (0, 0, 10, 20, Ipv4Address ("10.1.1.1"), 3);
+  h1.SetSinkLoad (42, 128);
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (h1);
+  dmsrp::HelloHeader h2;
+  uint32_t bytes = p->RemoveHeader (h2);
+  NS_TEST_EXPECT_MSG_EQ (bytes, 19 + 4, "Hello with the sink load");
+  NS_TEST_EXPECT_MSG_EQ (h1, h2, "Round trip serialization");
+  NS_TEST_EXPECT_MSG_EQ (h2.GetSubtreeSize (), 42, "Subtree size kept");
+  NS_TEST_EXPECT_MSG_EQ ((uint16_t) h2.GetUplinkLoad (), 128, "Uplink load kept");
+
+  Ipv4Address sink1 ("10.1.1.1");
+  Ipv4Address sink2 ("10.1.1.2");
+  Ipv4Address a ("10.1.1.3");
+  Ipv4Address b ("10.1.1.4");
+  dmsrp::RoutingTableUp table;
+  table.SetRoutingMode (dmsrp::SNR_AWARE_MULTI_PARENT_MODE);
+  table.SetSinkLoadBalancing (true, 0.2);
+  dmsrp::RoutingTableEntryUp toSink1 (0, sink1, 1, Ipv4InterfaceAddress (), 1, a, Seconds (10), 5, 20);
+  dmsrp::RoutingTableEntryUp toSink2 (0, sink2, 1, Ipv4InterfaceAddress (), 2, b, Seconds (10), 5, 10);
+  table.AddRoute (toSink1);
+  table.AddSinkRoute (toSink2);
+  dmsrp::RoutingTableEntryUp rt;
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetNextHop (), a, "No load known: best route");
+
+  table.SetSinkLoad (sink1, 1, 20, 0);
+  table.SetSinkLoad (sink2, 1, 5, 0);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetDestination (), sink2, "Least loaded sink");
+
+  table.SetSinkLoad (sink1, 2, 18, 0);
+  table.SetSinkLoad (sink2, 2, 20, 0);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetDestination (), sink2, "Within the hysteresis: current sink kept");
+
+  table.SetSinkLoad (sink1, 3, 10, 0);
+  table.SetSinkLoad (sink2, 1, 2, 0);
+  table.LookupBestRoute (rt);
+  NS_TEST_EXPECT_MSG_EQ (rt.GetDestination (), sink1, "Stale load ignored, less loaded sink taken");
+}
+
+// Check which advertises a sink forwards to the server
+class DmsrpAdvertiseFilterTestCase : public TestCase
+{
+public:
+  DmsrpAdvertiseFilterTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// The sink hears an advertise
+  void Hear (uint8_t hops, uint32_t seqNo, uint8_t links);
+  /// An advertise is suppressed
+  void Suppressed (Ipv4Address origin, uint32_t seqNo);
+  dmsrp::AdvertiseFilter m_filter;  ///< the filter
+  uint32_t m_forwarded;             ///< advertises forwarded
+  uint32_t m_suppressed;            ///< advertises suppressed
+};
+
+DmsrpAdvertiseFilterTestCase::DmsrpAdvertiseFilterTestCase ()
+  : TestCase ("Dmsrp sink advertise suppression"),
+    m_forwarded (0),
+    m_suppressed (0)
+{
+}
+
+void
+DmsrpAdvertiseFilterTestCase::Hear (uint8_t hops, uint32_t seqNo, uint8_t links)
+{
+  dmsrp::AdvertiseHeader advertise (hops, 0, Ipv4Address ("10.1.0.7"), seqNo);
+  dmsrp::TopologyReport report;
+  // the energy changes in every report
+  report.SetEnergy (100 - seqNo);
+  for (uint8_t i = 0; i < links; ++i)
+    {
+      report.AddLink (Ipv4Address (0x0a010100 + i), 20);
+    }
+  advertise.SetReport (report);
+  if (m_filter.IsNeeded (advertise))
+    {
+      m_forwarded++;
+    }
+}
+
+void
+DmsrpAdvertiseFilterTestCase::Suppressed (Ipv4Address origin, uint32_t seqNo)
+{
+  NS_TEST_EXPECT_MSG_EQ (origin, Ipv4Address ("10.1.0.7"), "Origin of the suppressed advertise");
+  NS_TEST_EXPECT_MSG_GT (seqNo, 0, "Sequence number of the suppressed advertise");
+  m_suppressed++;
+}
+
+void
+DmsrpAdvertiseFilterTestCase::DoRun (void)
+{
+  m_filter.SetRefresh (Seconds (10));
+  m_filter.SetSuppressCallback (MakeCallback (&DmsrpAdvertiseFilterTestCase::Suppressed, this));
+  // the same advertise over two paths
+  Simulator::Schedule (Seconds (1), &DmsrpAdvertiseFilterTestCase::Hear, this, 2, 1, 1);
+  Simulator::Schedule (Seconds (1.01), &DmsrpAdvertiseFilterTestCase::Hear, this, 3, 1, 1);
+  // same hops and same links inside the refresh period
+  Simulator::Schedule (Seconds (4), &DmsrpAdvertiseFilterTestCase::Hear, this, 2, 2, 1);
+  // a new parent in the report
+  Simulator::Schedule (Seconds (7), &DmsrpAdvertiseFilterTestCase::Hear, this, 2, 3, 2);
+  // unchanged, then due for refresh
+  Simulator::Schedule (Seconds (10), &DmsrpAdvertiseFilterTestCase::Hear, this, 2, 4, 2);
+  Simulator::Schedule (Seconds (18), &DmsrpAdvertiseFilterTestCase::Hear, this, 2, 5, 2);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded, 3, "First copy, changed report and refresh forwarded");
+  NS_TEST_EXPECT_MSG_EQ (m_suppressed, 3, "Second path and unchanged advertises suppressed");
+  NS_TEST_EXPECT_MSG_EQ (m_filter.GetSize (), 1, "One origin known");
+  m_filter.Forget (Ipv4Address ("10.1.0.7"));
+  NS_TEST_EXPECT_MSG_EQ (m_filter.GetSize (), 0, "Origin forgotten");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +1456,31 @@ DmsrpTestSuite::DmsrpTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new DmsrpTestCase1, TestCase::QUICK);
+  AddTestCase (new DmsrpRerrHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpPiggybackHeaderTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpMultiSinkHelloTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpServerSinkSelectionTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpServerSinkFailureTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpTopologyTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpSourceRouteTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpBloomFilterTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpSinkQueueTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpSinkQueueCodelTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpServerSetTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpClusterTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpAggregatorTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpAggregatorLoopTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpCompositeModeTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpLinkQualityTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpAirtimeTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpChannelLoadTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpLinkLifetimeTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpRouteTimeoutTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpBackupParentTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpTxPowerTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpPathLifetimeTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpSinkLoadTestCase, TestCase::QUICK);
+  AddTestCase (new DmsrpAdvertiseFilterTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite